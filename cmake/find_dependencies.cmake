@@ -19,4 +19,7 @@ include_directories(${Boost_INCLUDE_DIRS})
 
 find_package(Vulkan 1.3 REQUIRED)
 
-include_directories(${Vulkan_INCLUDE_DIRS})
\ No newline at end of file
+include_directories(${Vulkan_INCLUDE_DIRS})
+
+# Worker threads for parallel command recording
+find_package(Threads REQUIRED)
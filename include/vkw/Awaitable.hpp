@@ -0,0 +1,85 @@
+#ifndef VKWRAPPER_AWAITABLE_HPP
+#define VKWRAPPER_AWAITABLE_HPP
+
+#include <vkw/CompletionWatcher.hpp>
+
+#include <coroutine>
+#include <functional>
+
+namespace vkw {
+
+class ThreadPool;
+
+// Resumes suspended coroutine somewhere. Empty executor resumes it right on
+// the CompletionWatcher thread, which is only fine for short continuations.
+using Executor = std::function<void(std::coroutine_handle<>)>;
+
+// Executor resuming coroutines as ThreadPool tasks.
+Executor threadPoolExecutor(ThreadPool &threadPool) noexcept(
+    ExceptionsDisabled);
+
+/**
+ * @class GPUAwaitable
+ *
+ * @brief Base of awaitables that suspend a coroutine until GPU reaches some
+ * point.
+ *
+ * Suspended coroutines cost no thread: they are registered with a
+ * CompletionWatcher and handed to the executor once the watcher sees the
+ * completion. If the wait fails instead (most likely device loss), the
+ * coroutine is resumed as well and co_await reports the VulkanError. A
+ * coroutine still suspended when the watcher is destroyed is resumed by the
+ * destructor and co_await reports an Error.
+ */
+class GPUAwaitable {
+public:
+  void await_resume() const noexcept(ExceptionsDisabled);
+
+protected:
+  GPUAwaitable(CompletionWatcher &watcher, Executor executor) noexcept
+      : m_watcher(watcher), m_executor(std::move(executor)) {}
+
+  CompletionWatcher::Callback
+  m_resumeCallback(std::coroutine_handle<> handle) noexcept(
+      ExceptionsDisabled);
+
+  std::reference_wrapper<CompletionWatcher> m_watcher;
+  Executor m_executor;
+  VkResult m_result = VK_SUCCESS;
+};
+
+class FenceAwaitable : public GPUAwaitable {
+public:
+  FenceAwaitable(CompletionWatcher &watcher, Fence const &fence,
+                 Executor executor = {}) noexcept
+      : GPUAwaitable(watcher, std::move(executor)), m_fence(fence) {}
+
+  bool await_ready() const noexcept(ExceptionsDisabled);
+
+  void await_suspend(std::coroutine_handle<> handle) noexcept(
+      ExceptionsDisabled);
+
+private:
+  std::reference_wrapper<Fence const> m_fence;
+};
+
+class TimelineAwaitable : public GPUAwaitable {
+public:
+  TimelineAwaitable(CompletionWatcher &watcher,
+                    TimelineSemaphore const &semaphore, uint64_t value,
+                    Executor executor = {}) noexcept
+      : GPUAwaitable(watcher, std::move(executor)), m_semaphore(semaphore),
+        m_value(value) {}
+
+  bool await_ready() const noexcept(ExceptionsDisabled);
+
+  void await_suspend(std::coroutine_handle<> handle) noexcept(
+      ExceptionsDisabled);
+
+private:
+  std::reference_wrapper<TimelineSemaphore const> m_semaphore;
+  uint64_t m_value;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_AWAITABLE_HPP
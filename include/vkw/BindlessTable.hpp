@@ -0,0 +1,153 @@
+#ifndef VKWRAPPER_BINDLESSTABLE_HPP
+#define VKWRAPPER_BINDLESSTABLE_HPP
+
+#include <vkw/DescriptorSet.hpp>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace vkw {
+
+class TimelineSemaphore;
+
+/**
+ * @class BindlessTable
+ *
+ * @brief One global descriptor set holding every sampled image, sampler and
+ * storage buffer of the application, addressed from shaders by index.
+ *
+ * The set has three partially bound, update-after-bind arrays:
+ *
+ *    layout(set = N, binding = 0) uniform texture2D images[];
+ *    layout(set = N, binding = 1) uniform sampler samplers[];
+ *    layout(set = N, binding = 2) buffer Buffers { ... } buffers[];
+ *
+ * add() writes the resource into a free slot and returns its index, which
+ * stays valid until the slot is removed. Indices are handed out by a
+ * lock-free free list, so resources can be added and removed from any
+ * thread; only the descriptor write itself is serialized. The set is bound
+ * once per command buffer, indices are passed to shaders through push
+ * constants or instance data.
+ *
+ * Requires descriptorBindingPartiallyBound,
+ * descriptorBindingSampledImageUpdateAfterBind,
+ * descriptorBindingStorageBufferUpdateAfterBind and
+ * descriptorBindingUpdateUnusedWhilePending extended features to be enabled.
+ *
+ * Pending command buffers may still read a removed slot, so with deferral
+ * enabled in Device::deletionQueue() it is retired with the queue's current
+ * key and reused only after collect() is passed a completed key at least as
+ * large. With deferral disabled a removed slot is reused right away and the
+ * resource it referenced must not be used by pending command buffers anymore.
+ */
+class BindlessTable {
+public:
+  static constexpr uint32_t SampledImageBinding = 0;
+  static constexpr uint32_t SamplerBinding = 1;
+  static constexpr uint32_t StorageBufferBinding = 2;
+
+  struct Capacity {
+    uint32_t sampledImages = 16384;
+    uint32_t samplers = 256;
+    uint32_t storageBuffers = 16384;
+  };
+
+  BindlessTable(
+      Device const &device, Capacity capacity,
+      VkShaderStageFlags stages = VK_SHADER_STAGE_ALL) noexcept(
+      ExceptionsDisabled);
+
+  explicit BindlessTable(Device const &device) noexcept(ExceptionsDisabled)
+      : BindlessTable(device, Capacity{}) {}
+
+  BindlessTable(BindlessTable const &another) = delete;
+  BindlessTable &operator=(BindlessTable const &another) = delete;
+
+  uint32_t add(ImageViewBase const &image,
+               VkImageLayout layout =
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) noexcept(
+      ExceptionsDisabled);
+
+  uint32_t add(Sampler const &sampler) noexcept(ExceptionsDisabled);
+
+  uint32_t add(BufferBase const &buffer, VkDeviceSize offset = 0,
+               VkDeviceSize range = VK_WHOLE_SIZE) noexcept(ExceptionsDisabled);
+
+  void removeImage(uint32_t index) noexcept { m_retire(m_images, index); }
+
+  void removeSampler(uint32_t index) noexcept { m_retire(m_samplers, index); }
+
+  void removeBuffer(uint32_t index) noexcept { m_retire(m_buffers, index); }
+
+  // Returns slots retired with key <= completedKey to the free lists. Returns
+  // count of released slots.
+  size_t collect(uint64_t completedKey) noexcept;
+
+  size_t collect(TimelineSemaphore const &semaphore) noexcept(
+      ExceptionsDisabled);
+
+  DescriptorSetLayout const &layout() const noexcept { return m_layout; }
+
+  DescriptorSet const &set() const noexcept { return m_set; }
+
+  operator VkDescriptorSet() const noexcept { return m_set; }
+
+private:
+  // Treiber stack of released slots over never used ones. Head is tagged
+  // with a counter against ABA.
+  class IndexAllocator {
+  public:
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+    explicit IndexAllocator(uint32_t capacity) noexcept(ExceptionsDisabled);
+
+    uint32_t allocate() noexcept;
+
+    void free(uint32_t index) noexcept;
+
+    uint32_t capacity() const noexcept { return m_capacity; }
+
+  private:
+    static uint64_t m_pack(uint32_t index, uint32_t tag) noexcept {
+      return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+    std::atomic<uint64_t> m_head = m_pack(InvalidIndex, 0);
+    std::atomic<uint32_t> m_fresh = 0;
+    uint32_t m_capacity;
+  };
+
+  struct RetiredSlot {
+    uint64_t key;
+    IndexAllocator *indices;
+    uint32_t index;
+  };
+
+  uint32_t m_allocate(IndexAllocator &indices,
+                      char const *kind) noexcept(ExceptionsDisabled);
+
+  void m_retire(IndexAllocator &indices, uint32_t index) noexcept;
+
+  void m_write(VkWriteDescriptorSet const &write) noexcept;
+
+  StrongReference<Device const> m_device;
+  DescriptorSetLayout m_layout;
+  DescriptorPool m_pool;
+  DescriptorSet m_set;
+
+  IndexAllocator m_images;
+  IndexAllocator m_samplers;
+  IndexAllocator m_buffers;
+
+  std::mutex m_retiredMutex;
+  std::deque<RetiredSlot> m_retired;
+
+  // vkUpdateDescriptorSets requires external synchronization of the set
+  std::mutex m_writeMutex;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_BINDLESSTABLE_HPP
@@ -2,11 +2,17 @@
 #define VKRENDERER_COMMANDBUFFER_HPP
 
 #include <vkw/CommandPool.hpp>
+#include <vkw/DescriptorBuffer.hpp>
 #include <vkw/DescriptorSet.hpp>
+#include <vkw/DescriptorUpdateTemplate.hpp>
+#include <vkw/IndirectBuffer.hpp>
 #include <vkw/RenderPass.hpp>
+#include <vkw/ResourceTracker.hpp>
 #include <vkw/VertexBuffer.hpp>
 
 #include <boost/container/small_vector.hpp>
+#include <array>
+#include <memory>
 #include <optional>
 
 namespace vkw {
@@ -20,7 +26,12 @@ class CommandBuffer : public ReferenceGuard {
 public:
   CommandBuffer(CommandBuffer &&another) noexcept
       : m_device(another.m_device), m_pool(another.m_pool),
-        m_executable(another.m_executable), m_recording(another.m_recording) {
+        m_insideRenderPass(another.m_insideRenderPass),
+        m_executable(another.m_executable), m_recording(another.m_recording),
+        m_tracker(std::move(another.m_tracker)),
+        m_barrierBatch(std::move(another.m_barrierBatch)),
+        m_bindState(std::move(another.m_bindState)),
+        m_skippedBinds(another.m_skippedBinds) {
     another.m_commandBuffer = VK_NULL_HANDLE;
   };
 
@@ -30,6 +41,11 @@ public:
     m_executable = another.m_executable;
     m_recording = another.m_recording;
     std::swap(m_commandBuffer, another.m_commandBuffer);
+    std::swap(m_tracker, another.m_tracker);
+    std::swap(m_barrierBatch, another.m_barrierBatch);
+    std::swap(m_bindState, another.m_bindState);
+    m_insideRenderPass = another.m_insideRenderPass;
+    std::swap(m_skippedBinds, another.m_skippedBinds);
     return *this;
   }
 
@@ -45,22 +61,30 @@ public:
 
   /** Transfer */
 
-  void copyBufferToBuffer(BufferBase const &src, BufferBase const &dst,
-                          std::span<const VkBufferCopy> regions) noexcept;
-  void copyBufferToImage(BufferBase const &src, AllocatedImage const &dst,
-                         VkImageLayout layout,
-                         std::span<const VkBufferImageCopy> regions) noexcept;
-  void copyImageToBuffer(AllocatedImage const &src, VkImageLayout layout,
-                         BufferBase const &dst,
-                         std::span<VkBufferImageCopy> regions) noexcept;
-
-  void copyImageToImage(AllocatedImage const &src, VkImageLayout srcLayout,
-                        AllocatedImage const &dst, VkImageLayout dstLayout,
-                        std::span<const VkImageCopy> regions) noexcept;
-
-  void blitImage(AllocatedImage const &targetImage, VkImageBlit blit,
-                 bool usingGeneralLayout = false,
-                 VkFilter filter = VK_FILTER_LINEAR) noexcept;
+  void copyBufferToBuffer(
+      BufferBase const &src, BufferBase const &dst,
+      std::span<const VkBufferCopy> regions) noexcept(ExceptionsDisabled);
+  // Fills range of the buffer with repeated 4-byte data. Offset and size must
+  // be multiples of 4.
+  void fillBuffer(BufferBase const &dst, uint32_t data, VkDeviceSize offset = 0,
+                  VkDeviceSize size = VK_WHOLE_SIZE) noexcept(
+      ExceptionsDisabled);
+  void copyBufferToImage(
+      BufferBase const &src, AllocatedImage const &dst, VkImageLayout layout,
+      std::span<const VkBufferImageCopy> regions) noexcept(ExceptionsDisabled);
+  void copyImageToBuffer(
+      AllocatedImage const &src, VkImageLayout layout, BufferBase const &dst,
+      std::span<VkBufferImageCopy> regions) noexcept(ExceptionsDisabled);
+
+  void copyImageToImage(
+      AllocatedImage const &src, VkImageLayout srcLayout,
+      AllocatedImage const &dst, VkImageLayout dstLayout,
+      std::span<const VkImageCopy> regions) noexcept(ExceptionsDisabled);
+
+  void blitImage(
+      AllocatedImage const &targetImage, VkImageBlit blit,
+      bool usingGeneralLayout = false,
+      VkFilter filter = VK_FILTER_LINEAR) noexcept(ExceptionsDisabled);
 
   /** Synchronization */
   void
@@ -90,17 +114,144 @@ public:
     pipelineBarrier(srcStage, dstStage, memBarriers, {}, {}, flags);
   }
 
+  // When batching is enabled, pipelineBarrier() and its shorthands only
+  // accumulate barriers. They are recorded as a single vkCmdPipelineBarrier
+  // with merged stage masks right before the next draw, dispatch, copy,
+  // blit, render pass command, executeCommands() or end(). Barriers for
+  // subresources or buffer ranges that are already batched, or with
+  // different dependency flags, flush the batch first to preserve order.
+  void enableBarrierBatching(bool enable = true) noexcept;
+
+  bool barrierBatchingEnabled() const noexcept {
+    return m_barrierBatch != nullptr;
+  }
+
+  // Records batched and tracked barriers immediately.
+  void flushBarriers() noexcept;
+
+  // Synchronization2 barriers carry their own stage masks. Requires
+  // PhysicalDevice::extended_feature::synchronization2 to be enabled.
+  void pipelineBarrier2(VkDependencyInfo const &dependencyInfo) noexcept(
+      ExceptionsDisabled);
+
+  void pipelineBarrier2(
+      std::span<const VkMemoryBarrier2> memBarriers,
+      std::span<const VkImageMemoryBarrier2> imageMemoryBarrier,
+      std::span<const VkBufferMemoryBarrier2> bufferMemoryBarrier,
+      VkDependencyFlags flags = 0) noexcept(ExceptionsDisabled);
+
+  /** Resource tracking */
+
+  // When tracking is enabled, the command buffer records the last access of
+  // every resource used by transfer commands and vertex/index buffer binds and
+  // inserts the minimal set of barriers before the next conflicting command.
+  // Resources accessed from shaders through descriptors must be declared with
+  // useBuffer()/useImage() before the draw or dispatch that accesses them.
+  // Barriers can't be recorded inside a render pass instance, so resources
+  // used there must be declared before beginRenderPass(): a use inside the
+  // pass that would need a barrier is an error. Images are assumed to be in
+  // the layout of their first use, declare others with assumeImageLayout().
+  // Tracking state is reset on every begin().
+  void enableResourceTracking(bool enable = true) noexcept(ExceptionsDisabled);
+
+  bool resourceTrackingEnabled() const noexcept { return m_tracker != nullptr; }
+
+  void useBuffer(BufferBase const &buffer, VkPipelineStageFlags stage,
+                 VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+  void useImage(ImageInterface const &image, VkImageSubresourceRange range,
+                VkImageLayout layout, VkPipelineStageFlags stage,
+                VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+  void useImage(ImageInterface const &image, VkImageLayout layout,
+                VkPipelineStageFlags stage,
+                VkAccessFlags access) noexcept(ExceptionsDisabled) {
+    useImage(image, image.completeSubresourceRange(), layout, stage, access);
+  }
+
+  // Images transitioned outside of tracked commands (e.g. by render pass
+  // final layouts) or used for the first time in a layout other than their
+  // current one must be declared here to keep tracked layouts correct.
+  void assumeImageLayout(ImageInterface const &image,
+                         VkImageLayout layout) noexcept(ExceptionsDisabled);
+
   /** Binding operations */
 
+  // Counters of binds and dynamic state sets dropped by bind elision.
+  struct SkippedBinds {
+    uint64_t pipelines = 0;
+    uint64_t descriptorSets = 0;
+    uint64_t vertexBuffers = 0;
+    uint64_t indexBuffers = 0;
+    uint64_t viewports = 0;
+    uint64_t scissors = 0;
+  };
+
+  // When bind elision is enabled, the command buffer shadows bound pipelines,
+  // descriptor sets, vertex and index buffers, viewports and scissors, and
+  // drops binds that don't change the current state. Resource tracking still
+  // sees every bind. Shadow state is reset on begin(), beginRenderPass() and
+  // executeCommands(). Anything recorded bypassing this class (e.g. through
+  // raw handle) must be followed by invalidateBindState().
+  void enableBindElision(bool enable = true) noexcept(ExceptionsDisabled);
+
+  bool bindElisionEnabled() const noexcept { return m_bindState != nullptr; }
+
+  void invalidateBindState() noexcept;
+
+  SkippedBinds const &skippedBinds() const noexcept { return m_skippedBinds; }
+
+  void resetSkippedBinds() noexcept { m_skippedBinds = SkippedBinds{}; }
+
   template <typename T>
   void bindVertexBuffer(VertexBuffer<T> const &vbuf, uint32_t binding,
-                        VkDeviceSize offset) noexcept {
-    m_bindVertexBuffer(static_cast<BufferBase const &>(vbuf), binding, offset);
+                        VkDeviceSize offset) noexcept(ExceptionsDisabled) {
+    BufferBase const *buffer = &vbuf;
+    m_bindVertexBuffers(binding, {&buffer, 1}, {&offset, 1});
+  }
+
+  // Binds buffers to consecutive bindings starting from firstBinding with a
+  // single command. Vertex buffers of different attribute types can be mixed
+  // through std::reference_wrapper<BufferBase const>.
+  template <forward_range_of<BufferBase const> T>
+  void bindVertexBuffers(uint32_t firstBinding, T const &buffers,
+                         std::span<const VkDeviceSize> offsets) noexcept(
+      ExceptionsDisabled) {
+    auto buffersSubrange = ranges::make_subrange<BufferBase const>(buffers);
+    using buffersSubrangeT = decltype(buffersSubrange);
+
+    boost::container::small_vector<BufferBase const *, 4> rawBuffers;
+    std::transform(buffersSubrange.begin(), buffersSubrange.end(),
+                   std::back_inserter(rawBuffers),
+                   [](auto const &buffer) -> BufferBase const * {
+                     return &buffersSubrangeT::get(buffer);
+                   });
+    m_bindVertexBuffers(firstBinding, {rawBuffers.data(), rawBuffers.size()},
+                        offsets);
+  }
+
+  template <typename... T>
+  void bindVertexBuffers(uint32_t firstBinding,
+                         std::array<VkDeviceSize, sizeof...(T)> const &offsets,
+                         VertexBuffer<T> const &...buffers) noexcept(
+      ExceptionsDisabled) {
+    std::array<BufferBase const *, sizeof...(T)> rawBuffers{
+        static_cast<BufferBase const *>(&buffers)...};
+    m_bindVertexBuffers(firstBinding, rawBuffers, offsets);
+  }
+
+  // Overload for zero offsets
+  template <typename... T>
+  void bindVertexBuffers(uint32_t firstBinding,
+                         VertexBuffer<T> const &...buffers) noexcept(
+      ExceptionsDisabled) {
+    bindVertexBuffers(firstBinding,
+                      std::array<VkDeviceSize, sizeof...(T)>{}, buffers...);
   }
 
   template <VkIndexType type>
   void bindIndexBuffer(IndexBuffer<type> const &ibuf,
-                       VkDeviceSize offset) noexcept {
+                       VkDeviceSize offset) noexcept(ExceptionsDisabled) {
     m_bindIndexBuffer(static_cast<BufferBase const &>(ibuf), type, offset);
   }
 
@@ -154,6 +305,63 @@ public:
                          dynamicOffsets.data(), dynamicOffsets.size());
   }
 
+  // Binds raw sets, e.g. those handed out by DescriptorAllocator.
+  void bindDescriptorSets(
+      PipelineLayout const &layout, VkPipelineBindPoint bindPoint,
+      std::span<const VkDescriptorSet> sets, uint32_t firstSet,
+      std::span<const uint32_t> dynamicOffsets = {}) noexcept {
+    m_bindDescriptorSets(layout, bindPoint, firstSet, sets.data(), sets.size(),
+                         dynamicOffsets.data(), dynamicOffsets.size());
+  }
+
+  // Binds descriptor buffers, their positions in the range are the buffer
+  // indices of setDescriptorBufferOffsets. Requires descriptorBuffer feature.
+  template <forward_range_of<DescriptorBuffer const> T>
+  void bindDescriptorBuffers(T const &buffers) noexcept(ExceptionsDisabled) {
+    auto buffersSubrange =
+        ranges::make_subrange<DescriptorBuffer const>(buffers);
+    using buffersSubrangeT = decltype(buffersSubrange);
+
+    boost::container::small_vector<VkDescriptorBufferBindingInfoEXT, 2>
+        bindingInfos{};
+    std::transform(buffersSubrange.begin(), buffersSubrange.end(),
+                   std::back_inserter(bindingInfos), [](auto const &buffer) {
+                     return buffersSubrangeT::get(buffer).bindingInfo();
+                   });
+    bindDescriptorBuffers({bindingInfos.data(), bindingInfos.size()});
+  }
+
+  void bindDescriptorBuffers(
+      std::span<const VkDescriptorBufferBindingInfoEXT> bindingInfos) noexcept(
+      ExceptionsDisabled);
+
+  // Sources sets firstSet.. of the layout from bound descriptor buffers at
+  // given offsets, e.g. DescriptorBuffer::Set::offset.
+  void setDescriptorBufferOffsets(
+      PipelineLayout const &layout, VkPipelineBindPoint bindPoint,
+      uint32_t firstSet, std::span<const uint32_t> bufferIndices,
+      std::span<const VkDeviceSize> offsets) noexcept(ExceptionsDisabled);
+
+  // Records descriptor writes into set number `set` of the layout without
+  // allocating a descriptor set. Requires VK_KHR_push_descriptor.
+  void pushDescriptorSet(PipelineLayout const &layout,
+                         VkPipelineBindPoint bindPoint, uint32_t set,
+                         PushDescriptorSet const &writes) noexcept(
+      ExceptionsDisabled);
+
+  // Pushes the whole set from a packed structure with a push descriptor
+  // template. Requires VK_KHR_push_descriptor.
+  void pushDescriptorSet(DescriptorUpdateTemplate const &updateTemplate,
+                         void const *data) noexcept(ExceptionsDisabled);
+
+  template <typename T>
+  requires std::is_trivially_copyable_v<T> && (!std::is_pointer_v<T>)
+  void pushDescriptorSet(DescriptorUpdateTemplate const &updateTemplate,
+                         T const &data) noexcept(ExceptionsDisabled) {
+    updateTemplate.m_checkDataSize(sizeof(T));
+    pushDescriptorSet(updateTemplate, static_cast<void const *>(&data));
+  }
+
   template <typename T>
   void pushConstants(PipelineLayout const &layout,
                      VkShaderStageFlagBits shaderStage, uint32_t offset,
@@ -163,15 +371,99 @@ public:
   /** Draw commands */
 
   void draw(uint32_t vertexCount, uint32_t instanceCount = 0,
-            uint32_t firstVertex = 0, uint32_t firstInstance = 0) noexcept;
+            uint32_t firstVertex = 0,
+            uint32_t firstInstance = 0) noexcept(ExceptionsDisabled);
   void drawIndexed(uint32_t indexCount, uint32_t instanceCount = 0,
                    uint32_t firstIndex = 0, int32_t vertexOffset = 0,
-                   uint32_t firstInstance = 0) noexcept;
+                   uint32_t firstInstance = 0) noexcept(ExceptionsDisabled);
+
+  // One draw per element in a single VK_EXT_multi_draw command if multiDraw
+  // feature is enabled (split by maxMultiDrawCount), otherwise in a loop of
+  // ordinary draws.
+  void drawMulti(std::span<const VkMultiDrawInfoEXT> draws,
+                 uint32_t instanceCount = 1,
+                 uint32_t firstInstance = 0) noexcept(ExceptionsDisabled);
+
+  // If vertexOffset is given, it overrides vertex offsets of all draws.
+  void drawMultiIndexed(std::span<const VkMultiDrawIndexedInfoEXT> draws,
+                        uint32_t instanceCount = 1, uint32_t firstInstance = 0,
+                        std::optional<int32_t> vertexOffset =
+                            std::nullopt) noexcept(ExceptionsDisabled);
+
+  // Indirect draws read drawCount commands with given stride from buffer.
+  // With resource tracking enabled, buffers are declared as indirect command
+  // reads.
+  void drawIndirect(BufferBase const &buffer, VkDeviceSize offset,
+                    uint32_t drawCount,
+                    uint32_t stride = sizeof(VkDrawIndirectCommand)) noexcept(
+      ExceptionsDisabled);
+  void drawIndexedIndirect(
+      BufferBase const &buffer, VkDeviceSize offset, uint32_t drawCount,
+      uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)) noexcept(
+      ExceptionsDisabled);
+
+  // Draw count is read from countBuffer and clamped to maxDrawCount.
+  // Requires PhysicalDevice::extended_feature::drawIndirectCount.
+  void drawIndirectCount(
+      BufferBase const &buffer, VkDeviceSize offset,
+      BufferBase const &countBuffer, VkDeviceSize countOffset,
+      uint32_t maxDrawCount,
+      uint32_t stride = sizeof(VkDrawIndirectCommand)) noexcept(
+      ExceptionsDisabled);
+  void drawIndexedIndirectCount(
+      BufferBase const &buffer, VkDeviceSize offset,
+      BufferBase const &countBuffer, VkDeviceSize countOffset,
+      uint32_t maxDrawCount,
+      uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)) noexcept(
+      ExceptionsDisabled);
+
+  template <std::derived_from<VkDrawIndirectCommand> T>
+  void drawIndirect(IndirectBuffer<T> const &buffer, uint32_t drawCount,
+                    uint32_t firstDraw = 0) noexcept(ExceptionsDisabled) {
+    drawIndirect(buffer, firstDraw * sizeof(T), drawCount, sizeof(T));
+  }
+
+  template <std::derived_from<VkDrawIndexedIndirectCommand> T>
+  void drawIndexedIndirect(IndirectBuffer<T> const &buffer, uint32_t drawCount,
+                           uint32_t firstDraw = 0) noexcept(
+      ExceptionsDisabled) {
+    drawIndexedIndirect(buffer, firstDraw * sizeof(T), drawCount, sizeof(T));
+  }
+
+  template <std::derived_from<VkDrawIndirectCommand> T>
+  void drawIndirectCount(IndirectBuffer<T> const &buffer,
+                         IndirectBuffer<uint32_t> const &countBuffer,
+                         uint32_t maxDrawCount, uint32_t firstDraw = 0,
+                         uint32_t countIndex = 0) noexcept(ExceptionsDisabled) {
+    drawIndirectCount(buffer, firstDraw * sizeof(T), countBuffer,
+                      countIndex * sizeof(uint32_t), maxDrawCount, sizeof(T));
+  }
+
+  template <std::derived_from<VkDrawIndexedIndirectCommand> T>
+  void drawIndexedIndirectCount(IndirectBuffer<T> const &buffer,
+                                IndirectBuffer<uint32_t> const &countBuffer,
+                                uint32_t maxDrawCount, uint32_t firstDraw = 0,
+                                uint32_t countIndex = 0) noexcept(
+      ExceptionsDisabled) {
+    drawIndexedIndirectCount(buffer, firstDraw * sizeof(T), countBuffer,
+                             countIndex * sizeof(uint32_t), maxDrawCount,
+                             sizeof(T));
+  }
 
   /** Dispatch commands */
 
   void dispatch(uint32_t groupCountX, uint32_t groupCountY,
-                uint32_t groupCountZ) noexcept;
+                uint32_t groupCountZ) noexcept(ExceptionsDisabled);
+
+  void dispatchIndirect(BufferBase const &buffer,
+                        VkDeviceSize offset) noexcept(ExceptionsDisabled);
+
+  template <std::derived_from<VkDispatchIndirectCommand> T>
+  void dispatchIndirect(IndirectBuffer<T> const &buffer,
+                        uint32_t index = 0) noexcept(ExceptionsDisabled) {
+    dispatchIndirect(static_cast<BufferBase const &>(buffer),
+                     index * sizeof(T));
+  }
 
   /** Pipeline dynamic state sets */
 
@@ -187,28 +479,106 @@ public:
 protected:
   CommandBuffer(CommandPool &pool,
                 VkCommandBufferLevel bufferLevel) noexcept(ExceptionsDisabled);
+  // Adopts command buffer already allocated from the pool.
+  CommandBuffer(CommandPool &pool, VkCommandBuffer commandBuffer) noexcept;
   StrongReference<Device const> m_device;
   StrongReference<CommandPool const> m_pool;
   VkCommandBuffer m_commandBuffer = VK_NULL_HANDLE;
+  // Tracked barriers are rejected inside render pass instances
+  bool m_insideRenderPass = false;
   void m_begin(VkCommandBufferUsageFlags flags,
                VkCommandBufferInheritanceInfo const
                    *inheritanceInfo) noexcept(ExceptionsDisabled);
 
 private:
+  friend class CommandPoolRing;
+
+  struct BarrierBatch {
+    VkPipelineStageFlags srcStage = 0;
+    VkPipelineStageFlags dstStage = 0;
+    VkDependencyFlags flags = 0;
+    boost::container::small_vector<VkMemoryBarrier, 1> memoryBarriers;
+    boost::container::small_vector<VkImageMemoryBarrier, 8> imageBarriers;
+    boost::container::small_vector<VkBufferMemoryBarrier, 8> bufferBarriers;
+
+    bool empty() const noexcept { return dstStage == 0; }
+
+    void clear() noexcept;
+  };
+
+  // Shadow of the state set by binding commands. Null handles mean unknown
+  // state, binds beyond tracked slots are never elided.
+  struct BindState {
+    static constexpr uint32_t MaxSets = 8;
+    static constexpr uint32_t MaxVertexBindings = 32;
+    static constexpr uint32_t MaxViewports = 16;
+
+    struct BindPoint {
+      VkPipeline pipeline = VK_NULL_HANDLE;
+      VkPipelineLayout layout = VK_NULL_HANDLE;
+      std::array<VkDescriptorSet, MaxSets> sets{};
+    };
+
+    // Graphics and compute
+    std::array<BindPoint, 2> bindPoints{};
+    std::array<std::pair<VkBuffer, VkDeviceSize>, MaxVertexBindings>
+        vertexBuffers{};
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize indexOffset = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+    std::array<std::optional<VkViewport>, MaxViewports> viewports{};
+    std::array<std::optional<VkRect2D>, MaxViewports> scissors{};
+
+    BindPoint *bindPoint(VkPipelineBindPoint point) noexcept;
+
+    void clear() noexcept { *this = BindState{}; }
+  };
+
+  // Forgets the set bound to the slot after it was pushed.
+  void m_invalidatePushedSet(VkPipelineBindPoint bindPoint,
+                             VkPipelineLayout layout, uint32_t set) noexcept;
+
+  // Returns true if pipeline is already bound, otherwise updates the shadow.
+  bool m_elidePipeline(VkPipelineBindPoint bindPoint,
+                       VkPipeline pipeline) noexcept;
+
+  void m_recordPipelineBarrier(
+      VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+      std::span<const VkMemoryBarrier> memBarriers,
+      std::span<const VkImageMemoryBarrier> imageMemoryBarrier,
+      std::span<const VkBufferMemoryBarrier> bufferMemoryBarrier,
+      VkDependencyFlags flags) noexcept;
+
+  // Moves barriers computed by resource tracker, if any, to the batch or
+  // records them.
+  void m_flushTrackedBarriers() noexcept;
+
+  // Tracked barriers can't be recorded inside a render pass instance.
+  void m_checkTrackedBarriers() noexcept(ExceptionsDisabled);
+
+  void m_flushBarrierBatch() noexcept;
+
   void m_pushConstants(PipelineLayout const &layout,
                        VkShaderStageFlagBits shaderStage, uint32_t offset,
                        uint32_t size, const void *data) noexcept;
-  void m_bindVertexBuffer(VkBuffer buffer, uint32_t binding,
-                          VkDeviceSize offset) noexcept;
-  void m_bindIndexBuffer(VkBuffer buffer, VkIndexType type,
-                         VkDeviceSize offset) noexcept;
+  void m_bindVertexBuffers(uint32_t firstBinding,
+                           std::span<BufferBase const *const> buffers,
+                           std::span<const VkDeviceSize> offsets) noexcept(
+      ExceptionsDisabled);
+  void m_bindIndexBuffer(BufferBase const &buffer, VkIndexType type,
+                         VkDeviceSize offset) noexcept(ExceptionsDisabled);
 
   void m_bindDescriptorSets(const PipelineLayout &layout,
                             VkPipelineBindPoint bindPoint, size_t firstSet,
                             VkDescriptorSet const *sets, size_t nsets,
-                            uint32_t *dynOffsets, size_t ndynOffsets) noexcept;
+                            uint32_t const *dynOffsets,
+                            size_t ndynOffsets) noexcept;
   bool m_recording = false;
   bool m_executable = false;
+  std::unique_ptr<ResourceTracker> m_tracker;
+  std::unique_ptr<BarrierBatch> m_barrierBatch;
+  std::unique_ptr<BindState> m_bindState;
+  SkippedBinds m_skippedBinds{};
 };
 
 class SecondaryCommandBuffer : public CommandBuffer {
@@ -222,6 +592,12 @@ public:
                  nullptr) noexcept(ExceptionsDisabled) {
     m_begin(flags, inheritanceInfo);
   }
+
+private:
+  friend class CommandPoolRing;
+  SecondaryCommandBuffer(CommandPool &pool,
+                         VkCommandBuffer commandBuffer) noexcept
+      : CommandBuffer(pool, commandBuffer){};
 };
 
 class PrimaryCommandBuffer : public CommandBuffer {
@@ -239,11 +615,16 @@ public:
 
   template <forward_range_of<SecondaryCommandBuffer> T>
   void executeCommands(T const &commands) noexcept(ExceptionsDisabled) {
-    boost::container::small_vector<VkCommandBuffer, 5> rawBufs;
+    auto commandsSubrange = ranges::make_subrange<SecondaryCommandBuffer>(
+        commands);
+    using commandsSubrangeT = decltype(commandsSubrange);
 
-    std::transform(
-        commands.begin(), commands.end(),
-        [](std::ranges::range_value_t<T> const &command) { return command; });
+    boost::container::small_vector<VkCommandBuffer, 5> rawBufs;
+    std::transform(commandsSubrange.begin(), commandsSubrange.end(),
+                   std::back_inserter(rawBufs),
+                   [](auto const &command) -> VkCommandBuffer {
+                     return commandsSubrangeT::get(command);
+                   });
     m_executeCommands(rawBufs.size(), rawBufs.data());
   }
 
@@ -258,6 +639,11 @@ public:
   }
 
 private:
+  friend class CommandPoolRing;
+  PrimaryCommandBuffer(CommandPool &pool,
+                       VkCommandBuffer commandBuffer) noexcept
+      : CommandBuffer(pool, commandBuffer){};
+
   void m_executeCommands(size_t nbufs, VkCommandBuffer const *buffers) noexcept;
   // FIXME: This strong reference causes irrecoverable errors when exception is
   // thrown while recording. Better to use something else.
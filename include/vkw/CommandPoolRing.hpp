@@ -0,0 +1,108 @@
+#ifndef VKWRAPPER_COMMANDPOOLRING_HPP
+#define VKWRAPPER_COMMANDPOOLRING_HPP
+
+#include <vkw/CommandBuffer.hpp>
+#include <vkw/CommandPool.hpp>
+#include <vkw/Fence.hpp>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace vkw {
+
+/**
+ * @class CommandPoolRing
+ *
+ * @brief Set of transient command pools: one for every (frame in flight,
+ * recording thread) pair.
+ *
+ * Each frame slot owns a fence which must be signaled by the last submission
+ * of the frame. When the ring comes back to a slot, beginFrame() waits for
+ * its fence and resets every pool of the slot at once with
+ * vkResetCommandPool. Command buffers are allocated in batches and handed
+ * out from a per-pool free list, so after the first few frames recording
+ * doesn't allocate anything.
+ *
+ * Pools of different threads may be used concurrently, each from a single
+ * thread. beginFrame() must not run concurrently with recording.
+ */
+class CommandPoolRing {
+public:
+  CommandPoolRing(Device const &device, uint32_t queueFamily,
+                  uint32_t framesInFlight, uint32_t threadCount = 1,
+                  uint32_t allocationBatch = 8) noexcept(ExceptionsDisabled);
+
+  CommandPoolRing(CommandPoolRing const &another) = delete;
+  CommandPoolRing &operator=(CommandPoolRing const &another) = delete;
+
+  // Moves to the next frame slot. Command buffers handed out from this slot
+  // during its previous use become available again.
+  void beginFrame() noexcept(ExceptionsDisabled);
+
+  // Fence to be signaled by the last submission of the current frame.
+  Fence &frameFence() noexcept { return m_frames[m_currentFrame].fence; }
+
+  Fence &frameFence(uint32_t frame) noexcept(ExceptionsDisabled) {
+    if (frame >= m_frames.size())
+      postError(Error("CommandPoolRing: frame index out of range"));
+    return m_frames[frame].fence;
+  }
+
+  // Returns command buffer in initial state allocated from the pool of the
+  // current frame owned by the given thread.
+  PrimaryCommandBuffer &
+  primary(uint32_t thread = 0) noexcept(ExceptionsDisabled);
+
+  SecondaryCommandBuffer &
+  secondary(uint32_t thread = 0) noexcept(ExceptionsDisabled);
+
+  CommandPool &pool(uint32_t thread = 0) noexcept(ExceptionsDisabled) {
+    return m_threadPool(thread).pool;
+  }
+
+  uint32_t framesInFlight() const noexcept { return m_frames.size(); }
+
+  uint32_t threadCount() const noexcept { return m_threadCount; }
+
+  uint32_t currentFrame() const noexcept { return m_currentFrame; }
+
+private:
+  template <typename T> struct FreeList {
+    std::vector<std::unique_ptr<T>> buffers;
+    size_t used = 0;
+  };
+
+  struct ThreadPool {
+    ThreadPool(Device const &device, uint32_t queueFamily) noexcept(
+        ExceptionsDisabled)
+        : pool(device, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, queueFamily) {}
+
+    CommandPool pool;
+    FreeList<PrimaryCommandBuffer> primaries;
+    FreeList<SecondaryCommandBuffer> secondaries;
+  };
+
+  struct Frame {
+    explicit Frame(Device const &device) noexcept(ExceptionsDisabled)
+        : fence(device, true) {}
+
+    Fence fence;
+    std::deque<ThreadPool> pools;
+  };
+
+  ThreadPool &m_threadPool(uint32_t thread) noexcept(ExceptionsDisabled);
+
+  template <typename T>
+  T &m_acquire(CommandPool &pool, FreeList<T> &freeList,
+               VkCommandBufferLevel level) noexcept(ExceptionsDisabled);
+
+  StrongReference<Device const> m_device;
+  std::deque<Frame> m_frames;
+  uint32_t m_threadCount;
+  uint32_t m_allocationBatch;
+  uint32_t m_currentFrame;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_COMMANDPOOLRING_HPP
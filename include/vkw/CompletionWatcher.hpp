@@ -0,0 +1,113 @@
+#ifndef VKWRAPPER_COMPLETIONWATCHER_HPP
+#define VKWRAPPER_COMPLETIONWATCHER_HPP
+
+#include <vkw/Device.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vkw {
+
+class Fence;
+class TimelineSemaphore;
+
+/**
+ * @class CompletionWatcher
+ *
+ * @brief Thread that waits for GPU completion on behalf of the rest of the
+ * application.
+ *
+ * Fences and timeline semaphore values are registered together with a
+ * callback. The watcher waits for any of the registered fences at once with
+ * vkWaitForFences (or for any timeline value with vkWaitSemaphores when no
+ * fence is registered), then runs callbacks of everything that completed.
+ * Waits registered while the watcher is blocked are picked up after at most
+ * one poll interval.
+ *
+ * Callbacks run on the watcher thread, must be short and must not throw.
+ * They receive VK_SUCCESS, or the error the status query of their fence or
+ * semaphore failed with (typically VK_ERROR_DEVICE_LOST); futures report the
+ * latter as VulkanError. Fences and semaphores must stay alive until their
+ * callbacks ran. Callbacks of waits still pending on destruction run on
+ * destruction with Abandoned, futures report it as Error.
+ *
+ * Every Device lazily creates one watcher, see Device::completionWatcher().
+ */
+class CompletionWatcher {
+public:
+  using Callback = std::function<void(VkResult result)>;
+
+  // Passed to callbacks of waits the watcher was destroyed with.
+  static constexpr VkResult Abandoned = VK_ERROR_UNKNOWN;
+
+  explicit CompletionWatcher(
+      Device const &device, std::chrono::microseconds pollInterval =
+                                std::chrono::milliseconds(1)) noexcept;
+
+  CompletionWatcher(CompletionWatcher const &another) = delete;
+  CompletionWatcher &operator=(CompletionWatcher const &another) = delete;
+
+  ~CompletionWatcher();
+
+  void onComplete(Fence const &fence, Callback callback) noexcept(
+      ExceptionsDisabled);
+
+  // Requires PhysicalDevice::extended_feature::timelineSemaphore.
+  void onComplete(TimelineSemaphore const &semaphore, uint64_t value,
+                  Callback callback) noexcept(ExceptionsDisabled);
+
+  std::future<void> whenComplete(Fence const &fence) noexcept(
+      ExceptionsDisabled);
+
+  std::future<void> whenComplete(TimelineSemaphore const &semaphore,
+                                 uint64_t value) noexcept(ExceptionsDisabled);
+
+  Device const &device() const noexcept { return m_device; }
+
+private:
+  // result is VK_NOT_READY until the wait completes or fails
+  struct FenceWait {
+    VkFence fence;
+    Callback callback;
+    VkResult result = VK_NOT_READY;
+  };
+
+  struct TimelineWait {
+    VkSemaphore semaphore;
+    uint64_t value;
+    Callback callback;
+    VkResult result = VK_NOT_READY;
+  };
+
+  void m_run() noexcept;
+
+  void m_poll(uint64_t timeout) noexcept;
+
+  VkResult m_waitFences(uint64_t timeout) noexcept;
+
+  VkResult m_waitTimelines(uint64_t timeout) noexcept;
+
+  StrongReference<Device const> m_device;
+  std::chrono::microseconds m_pollInterval;
+
+  // Guarded by m_mutex: registrations not yet seen by the watcher thread.
+  std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  std::vector<FenceWait> m_newFences;
+  std::vector<TimelineWait> m_newTimelines;
+  bool m_stop = false;
+
+  // Owned by the watcher thread.
+  std::vector<FenceWait> m_fences;
+  std::vector<TimelineWait> m_timelines;
+
+  std::thread m_thread;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_COMPLETIONWATCHER_HPP
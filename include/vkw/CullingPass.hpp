@@ -0,0 +1,97 @@
+#ifndef VKWRAPPER_CULLINGPASS_HPP
+#define VKWRAPPER_CULLINGPASS_HPP
+
+#include <vkw/CommandBuffer.hpp>
+#include <vkw/DescriptorSet.hpp>
+#include <vkw/IndirectBuffer.hpp>
+#include <vkw/Pipeline.hpp>
+#include <vkw/Shader.hpp>
+
+namespace vkw {
+
+class PipelineCache;
+
+/**
+ * @class CullingPass
+ *
+ * @brief Compute stage culling instances on GPU and producing compacted
+ * indexed indirect draws for drawIndexedIndirectCount().
+ *
+ * Every instance is a bounding sphere with its draw parameters. Instances
+ * outside of the view frustum or, optionally, behind the depth stored in a
+ * Hi-Z pyramid (farthest depth per texel, mip chain down to 1x1) are dropped,
+ * the rest are appended to the command buffer in arbitrary order. Kernel is
+ * compiled to SPIR-V at library build time and embedded into the library.
+ *
+ * Command and draw count buffers must also be created with storage usage.
+ * At most commands.size() draws are produced, the rest are dropped.
+ * Hi-Z image is sampled in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL with
+ * a nearest sampler and must be bound even if occlusion culling is off.
+ */
+class CullingPass {
+public:
+  // std430 layout of instance buffer element
+  struct Instance {
+    float center[3];
+    float radius;
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t firstInstance;
+  };
+
+  // std140 layout of view uniform buffer
+  struct View {
+    float viewProjection[16]; // column-major
+    // Plane normals point inside the frustum: dot(n, p) + d >= 0
+    float frustumPlanes[6][4];
+    float hiZSize[2]; // size of Hi-Z level 0 in texels
+    uint32_t occlusionCulling;
+    uint32_t reversedDepth;
+  };
+
+  static constexpr uint32_t WorkGroupSize = 64;
+
+  explicit CullingPass(Device &device) noexcept(ExceptionsDisabled);
+
+  CullingPass(Device &device,
+              PipelineCache const &cache) noexcept(ExceptionsDisabled);
+
+  DescriptorSetLayout const &setLayout() const noexcept { return m_setLayout; }
+
+  PipelineLayout const &layout() const noexcept { return m_layout; }
+
+  ComputePipeline const &pipeline() const noexcept { return m_pipeline; }
+
+  // Resources the pass reads and writes.
+  struct Resources {
+    UniformBuffer<View> const &view;
+    BufferBase const &instances;
+    IndirectBuffer<VkDrawIndexedIndirectCommand> const &commands;
+    IndirectBuffer<uint32_t> const &drawCount;
+    ImageViewBase const &hiZ;
+    Sampler const &hiZSampler;
+  };
+
+  // Writes all bindings of a set allocated with setLayout().
+  void updateSet(DescriptorSet &set,
+                 Resources const &resources) const noexcept;
+
+  // Zeroes draw count and dispatches culling of instanceCount instances.
+  // With resource tracking enabled on the command buffer, barriers against
+  // preceding uploads and following indirect draws are inserted
+  // automatically, otherwise the caller must guard buffers except drawCount
+  // reset.
+  void record(CommandBuffer &commandBuffer, DescriptorSet const &set,
+              Resources const &resources,
+              uint32_t instanceCount) const noexcept(ExceptionsDisabled);
+
+private:
+  ComputeShader m_shader;
+  DescriptorSetLayout m_setLayout;
+  PipelineLayout m_layout;
+  ComputePipeline m_pipeline;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_CULLINGPASS_HPP
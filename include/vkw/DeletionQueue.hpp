@@ -0,0 +1,151 @@
+#ifndef VKWRAPPER_DELETIONQUEUE_HPP
+#define VKWRAPPER_DELETIONQUEUE_HPP
+
+#include "vma/vk_mem_alloc.h"
+#include <vkw/Exception.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <vector>
+
+namespace vkw {
+
+class Device;
+class TimelineSemaphore;
+
+/**
+ * @class DeletionQueue
+ *
+ * @brief Defers destruction of Vulkan objects until GPU is done with them.
+ *
+ * Every Device owns one. It is disabled by default: objects are destroyed
+ * right in their destructors as usual. When deferral is enabled, destructors
+ * of UniqueVulkanObject's created by Device, BufferBase, AllocatedImage,
+ * Pipeline, DescriptorUpdateTemplate and DescriptorSet (from pools with
+ * VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) retire their handles
+ * here, tagged with the current key instead.
+ *
+ * Key is any monotonically growing value the application can tell GPU
+ * progress by: a frame number or a timeline semaphore value signaled by the
+ * next submission. collect() then destroys, in one batch, everything
+ * retired with keys the GPU has already passed.
+ *
+ * All methods are thread-safe.
+ */
+class DeletionQueue {
+public:
+  using DestroyFn = void (*)(Device const &device, uint64_t handle,
+                             VmaAllocation allocation) noexcept;
+
+  // Returns a handle allocated from a parent object, e.g. a descriptor set
+  // to its pool.
+  using FreeFn = void (*)(Device const &device, uint64_t parent,
+                          uint64_t handle) noexcept;
+
+  // Invoked from the destructor's thread with the handle of every object
+  // passed to retire(), whether its destruction is deferred or not. Must not
+  // destroy Vulkan objects itself.
+  using DestroyObserver = std::function<void(uint64_t handle)>;
+
+  explicit DeletionQueue(Device const &device) noexcept(ExceptionsDisabled);
+
+  DeletionQueue(DeletionQueue const &another) = delete;
+  DeletionQueue &operator=(DeletionQueue const &another) = delete;
+
+  // Destroys everything still pending, GPU must be idle by now.
+  ~DeletionQueue();
+
+  void enableDeferral(bool enable = true) noexcept {
+    m_enabled.store(enable, std::memory_order_relaxed);
+  }
+
+  bool deferralEnabled() const noexcept {
+    return m_enabled.load(std::memory_order_relaxed);
+  }
+
+  // Key that objects destroyed from now on are retired with. Must not
+  // decrease.
+  void setCurrentKey(uint64_t key) noexcept;
+
+  uint64_t currentKey() const noexcept;
+
+  // Destroys everything retired with key <= completedKey. Returns count of
+  // destroyed objects.
+  size_t collect(uint64_t completedKey) noexcept;
+
+  size_t collect(TimelineSemaphore const &semaphore) noexcept(
+      ExceptionsDisabled);
+
+  // Destroys everything regardless of keys.
+  size_t flush() noexcept;
+
+  size_t pending() const noexcept;
+
+  // Called by destructors. Returns false if deferral is disabled, in which
+  // case the caller has to destroy the object itself.
+  bool retire(DestroyFn destroy, uint64_t handle,
+              VmaAllocation allocation = VK_NULL_HANDLE) noexcept;
+
+  bool retire(FreeFn free, uint64_t parent, uint64_t handle) noexcept;
+
+  // Lets caches keyed by raw handles drop entries of destroyed objects.
+  // Returns id for removeObserver().
+  uint64_t addObserver(DestroyObserver observer) noexcept(ExceptionsDisabled);
+
+  void removeObserver(uint64_t id) noexcept;
+
+  // Queue of the device that owns the allocator, if any.
+  static DeletionQueue *find(VmaAllocator allocator) noexcept;
+
+  // Non-dispatchable handles are integers on 32-bit platforms.
+  template <typename T> static uint64_t toRaw(T handle) noexcept {
+    if constexpr (std::is_pointer_v<T>)
+      return reinterpret_cast<std::uintptr_t>(handle);
+    else
+      return handle;
+  }
+
+  template <typename T> static T fromRaw(uint64_t handle) noexcept {
+    if constexpr (std::is_pointer_v<T>)
+      return reinterpret_cast<T>(static_cast<std::uintptr_t>(handle));
+    else
+      return handle;
+  }
+
+private:
+  struct Entry {
+    uint64_t key;
+    DestroyFn destroy;
+    uint64_t handle;
+    VmaAllocation allocation;
+    FreeFn free = nullptr;
+    uint64_t parent = 0;
+  };
+
+  bool m_retire(Entry entry) noexcept;
+
+  size_t m_destroy(std::deque<Entry> const &entries) const noexcept;
+
+  void m_notifyObservers(uint64_t handle) const noexcept;
+
+  std::reference_wrapper<Device const> m_device;
+  VmaAllocator m_allocator;
+  std::atomic<bool> m_enabled = false;
+
+  mutable std::mutex m_mutex;
+  uint64_t m_currentKey = 0;
+  std::deque<Entry> m_entries;
+
+  mutable std::shared_mutex m_observerMutex;
+  std::vector<std::pair<uint64_t, DestroyObserver>> m_observers;
+  std::atomic<size_t> m_observerCount = 0;
+  uint64_t m_nextObserverId = 0;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_DELETIONQUEUE_HPP
@@ -0,0 +1,115 @@
+#ifndef VKWRAPPER_DESCRIPTORALLOCATOR_HPP
+#define VKWRAPPER_DESCRIPTORALLOCATOR_HPP
+
+#include <vkw/DescriptorPool.hpp>
+#include <vkw/DescriptorSet.hpp>
+
+#include <array>
+#include <deque>
+#include <span>
+
+namespace vkw {
+
+/**
+ * @class DescriptorAllocator
+ *
+ * @brief Linear descriptor set allocator over a growing chain of pools.
+ *
+ * Sets are never freed one by one: reset() returns every pool of the chain to
+ * its initial state with vkResetDescriptorPool, invalidating all sets handed
+ * out since the previous reset. When the current pool runs out of memory the
+ * allocator moves on to the next pool of the chain, creating one twice as
+ * large if needed. When a frame has overflowed the first pool, reset()
+ * replaces the chain with a single pool sized after the sets the frame
+ * used, so a steady workload ends up served by one pool.
+ *
+ * Pool sizes are given per set: every pool with room for N sets gets
+ * N * descriptorCount descriptors of each listed type. A variable sized
+ * binding is allocated with its full descriptor count, as DescriptorPool
+ * does.
+ *
+ * The allocator has no locks. Keep one per recording thread and, for sets
+ * used by GPU, one per frame in flight, resetting it once the frame's fence
+ * is signaled.
+ */
+class DescriptorAllocator {
+public:
+  // Descriptors of each type a pool reserves per set
+  static constexpr std::array<VkDescriptorPoolSize, 6> DefaultRatios{
+      VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+      VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2},
+      VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
+      VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
+      VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1},
+      VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1}};
+
+  explicit DescriptorAllocator(
+      Device const &device, uint32_t initialSets = 64,
+      std::span<const VkDescriptorPoolSize> ratios = DefaultRatios,
+      uint32_t maxSetsPerPool = 4096) noexcept(ExceptionsDisabled);
+
+  DescriptorAllocator(DescriptorAllocator const &another) = delete;
+  DescriptorAllocator &operator=(DescriptorAllocator const &another) = delete;
+
+  VkDescriptorSet
+  allocate(DescriptorSetLayout const &layout) noexcept(ExceptionsDisabled);
+
+  // Allocates a set for every layout with as few driver calls as possible.
+  template <forward_range_of<DescriptorSetLayout const> T>
+  void allocate(T const &layouts, std::span<VkDescriptorSet> sets) noexcept(
+      ExceptionsDisabled) {
+    auto layoutsSubrange =
+        ranges::make_subrange<DescriptorSetLayout const>(layouts);
+    using layoutsSubrangeT = decltype(layoutsSubrange);
+
+    boost::container::small_vector<VkDescriptorSetLayout, 8> rawLayouts;
+    boost::container::small_vector<uint32_t, 8> variableCounts;
+    bool hasVariableCounts = false;
+    for (auto const &entry : layoutsSubrange) {
+      DescriptorSetLayout const &layout = layoutsSubrangeT::get(entry);
+      rawLayouts.push_back(layout);
+      variableCounts.push_back(layout.variableDescriptorCount());
+      hasVariableCounts = hasVariableCounts || variableCounts.back() != 0;
+    }
+    allocate({rawLayouts.data(), rawLayouts.size()}, sets,
+             hasVariableCounts ? std::span<const uint32_t>{
+                                     variableCounts.data(),
+                                     variableCounts.size()}
+                               : std::span<const uint32_t>{});
+  }
+
+  // variableCounts, if not empty, holds descriptor count of the variable
+  // sized binding for every layout, see
+  // DescriptorSetLayoutInfo::variableDescriptorCount().
+  void allocate(std::span<const VkDescriptorSetLayout> layouts,
+                std::span<VkDescriptorSet> sets,
+                std::span<const uint32_t> variableCounts = {}) noexcept(
+      ExceptionsDisabled);
+
+  // Invalidates all allocated sets. GPU must be done with them.
+  void reset() noexcept(ExceptionsDisabled);
+
+  size_t poolCount() const noexcept { return m_pools.size(); }
+
+  // Sets allocated since the last reset.
+  uint32_t allocatedSets() const noexcept { return m_allocatedSets; }
+
+private:
+  void m_createPool(uint32_t maxSets) noexcept(ExceptionsDisabled);
+
+  // Moves to the next pool of the chain, creating one with room for at least
+  // minSets if the chain is exhausted. Returns true if pool was created.
+  bool m_nextPool(uint32_t minSets) noexcept(ExceptionsDisabled);
+
+  StrongReference<Device const> m_device;
+  boost::container::small_vector<VkDescriptorPoolSize, 6> m_ratios;
+  uint32_t m_maxSetsPerPool;
+
+  // Pools before m_currentPool are full until the next reset
+  std::deque<DescriptorPool> m_pools;
+  size_t m_currentPool = 0;
+  uint32_t m_allocatedSets = 0;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_DESCRIPTORALLOCATOR_HPP
@@ -0,0 +1,108 @@
+#ifndef VKWRAPPER_DESCRIPTORBUFFER_HPP
+#define VKWRAPPER_DESCRIPTORBUFFER_HPP
+
+#include <vkw/DescriptorSet.hpp>
+
+namespace vkw {
+
+/**
+ * @class DescriptorBuffer
+ *
+ * @brief Ring of descriptor set storage in a host visible buffer, the
+ * VK_EXT_descriptor_buffer counterpart of DescriptorAllocator.
+ *
+ * allocate() reserves room for a set in the region of the current frame and
+ * write() puts descriptors obtained with vkGetDescriptorEXT straight into the
+ * mapped memory: no pools, no vkUpdateDescriptorSets. The buffer is bound
+ * with CommandBuffer::bindDescriptorBuffers and sets are selected with
+ * CommandBuffer::setDescriptorBufferOffsets using Set::offset.
+ *
+ * The buffer is split into one region per frame in flight. beginFrame()
+ * moves to the next region and reuses it from the start, so it must only be
+ * called once the GPU is done with the frame that last wrote there.
+ *
+ * Requires descriptorBuffer extended feature to be enabled. Set layouts must
+ * be created with VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT,
+ * pipelines with VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT and buffers
+ * referenced by descriptors with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT.
+ */
+class DescriptorBuffer {
+public:
+  static constexpr VkBufferUsageFlags DefaultUsage =
+      VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+      VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+
+  // Storage of one set, valid until its region is reused.
+  struct Set {
+    DescriptorSetLayout const *layout;
+    // Offset from the start of the buffer
+    VkDeviceSize offset;
+  };
+
+  DescriptorBuffer(
+      Device const &device, VkDeviceSize frameSize, uint32_t framesInFlight,
+      VkBufferUsageFlags usage = DefaultUsage) noexcept(ExceptionsDisabled);
+
+  DescriptorBuffer(DescriptorBuffer const &another) = delete;
+  DescriptorBuffer &operator=(DescriptorBuffer const &another) = delete;
+
+  Set allocate(DescriptorSetLayout const &layout) noexcept(ExceptionsDisabled);
+
+  // Moves to the region of the next frame and forgets sets allocated there.
+  void beginFrame() noexcept;
+
+  void write(Set const &set, uint32_t binding, BufferBase const &buffer,
+             VkDescriptorType type, VkDeviceSize offset = 0,
+             VkDeviceSize range = VK_WHOLE_SIZE) noexcept(ExceptionsDisabled);
+
+  template <typename T>
+  void write(Set const &set, uint32_t binding,
+             UniformBuffer<T> const &uniformBuffer) noexcept(
+      ExceptionsDisabled) {
+    write(set, binding, uniformBuffer, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
+          sizeof(T));
+  }
+
+  template <typename T>
+  void write(Set const &set, uint32_t binding,
+             StorageBuffer<T> const &storageBuffer) noexcept(
+      ExceptionsDisabled) {
+    write(set, binding, storageBuffer, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0,
+          sizeof(T));
+  }
+
+  void write(Set const &set, uint32_t binding, ImageViewBase const &image,
+             VkImageLayout layout,
+             Sampler const &sampler) noexcept(ExceptionsDisabled);
+
+  void writeStorageImage(
+      Set const &set, uint32_t binding, ImageViewBase const &image,
+      VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL) noexcept(
+      ExceptionsDisabled);
+
+  VkDeviceAddress address() const noexcept { return m_address; }
+
+  VkBufferUsageFlags usage() const noexcept { return m_buffer.usage(); }
+
+  VkDescriptorBufferBindingInfoEXT bindingInfo() const noexcept;
+
+  // Bytes taken in the region of the current frame
+  VkDeviceSize used() const noexcept { return m_used; }
+
+private:
+  void m_put(Set const &set, uint32_t binding,
+             VkDescriptorGetInfoEXT const &info,
+             size_t size) noexcept(ExceptionsDisabled);
+
+  StrongReference<Device const> m_device;
+  Buffer<unsigned char> m_buffer;
+  VkDeviceAddress m_address;
+  VkDeviceSize m_alignment;
+  VkDeviceSize m_regionSize;
+  uint32_t m_framesInFlight;
+  uint32_t m_region = 0;
+  VkDeviceSize m_used = 0;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_DESCRIPTORBUFFER_HPP
@@ -43,6 +43,9 @@ private:
 
   void freeSet(DescriptorSet const &set) noexcept;
 
+  static void m_free(Device const &device, uint64_t pool,
+                     uint64_t set) noexcept;
+
   uint32_t m_setCount = 0;
 
   friend class DescriptorSet;
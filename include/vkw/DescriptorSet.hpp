@@ -5,10 +5,13 @@
 #include <vkw/Image.hpp>
 #include <vkw/RangeConcepts.hpp>
 #include <vkw/Sampler.hpp>
+#include <vkw/StaticSetLayout.hpp>
 #include <vkw/UniformBuffer.hpp>
 
 #include <algorithm>
 #include <iterator>
+#include <optional>
+#include <span>
 
 namespace vkw {
 
@@ -17,8 +20,12 @@ public:
   DescriptorSetLayoutBinding(
       uint32_t binding, VkDescriptorType type,
       VkShaderStageFlags shaderStages = VK_SHADER_STAGE_ALL,
-      uint32_t descriptorCount = 1,
-      VkSampler *pImmutableSamplers = nullptr) noexcept;
+      uint32_t descriptorCount = 1, VkSampler *pImmutableSamplers = nullptr,
+      VkDescriptorBindingFlags flags = 0) noexcept;
+  explicit DescriptorSetLayoutBinding(
+      VkDescriptorSetLayoutBinding const &binding,
+      VkDescriptorBindingFlags flags = 0) noexcept
+      : m_binding(binding), m_flags(flags) {}
   virtual ~DescriptorSetLayoutBinding() = default;
 
   uint32_t binding() const noexcept { return m_binding.binding; }
@@ -31,6 +38,9 @@ public:
     return m_binding.descriptorCount;
   }
 
+  // Descriptor indexing flags, require corresponding extended features.
+  VkDescriptorBindingFlags flags() const noexcept { return m_flags; }
+
   operator VkDescriptorSetLayoutBinding const &() const noexcept {
     return m_binding;
   }
@@ -39,7 +49,8 @@ public:
     return m_binding.binding == rhs.m_binding.binding &&
            m_binding.descriptorType == rhs.m_binding.descriptorType &&
            m_binding.descriptorCount == rhs.m_binding.descriptorCount &&
-           m_binding.stageFlags == rhs.m_binding.stageFlags;
+           m_binding.stageFlags == rhs.m_binding.stageFlags &&
+           m_flags == rhs.m_flags;
   }
 
   bool operator!=(DescriptorSetLayoutBinding const &rhs) const noexcept {
@@ -48,6 +59,7 @@ public:
 
 private:
   VkDescriptorSetLayoutBinding m_binding;
+  VkDescriptorBindingFlags m_flags;
 };
 
 class DescriptorSetLayoutInfo {
@@ -59,34 +71,87 @@ public:
     auto bindingsSubrange =
         ranges::make_subrange<DescriptorSetLayoutBinding>(bindings);
     using bindingsSubrangeT = decltype(bindingsSubrange);
+    boost::container::small_vector<DescriptorSetLayoutBinding, 5> sorted;
     std::transform(bindingsSubrange.begin(), bindingsSubrange.end(),
-                   std::back_inserter(m_bindings), [](auto const &entry) {
+                   std::back_inserter(sorted), [](auto const &entry) {
                      return bindingsSubrangeT::get(entry);
                    });
-    m_fillInfo(flags);
+    m_fillInfo({sorted.data(), sorted.size()}, flags);
   }
 
-  auto begin() noexcept { return m_bindings.begin(); }
-
-  auto end() noexcept { return m_bindings.end(); }
-
-  auto begin() const noexcept { return m_bindings.begin(); }
+  // Bindings are sorted and validated in compile time: create info,
+  // iteration and comparison use static arrays of the layout description
+  // directly, nothing is copied.
+  template <StaticSetLayoutLike T>
+  explicit DescriptorSetLayoutInfo(T, VkDescriptorSetLayoutCreateFlags flags =
+                                          0) noexcept(ExceptionsDisabled) {
+    std::span<const VkDescriptorBindingFlags> bindingFlags;
+    if constexpr (T::hasBindingFlags)
+      bindingFlags = T::bindingFlags;
+    m_fillInfo(T::bindings, bindingFlags, flags);
+  }
 
-  auto end() const noexcept { return m_bindings.end(); }
+  // Walks bindings of the create info, keeping a wrapper of the current one.
+  // References to it are invalidated by the next increment.
+  class BindingIterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = DescriptorSetLayoutBinding;
+    using difference_type = std::ptrdiff_t;
+    using pointer = DescriptorSetLayoutBinding const *;
+    using reference = DescriptorSetLayoutBinding const &;
+
+    BindingIterator(std::span<const VkDescriptorSetLayoutBinding> bindings,
+                    std::span<const VkDescriptorBindingFlags> bindingFlags,
+                    size_t index) noexcept
+        : m_bindings(bindings), m_bindingFlags(bindingFlags), m_index(index) {
+      m_load();
+    }
+
+    reference operator*() const noexcept { return *m_current; }
+
+    pointer operator->() const noexcept { return &*m_current; }
+
+    BindingIterator &operator++() noexcept {
+      ++m_index;
+      m_load();
+      return *this;
+    }
+
+    BindingIterator operator++(int) noexcept {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(BindingIterator const &rhs) const noexcept {
+      return m_index == rhs.m_index;
+    }
+
+  private:
+    void m_load() noexcept {
+      if (m_index < m_bindings.size())
+        m_current.emplace(m_bindings[m_index], m_bindingFlags.empty()
+                                                   ? 0
+                                                   : m_bindingFlags[m_index]);
+    }
+
+    std::span<const VkDescriptorSetLayoutBinding> m_bindings;
+    std::span<const VkDescriptorBindingFlags> m_bindingFlags;
+    size_t m_index;
+    std::optional<DescriptorSetLayoutBinding> m_current;
+  };
 
-  bool operator==(DescriptorSetLayoutInfo const &rhs) const noexcept {
-    if (m_bindings.size() != rhs.m_bindings.size() ||
-        m_createInfo.flags != rhs.m_createInfo.flags)
-      return false;
+  BindingIterator begin() const noexcept {
+    return {m_bindings(), m_bindingFlags(), 0};
+  }
 
-    auto rhsBindingIter = rhs.m_bindings.begin();
-    return std::all_of(
-        m_bindings.begin(), m_bindings.end(),
-        [&rhsBindingIter](DescriptorSetLayoutBinding const &binding) {
-          return binding == *(rhsBindingIter++);
-        });
+  BindingIterator end() const noexcept {
+    return {m_bindings(), m_bindingFlags(), m_bindings().size()};
   }
 
+  bool operator==(DescriptorSetLayoutInfo const &rhs) const noexcept;
+
   bool operator!=(DescriptorSetLayoutInfo const &rhs) const noexcept {
     return !(*this == rhs);
   }
@@ -97,16 +162,45 @@ public:
 
   auto &info() const noexcept { return m_createInfo; }
 
+  // Full count of the binding with
+  // VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT, 0 if there is none.
+  // Sets of the layout are allocated with this many descriptors in it.
+  uint32_t variableDescriptorCount() const noexcept;
+
 private:
-  void m_fillInfo(VkDescriptorSetLayoutCreateFlags flags) noexcept(
+  void m_fillInfo(std::span<DescriptorSetLayoutBinding> bindings,
+                  VkDescriptorSetLayoutCreateFlags flags) noexcept(
       ExceptionsDisabled);
-  boost::container::small_vector<DescriptorSetLayoutBinding, 3> m_bindings;
+  void m_fillInfo(std::span<const VkDescriptorSetLayoutBinding> bindings,
+                  std::span<const VkDescriptorBindingFlags> bindingFlags,
+                  VkDescriptorSetLayoutCreateFlags flags) noexcept;
+
+  // Static layouts are described by their static arrays, others by own
+  // copies. Empty binding flags mean no flags at all.
+  std::span<const VkDescriptorSetLayoutBinding> m_bindings() const noexcept {
+    if (!m_staticBindings.empty())
+      return m_staticBindings;
+    return {m_rawBindings.data(), m_rawBindings.size()};
+  }
+
+  std::span<const VkDescriptorBindingFlags> m_bindingFlags() const noexcept {
+    if (!m_staticBindings.empty())
+      return m_staticBindingFlags;
+    return {m_rawBindingFlags.data(), m_rawBindingFlags.size()};
+  }
+
+  std::span<const VkDescriptorSetLayoutBinding> m_staticBindings;
+  std::span<const VkDescriptorBindingFlags> m_staticBindingFlags;
   boost::container::small_vector<VkDescriptorSetLayoutBinding, 5> m_rawBindings;
+  boost::container::small_vector<VkDescriptorBindingFlags, 5> m_rawBindingFlags;
+  VkDescriptorSetLayoutBindingFlagsCreateInfo m_bindingFlagsInfo{};
   VkDescriptorSetLayoutCreateInfo m_createInfo{};
 };
 
-class DescriptorSetLayout : public DescriptorSetLayoutInfo,
-                            public UniqueVulkanObject<VkDescriptorSetLayout> {
+class DescriptorSetLayout
+    : public DescriptorSetLayoutInfo,
+      public UniqueVulkanObject<VkDescriptorSetLayout>,
+      public std::enable_shared_from_this<DescriptorSetLayout> {
 public:
   template <forward_range_of<DescriptorSetLayoutBinding> T>
   DescriptorSetLayout(
@@ -115,6 +209,21 @@ public:
       : DescriptorSetLayoutInfo(bindings, flags),
         UniqueVulkanObject<VkDescriptorSetLayout>(device, info()) {}
 
+  template <StaticSetLayoutLike T>
+  DescriptorSetLayout(
+      Device const &device, T layout,
+      VkDescriptorSetLayoutCreateFlags flags = 0) noexcept(ExceptionsDisabled)
+      : DescriptorSetLayoutInfo(layout, flags),
+        UniqueVulkanObject<VkDescriptorSetLayout>(device, info()) {}
+
+  // Bytes a set of this layout takes in a descriptor buffer. Layout must be
+  // created with VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT.
+  VkDeviceSize descriptorBufferSize() const noexcept(ExceptionsDisabled);
+
+  // Offset of the binding from the start of the set in a descriptor buffer.
+  VkDeviceSize
+  descriptorBufferOffset(uint32_t binding) const noexcept(ExceptionsDisabled);
+
   bool operator==(DescriptorSetLayout const &rhs) const noexcept {
     return DescriptorSetLayoutInfo::operator==(rhs);
   }
@@ -211,5 +320,69 @@ private:
   StrongReference<DescriptorSetLayout const> m_layout;
   VkDescriptorSet m_set{};
 };
+/**
+ * @class PushDescriptorSet
+ *
+ * @brief Descriptor writes recorded straight into a command buffer with
+ * CommandBuffer::pushDescriptorSet() instead of being written to an allocated
+ * DescriptorSet.
+ *
+ * Set layout must be created with
+ * VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR and
+ * VK_KHR_push_descriptor must be enabled on device. Writes accept the same
+ * resources as DescriptorSet::write(). Object can be cleared and reused for
+ * the next draw.
+ */
+class PushDescriptorSet {
+public:
+  void write(uint32_t binding, BufferBase const &buffer, VkDescriptorType type,
+             VkDeviceSize offset = 0,
+             VkDeviceSize range = VK_WHOLE_SIZE) noexcept(ExceptionsDisabled);
+
+  template <typename T>
+  void write(uint32_t binding, UniformBuffer<T> const &uniformBuffer) noexcept(
+      ExceptionsDisabled) {
+    write(binding, uniformBuffer, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
+          sizeof(T));
+  }
+
+  template <typename T>
+  void write(uint32_t binding, StorageBuffer<T> const &storageBuffer) noexcept(
+      ExceptionsDisabled) {
+    write(binding, storageBuffer, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0,
+          sizeof(T));
+  }
+
+  void write(uint32_t binding, ImageViewBase const &image, VkImageLayout layout,
+             Sampler const &sampler) noexcept(ExceptionsDisabled);
+
+  void writeStorageImage(
+      uint32_t binding, ImageViewBase const &image,
+      VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL) noexcept(
+      ExceptionsDisabled);
+
+  size_t size() const noexcept { return m_entries.size(); }
+
+  bool empty() const noexcept { return m_entries.empty(); }
+
+  void clear() noexcept { m_entries.clear(); }
+
+private:
+  friend class CommandBuffer;
+
+  struct Entry {
+    uint32_t binding;
+    VkDescriptorType type;
+    VkDescriptorBufferInfo bufferInfo;
+    VkDescriptorImageInfo imageInfo;
+  };
+
+  // Write structures pointing into entries, valid until next modification.
+  boost::container::small_vector<VkWriteDescriptorSet, 4>
+  m_writes() const noexcept(ExceptionsDisabled);
+
+  boost::container::small_vector<Entry, 4> m_entries;
+};
+
 } // namespace vkw
 #endif // VKWRAPPER_DESCRIPTORSET_HPP
@@ -0,0 +1,193 @@
+#ifndef VKWRAPPER_DESCRIPTORSETCACHE_HPP
+#define VKWRAPPER_DESCRIPTORSETCACHE_HPP
+
+#include <vkw/DescriptorAllocator.hpp>
+#include <vkw/DescriptorWriter.hpp>
+
+#include <array>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace vkw {
+
+/**
+ * @class DescriptorSetCache
+ *
+ * @brief Hands out already written descriptor sets keyed by their layout and
+ * contents.
+ *
+ * Draws binding the same resources share one set: get() hashes the layout
+ * and the described bindings, and only on a miss takes a set (recycled or
+ * from an internal DescriptorAllocator) and writes it.
+ *
+ * Entries not used for maxUnusedFrames frames are evicted in beginFrame(),
+ * least recently used first, and their sets are recycled. Entries
+ * referencing a destroyed buffer, image view, sampler or set layout are
+ * dropped automatically: the cache observes the device's DeletionQueue.
+ * Their sets are recycled once frames in flight can no longer use them.
+ *
+ * Sets of a destroyed layout can't be reused for other layouts. Once they
+ * take up half of the sets allocated, beginFrame() drops every entry and
+ * switches to a second allocator; the first one is reset as soon as frames
+ * in flight are done with its sets. Layout churn thus costs one rewrite of
+ * the live entries instead of leaking pool memory.
+ *
+ * get() and beginFrame() must be called from one thread. Resources may be
+ * destroyed from any thread.
+ */
+class DescriptorSetCache {
+public:
+  // Bindings of a set, the key of the cache. Order of writes doesn't matter.
+  class Contents {
+  public:
+    void write(uint32_t binding, BufferBase const &buffer,
+               VkDescriptorType type, VkDeviceSize offset = 0,
+               VkDeviceSize range = VK_WHOLE_SIZE) noexcept(ExceptionsDisabled);
+
+    template <typename T>
+    void write(uint32_t binding,
+               UniformBuffer<T> const &uniformBuffer) noexcept(
+        ExceptionsDisabled) {
+      write(binding, uniformBuffer, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
+            sizeof(T));
+    }
+
+    template <typename T>
+    void write(uint32_t binding,
+               StorageBuffer<T> const &storageBuffer) noexcept(
+        ExceptionsDisabled) {
+      write(binding, storageBuffer, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0,
+            sizeof(T));
+    }
+
+    void write(uint32_t binding, ImageViewBase const &image,
+               VkImageLayout layout,
+               Sampler const &sampler) noexcept(ExceptionsDisabled);
+
+    void writeStorageImage(
+        uint32_t binding, ImageViewBase const &image,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL) noexcept(
+        ExceptionsDisabled);
+
+    void clear() noexcept { m_entries.clear(); }
+
+    size_t hash() const noexcept;
+
+    bool operator==(Contents const &rhs) const noexcept;
+
+  private:
+    friend class DescriptorSetCache;
+
+    struct Entry {
+      uint32_t binding;
+      VkDescriptorType type;
+      VkDescriptorBufferInfo bufferInfo;
+      VkDescriptorImageInfo imageInfo;
+    };
+
+    // Keeps entries sorted by binding, replacing an existing one.
+    Entry &m_entry(uint32_t binding) noexcept(ExceptionsDisabled);
+
+    // Handles must be sorted.
+    bool m_referencesAny(std::span<const uint64_t> handles) const noexcept;
+
+    boost::container::small_vector<Entry, 4> m_entries;
+  };
+
+  struct Statistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;
+    // Switches of allocators reclaiming sets of destroyed layouts
+    uint64_t recycles = 0;
+  };
+
+  DescriptorSetCache(
+      Device const &device, uint32_t framesInFlight,
+      uint32_t maxUnusedFrames = 8,
+      std::span<const VkDescriptorPoolSize> ratios =
+          DescriptorAllocator::DefaultRatios) noexcept(ExceptionsDisabled);
+
+  DescriptorSetCache(DescriptorSetCache const &another) = delete;
+  DescriptorSetCache &operator=(DescriptorSetCache const &another) = delete;
+
+  ~DescriptorSetCache();
+
+  // Written set with given contents, valid for use in the current frame.
+  VkDescriptorSet get(DescriptorSetLayout const &layout,
+                      Contents const &contents) noexcept(ExceptionsDisabled);
+
+  // Advances the frame counter and evicts stale entries.
+  void beginFrame() noexcept(ExceptionsDisabled);
+
+  size_t size() const noexcept { return m_index.size(); }
+
+  Statistics const &statistics() const noexcept { return m_statistics; }
+
+  void resetStatistics() noexcept { m_statistics = {}; }
+
+private:
+  struct Node {
+    VkDescriptorSetLayout layout;
+    Contents contents;
+    size_t hash;
+    VkDescriptorSet set;
+    uint64_t lastUsedFrame;
+  };
+
+  using NodeList = std::list<Node>;
+
+  // Sets of dropped entries waiting for their frames to complete
+  struct Retired {
+    VkDescriptorSetLayout layout;
+    VkDescriptorSet set;
+    uint64_t lastUsedFrame;
+  };
+
+  void m_processDestroyed() noexcept(ExceptionsDisabled);
+
+  void m_erase(NodeList::iterator node) noexcept(ExceptionsDisabled);
+
+  VkDescriptorSet
+  m_acquireSet(DescriptorSetLayout const &layout) noexcept(ExceptionsDisabled);
+
+  // Drops all sets and moves to the other allocator.
+  void m_recycle() noexcept;
+
+  DescriptorAllocator &m_allocator() noexcept {
+    return m_allocators[m_generation % 2];
+  }
+
+  StrongReference<Device const> m_device;
+  std::array<DescriptorAllocator, 2> m_allocators;
+  uint64_t m_generation = 0;
+  // Sets of destroyed layouts allocated from the current allocator
+  uint32_t m_orphanedSets = 0;
+  // Last frame using the previous allocator, if it's not reset yet
+  std::optional<uint64_t> m_drainFrame;
+  DescriptorWriter m_writer;
+  uint32_t m_framesInFlight;
+  uint32_t m_maxUnusedFrames;
+  uint64_t m_frame = 0;
+
+  // Most recently used entries first
+  NodeList m_nodes;
+  std::unordered_multimap<size_t, NodeList::iterator> m_index;
+  std::vector<Retired> m_retired;
+  std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>>
+      m_freeSets;
+
+  uint64_t m_observerId;
+  std::mutex m_destroyedMutex;
+  std::vector<uint64_t> m_destroyed;
+  std::atomic<bool> m_hasDestroyed = false;
+
+  Statistics m_statistics;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_DESCRIPTORSETCACHE_HPP
@@ -0,0 +1,141 @@
+#ifndef VKWRAPPER_DESCRIPTORUPDATETEMPLATE_HPP
+#define VKWRAPPER_DESCRIPTORUPDATETEMPLATE_HPP
+
+#include <vkw/DescriptorSet.hpp>
+
+#include <span>
+#include <type_traits>
+
+namespace vkw {
+
+class PipelineLayout;
+
+/**
+ * @class DescriptorUpdateTemplate
+ *
+ * @brief Updates all bindings of a descriptor set from one packed structure
+ * in a single call.
+ *
+ * Unless entries are given explicitly, they are derived from the set layout:
+ * the structure holds, for every binding in ascending binding order,
+ * descriptorCount consecutive VkDescriptorBufferInfo (buffer descriptors),
+ * VkBufferView (texel buffers) or VkDescriptorImageInfo (everything else).
+ * All three have 8-byte alignment, so a plain struct of these members has no
+ * padding:
+ *
+ *    struct MaterialDescriptors {
+ *      VkDescriptorBufferInfo parameters; // binding 0
+ *      VkDescriptorImageInfo albedo;      // binding 1
+ *    };
+ *
+ * Templates created with a pipeline layout are push descriptor templates and
+ * are used with CommandBuffer::pushDescriptorSet().
+ */
+class DescriptorUpdateTemplate : public ReferenceGuard {
+public:
+  DescriptorUpdateTemplate(
+      Device const &device, DescriptorSetLayout const &layout,
+      std::span<const VkDescriptorUpdateTemplateEntry> entries = {}) noexcept(
+      ExceptionsDisabled);
+
+  // Push descriptor template for set number `set` of the pipeline layout,
+  // setLayout must be the layout of that set.
+  DescriptorUpdateTemplate(
+      Device const &device, DescriptorSetLayout const &setLayout,
+      PipelineLayout const &pipelineLayout, VkPipelineBindPoint bindPoint,
+      uint32_t set,
+      std::span<const VkDescriptorUpdateTemplateEntry> entries = {}) noexcept(
+      ExceptionsDisabled);
+
+  DescriptorUpdateTemplate(DescriptorUpdateTemplate const &another) = delete;
+  DescriptorUpdateTemplate &
+  operator=(DescriptorUpdateTemplate const &another) = delete;
+
+  DescriptorUpdateTemplate(DescriptorUpdateTemplate &&another) noexcept
+      : m_device(another.m_device), m_layout(another.m_layout),
+        m_template(another.m_template), m_dataSize(another.m_dataSize),
+        m_bindPoint(another.m_bindPoint),
+        m_pipelineLayout(another.m_pipelineLayout), m_set(another.m_set) {
+    another.m_template = VK_NULL_HANDLE;
+  }
+
+  DescriptorUpdateTemplate &
+  operator=(DescriptorUpdateTemplate &&another) noexcept {
+    m_device = another.m_device;
+    m_layout = another.m_layout;
+    m_dataSize = another.m_dataSize;
+    m_bindPoint = another.m_bindPoint;
+    m_pipelineLayout = another.m_pipelineLayout;
+    m_set = another.m_set;
+    std::swap(m_template, another.m_template);
+    return *this;
+  }
+
+  ~DescriptorUpdateTemplate();
+
+  void update(DescriptorSet const &set,
+              void const *data) const noexcept(ExceptionsDisabled);
+
+  template <typename T>
+  requires std::is_trivially_copyable_v<T> && (!std::is_pointer_v<T>)
+  void update(DescriptorSet const &set,
+              T const &data) const noexcept(ExceptionsDisabled) {
+    m_checkDataSize(sizeof(T));
+    update(set, static_cast<void const *>(&data));
+  }
+
+  // Minimal size of the structure the template reads from.
+  size_t dataSize() const noexcept { return m_dataSize; }
+
+  bool pushDescriptors() const noexcept {
+    return m_pipelineLayout != VK_NULL_HANDLE;
+  }
+
+  VkPipelineBindPoint bindPoint() const noexcept { return m_bindPoint; }
+
+  VkPipelineLayout pipelineLayout() const noexcept { return m_pipelineLayout; }
+
+  uint32_t set() const noexcept { return m_set; }
+
+  DescriptorSetLayout const &layout() const noexcept { return m_layout; }
+
+  operator VkDescriptorUpdateTemplate() const noexcept { return m_template; }
+
+  static VkDescriptorBufferInfo
+  bufferInfo(BufferBase const &buffer, VkDeviceSize offset = 0,
+             VkDeviceSize range = VK_WHOLE_SIZE) noexcept {
+    return {buffer, offset, range};
+  }
+
+  static VkDescriptorImageInfo imageInfo(ImageViewBase const &image,
+                                         VkImageLayout layout,
+                                         Sampler const &sampler) noexcept {
+    return {sampler, image, layout};
+  }
+
+  static VkDescriptorImageInfo
+  storageImageInfo(ImageViewBase const &image,
+                   VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL) noexcept {
+    return {VK_NULL_HANDLE, image, layout};
+  }
+
+private:
+  friend class CommandBuffer;
+
+  void m_create(
+      std::span<const VkDescriptorUpdateTemplateEntry> entries,
+      VkDescriptorUpdateTemplateType type) noexcept(ExceptionsDisabled);
+
+  void m_checkDataSize(size_t size) const noexcept(ExceptionsDisabled);
+
+  StrongReference<Device const> m_device;
+  StrongReference<DescriptorSetLayout const> m_layout;
+  VkDescriptorUpdateTemplate m_template = VK_NULL_HANDLE;
+  size_t m_dataSize = 0;
+  VkPipelineBindPoint m_bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+  uint32_t m_set = 0;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_DESCRIPTORUPDATETEMPLATE_HPP
@@ -0,0 +1,106 @@
+#ifndef VKWRAPPER_DESCRIPTORWRITER_HPP
+#define VKWRAPPER_DESCRIPTORWRITER_HPP
+
+#include <vkw/DescriptorSet.hpp>
+
+#include <vector>
+
+namespace vkw {
+
+/**
+ * @class DescriptorWriter
+ *
+ * @brief Accumulates descriptor writes and copies for any number of sets and
+ * applies them all with one vkUpdateDescriptorSets call.
+ *
+ * Descriptor infos are kept in arenas owned by the writer until commit(), so
+ * writes can be recorded from temporaries. Arenas keep their capacity after
+ * commit(): a writer reused every frame stops allocating once it has seen the
+ * largest batch.
+ *
+ * Sets are taken as raw handles, so both DescriptorSet objects and sets
+ * from DescriptorAllocator can be written. Written sets and resources must
+ * stay alive until commit(). The writer is not thread-safe, use one per
+ * recording thread.
+ */
+class DescriptorWriter {
+public:
+  explicit DescriptorWriter(Device const &device) noexcept;
+
+  DescriptorWriter(DescriptorWriter const &another) = delete;
+  DescriptorWriter &operator=(DescriptorWriter const &another) = delete;
+
+  DescriptorWriter(DescriptorWriter &&another) noexcept = default;
+  DescriptorWriter &operator=(DescriptorWriter &&another) noexcept = default;
+
+  void write(VkDescriptorSet set, uint32_t binding, BufferBase const &buffer,
+             VkDescriptorType type, VkDeviceSize offset = 0,
+             VkDeviceSize range = VK_WHOLE_SIZE) noexcept(ExceptionsDisabled);
+
+  template <typename T>
+  void write(VkDescriptorSet set, uint32_t binding,
+             UniformBuffer<T> const &uniformBuffer) noexcept(
+      ExceptionsDisabled) {
+    write(set, binding, uniformBuffer, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
+          sizeof(T));
+  }
+
+  template <typename T>
+  void write(VkDescriptorSet set, uint32_t binding,
+             StorageBuffer<T> const &storageBuffer) noexcept(
+      ExceptionsDisabled) {
+    write(set, binding, storageBuffer, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0,
+          sizeof(T));
+  }
+
+  void write(VkDescriptorSet set, uint32_t binding, ImageViewBase const &image,
+             VkImageLayout layout,
+             Sampler const &sampler) noexcept(ExceptionsDisabled);
+
+  void writeStorageImage(
+      VkDescriptorSet set, uint32_t binding, ImageViewBase const &image,
+      VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL) noexcept(
+      ExceptionsDisabled);
+
+  // Raw descriptor info overloads, type must match the info kind.
+  void write(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+             VkDescriptorBufferInfo const &bufferInfo) noexcept(
+      ExceptionsDisabled);
+
+  void write(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+             VkDescriptorImageInfo const &imageInfo) noexcept(
+      ExceptionsDisabled);
+
+  void copy(VkDescriptorSet src, uint32_t srcBinding, VkDescriptorSet dst,
+            uint32_t dstBinding,
+            uint32_t descriptorCount = 1) noexcept(ExceptionsDisabled);
+
+  // Applies everything recorded so far in one call and clears the writer.
+  void commit() noexcept;
+
+  // Drops recorded writes and copies without applying them.
+  void clear() noexcept;
+
+  size_t pendingWrites() const noexcept { return m_writes.size(); }
+
+  size_t pendingCopies() const noexcept { return m_copies.size(); }
+
+  bool empty() const noexcept { return m_writes.empty() && m_copies.empty(); }
+
+private:
+  VkWriteDescriptorSet &m_addWrite(VkDescriptorSet set, uint32_t binding,
+                                   VkDescriptorType type) noexcept(
+      ExceptionsDisabled);
+
+  StrongReference<Device const> m_device;
+
+  // Info pointers of writes are only resolved in commit(): arenas may
+  // reallocate while recording.
+  std::vector<VkWriteDescriptorSet> m_writes;
+  std::vector<VkCopyDescriptorSet> m_copies;
+  std::vector<VkDescriptorBufferInfo> m_bufferInfos;
+  std::vector<VkDescriptorImageInfo> m_imageInfos;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_DESCRIPTORWRITER_HPP
@@ -1,6 +1,7 @@
 #ifndef VKRENDERER_DEVICE_HPP
 #define VKRENDERER_DEVICE_HPP
 
+#include <vkw/DeletionQueue.hpp>
 #include <vkw/PhysicalDevice.hpp>
 #include <vkw/UniqueVulkanObject.hpp>
 
@@ -8,6 +9,7 @@
 
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 
@@ -16,6 +18,8 @@ namespace vkw {
 class Instance;
 class BufferBase;
 class Queue;
+class StateCache;
+class CompletionWatcher;
 
 enum class ext;
 
@@ -29,7 +33,13 @@ public:
 
   auto &apiVersion() const noexcept { return m_apiVer; }
 
+  bool isExtensionEnabled(ext extension) const noexcept {
+    return m_enabledExtensions.contains(extension);
+  }
+
 private:
+  void m_chainExtendedFeatures() noexcept(ExceptionsDisabled);
+
   VkDeviceCreateInfo m_createInfo{};
   boost::container::small_vector<VkDeviceQueueCreateInfo, 3> m_queueCreateInfo;
   boost::container::small_vector<const char *, 8> m_enabledExtensionsRaw;
@@ -37,6 +47,17 @@ private:
   PhysicalDevice m_ph_device;
   std::set<ext> m_enabledExtensions;
   ApiVersion m_apiVer;
+
+  // Own copies of extended feature structures chained to m_createInfo.pNext
+  VkPhysicalDeviceSynchronization2Features m_synchronization2Features{};
+  VkPhysicalDeviceTimelineSemaphoreFeatures m_timelineSemaphoreFeatures{};
+  VkPhysicalDeviceMultiDrawFeaturesEXT m_multiDrawFeatures{};
+  VkPhysicalDeviceDescriptorIndexingFeatures m_descriptorIndexingFeatures{};
+  VkPhysicalDeviceBufferDeviceAddressFeatures m_bufferDeviceAddressFeatures{};
+  VkPhysicalDeviceDescriptorBufferFeaturesEXT m_descriptorBufferFeatures{};
+  // Chained instead of the promoted 1.2 structures above when any of its own
+  // features is enabled: the two must not be mixed.
+  VkPhysicalDeviceVulkan12Features m_vulkan12Features{};
 };
 
 class Device : public DeviceInfo, public UniqueVulkanObject<VkDevice> {
@@ -71,8 +92,158 @@ public:
         m_coreDeviceSymbols.get());
   }
 
+  // Also destroys everything pending in deletionQueue().
   void waitIdle() noexcept(ExceptionsDisabled);
 
+  DeletionQueue &deletionQueue() const noexcept { return *m_deletionQueue; }
+
+  // Shared descriptor set layouts, pipeline layouts, samplers and render
+  // passes of this device.
+  StateCache &stateCache() const noexcept { return *m_stateCache; }
+
+  // Watcher thread of this device, started on first use.
+  CompletionWatcher &completionWatcher() const noexcept(ExceptionsDisabled);
+
+  // Synchronization2 commands resolved either from core 1.3 or from
+  // VK_KHR_synchronization2, depending on what is available on this device.
+  struct Synchronization2Symbols {
+    PFN_vkCmdPipelineBarrier2KHR vkCmdPipelineBarrier2 = nullptr;
+    PFN_vkQueueSubmit2KHR vkQueueSubmit2 = nullptr;
+  };
+
+  Synchronization2Symbols const &synchronization2() const
+      noexcept(ExceptionsDisabled) {
+    if (!m_synchronization2Symbols.vkCmdPipelineBarrier2)
+      postError(Error{"Cannot use synchronization2 commands: feature "
+                      "synchronization2 was not enabled on device creation",
+                      ErrorCode::FEATURE_UNSUPPORTED});
+    return m_synchronization2Symbols;
+  }
+
+  // Timeline semaphore commands resolved either from core 1.2 or from
+  // VK_KHR_timeline_semaphore.
+  struct TimelineSemaphoreSymbols {
+    PFN_vkGetSemaphoreCounterValueKHR vkGetSemaphoreCounterValue = nullptr;
+    PFN_vkWaitSemaphoresKHR vkWaitSemaphores = nullptr;
+    PFN_vkSignalSemaphoreKHR vkSignalSemaphore = nullptr;
+  };
+
+  TimelineSemaphoreSymbols const &timelineSemaphore() const
+      noexcept(ExceptionsDisabled) {
+    if (!m_timelineSemaphoreSymbols.vkWaitSemaphores)
+      postError(Error{"Cannot use timeline semaphores: feature "
+                      "timelineSemaphore was not enabled on device creation",
+                      ErrorCode::FEATURE_UNSUPPORTED});
+    return m_timelineSemaphoreSymbols;
+  }
+
+  // Indirect count draw commands resolved either from core 1.2 or from
+  // VK_KHR_draw_indirect_count, depending on how drawIndirectCount feature
+  // was enabled.
+  struct DrawIndirectCountSymbols {
+    PFN_vkCmdDrawIndirectCountKHR vkCmdDrawIndirectCount = nullptr;
+    PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCount =
+        nullptr;
+  };
+
+  DrawIndirectCountSymbols const &drawIndirectCount() const
+      noexcept(ExceptionsDisabled) {
+    if (!m_drawIndirectCountSymbols.vkCmdDrawIndirectCount)
+      postError(Error{"Cannot use indirect count draws: feature "
+                      "drawIndirectCount was not enabled on device creation",
+                      ErrorCode::FEATURE_UNSUPPORTED});
+    return m_drawIndirectCountSymbols;
+  }
+
+  // VK_EXT_multi_draw commands, available if multiDraw feature is enabled.
+  struct MultiDrawSymbols {
+    PFN_vkCmdDrawMultiEXT vkCmdDrawMultiEXT = nullptr;
+    PFN_vkCmdDrawMultiIndexedEXT vkCmdDrawMultiIndexedEXT = nullptr;
+  };
+
+  MultiDrawSymbols const &multiDraw() const noexcept(ExceptionsDisabled) {
+    if (!m_multiDrawSymbols.vkCmdDrawMultiEXT)
+      postError(Error{"Cannot use multi draw commands: feature multiDraw was "
+                      "not enabled on device creation",
+                      ErrorCode::FEATURE_UNSUPPORTED});
+    return m_multiDrawSymbols;
+  }
+
+  // VK_KHR_push_descriptor commands, available if the extension is enabled.
+  // Template variant also requires descriptor update templates.
+  struct PushDescriptorSymbols {
+    PFN_vkCmdPushDescriptorSetKHR vkCmdPushDescriptorSet = nullptr;
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR
+        vkCmdPushDescriptorSetWithTemplate = nullptr;
+  };
+
+  PushDescriptorSymbols const &pushDescriptor() const
+      noexcept(ExceptionsDisabled) {
+    if (!m_pushDescriptorSymbols.vkCmdPushDescriptorSet)
+      postError(Error{"Cannot use push descriptors: VK_KHR_push_descriptor "
+                      "was not enabled on device creation",
+                      ErrorCode::EXTENSION_MISSING});
+    return m_pushDescriptorSymbols;
+  }
+
+  // Descriptor update template commands resolved either from core 1.1 or
+  // from VK_KHR_descriptor_update_template.
+  struct DescriptorUpdateTemplateSymbols {
+    PFN_vkCreateDescriptorUpdateTemplateKHR vkCreateDescriptorUpdateTemplate =
+        nullptr;
+    PFN_vkDestroyDescriptorUpdateTemplateKHR vkDestroyDescriptorUpdateTemplate =
+        nullptr;
+    PFN_vkUpdateDescriptorSetWithTemplateKHR
+        vkUpdateDescriptorSetWithTemplate = nullptr;
+  };
+
+  DescriptorUpdateTemplateSymbols const &descriptorUpdateTemplate() const
+      noexcept(ExceptionsDisabled) {
+    if (!m_descriptorUpdateTemplateSymbols.vkCreateDescriptorUpdateTemplate)
+      postError(Error{"Cannot use descriptor update templates: neither core "
+                      "1.1 is loaded nor VK_KHR_descriptor_update_template is "
+                      "enabled",
+                      ErrorCode::EXTENSION_MISSING});
+    return m_descriptorUpdateTemplateSymbols;
+  }
+
+  // Buffer device address query resolved either from core 1.2 or from
+  // VK_KHR_buffer_device_address.
+  struct BufferDeviceAddressSymbols {
+    PFN_vkGetBufferDeviceAddressKHR vkGetBufferDeviceAddress = nullptr;
+  };
+
+  BufferDeviceAddressSymbols const &bufferDeviceAddress() const
+      noexcept(ExceptionsDisabled) {
+    if (!m_bufferDeviceAddressSymbols.vkGetBufferDeviceAddress)
+      postError(Error{"Cannot query buffer device addresses: feature "
+                      "bufferDeviceAddress was not enabled on device creation",
+                      ErrorCode::FEATURE_UNSUPPORTED});
+    return m_bufferDeviceAddressSymbols;
+  }
+
+  // VK_EXT_descriptor_buffer commands, available if descriptorBuffer feature
+  // is enabled.
+  struct DescriptorBufferSymbols {
+    PFN_vkGetDescriptorSetLayoutSizeEXT vkGetDescriptorSetLayoutSizeEXT =
+        nullptr;
+    PFN_vkGetDescriptorSetLayoutBindingOffsetEXT
+        vkGetDescriptorSetLayoutBindingOffsetEXT = nullptr;
+    PFN_vkGetDescriptorEXT vkGetDescriptorEXT = nullptr;
+    PFN_vkCmdBindDescriptorBuffersEXT vkCmdBindDescriptorBuffersEXT = nullptr;
+    PFN_vkCmdSetDescriptorBufferOffsetsEXT vkCmdSetDescriptorBufferOffsetsEXT =
+        nullptr;
+  };
+
+  DescriptorBufferSymbols const &descriptorBuffer() const
+      noexcept(ExceptionsDisabled) {
+    if (!m_descriptorBufferSymbols.vkGetDescriptorEXT)
+      postError(Error{"Cannot use descriptor buffers: feature "
+                      "descriptorBuffer was not enabled on device creation",
+                      ErrorCode::FEATURE_UNSUPPORTED});
+    return m_descriptorBufferSymbols;
+  }
+
   ~Device() override;
 
 private:
@@ -91,6 +262,22 @@ private:
   FamilyContainerT m_queues;
 
   std::unique_ptr<DeviceCore<1, 0>> m_coreDeviceSymbols;
+  Synchronization2Symbols m_synchronization2Symbols;
+  TimelineSemaphoreSymbols m_timelineSemaphoreSymbols;
+  DrawIndirectCountSymbols m_drawIndirectCountSymbols;
+  MultiDrawSymbols m_multiDrawSymbols;
+  PushDescriptorSymbols m_pushDescriptorSymbols;
+  DescriptorUpdateTemplateSymbols m_descriptorUpdateTemplateSymbols;
+  BufferDeviceAddressSymbols m_bufferDeviceAddressSymbols;
+  DescriptorBufferSymbols m_descriptorBufferSymbols;
+
+  // Flushed while allocator and device symbols are alive
+  std::unique_ptr<DeletionQueue> m_deletionQueue;
+  // Cached objects retire to the deletion queue
+  std::unique_ptr<StateCache> m_stateCache;
+  // Declared last: its thread is joined before anything else goes away
+  mutable std::once_flag m_completionWatcherOnce;
+  mutable std::unique_ptr<CompletionWatcher> m_completionWatcher;
 };
 } // namespace vkw
 #endif // VKRENDERER_DEVICE_HPP
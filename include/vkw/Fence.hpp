@@ -34,9 +34,9 @@ public:
            uint64_t timeout = UINT64_MAX) noexcept(ExceptionsDisabled) {
     boost::container::small_vector<VkFence, 4> fences{};
     for (auto it = begin; it != end; ++it) {
-      fences.push_back((*it).m_fence);
+      fences.push_back((*it).handle());
     }
-    return wait_impl(begin->m_device, fences.data(), fences.size(), false,
+    return wait_impl(begin->parent(), fences.data(), fences.size(), false,
                      timeout);
   }
 
@@ -46,9 +46,9 @@ public:
            uint64_t timeout = UINT64_MAX) noexcept(ExceptionsDisabled) {
     boost::container::small_vector<VkFence, 4> fences{};
     for (auto it = begin; it != end; ++it) {
-      fences.push_back((*it).m_fence);
+      fences.push_back((*it).handle());
     }
-    return wait_impl(begin->m_device, fences.data(), fences.size(), true,
+    return wait_impl(begin->parent(), fences.data(), fences.size(), true,
                      timeout);
   }
 
@@ -0,0 +1,125 @@
+#ifndef VKWRAPPER_FRAMECONTEXT_HPP
+#define VKWRAPPER_FRAMECONTEXT_HPP
+
+#include <vkw/Buffer.hpp>
+#include <vkw/CommandPoolRing.hpp>
+#include <vkw/Queue.hpp>
+#include <vkw/Semaphore.hpp>
+#include <vkw/SwapChain.hpp>
+
+#include <deque>
+#include <optional>
+#include <span>
+
+namespace vkw {
+
+/**
+ * @class FrameContext
+ *
+ * @brief Ring of per-frame resources for rendering with several frames in
+ * flight.
+ *
+ * Every frame slot owns its command pools (through CommandPoolRing), fence,
+ * image acquire and render finish semaphores, and a persistently mapped
+ * upload buffer with a linear allocator. Submit and present structures are
+ * built once per slot and only patched every frame, so after the first
+ * frames beginFrame() / endFrame() don't allocate.
+ *
+ * Frame latency (how many frames CPU may run ahead of GPU) can be lowered at
+ * run time below the number of frame slots.
+ *
+ * Submits directly to its queue, so the queue must not be owned by a
+ * SubmissionQueue.
+ */
+class FrameContext {
+public:
+  // Part of the current frame's upload buffer.
+  struct UploadRegion {
+    std::span<unsigned char> data;
+    BufferBase const &buffer;
+    VkDeviceSize offset;
+  };
+
+  FrameContext(Device &device, Queue const &queue, SwapChain &swapChain,
+               uint32_t framesInFlight, VkDeviceSize uploadSize = 0,
+               VkBufferUsageFlags uploadUsage =
+                   VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+               uint32_t threadCount = 1) noexcept(ExceptionsDisabled);
+
+  FrameContext(FrameContext const &another) = delete;
+  FrameContext &operator=(FrameContext const &another) = delete;
+
+  // Waits until the frame slot is free and acquires next swap chain image.
+  // Frame is not begun unless SUCCESSFUL or SUBOPTIMAL is returned.
+  SwapChain::AcquireStatus
+  beginFrame(uint64_t timeout = UINT64_MAX) noexcept(ExceptionsDisabled);
+
+  // Submits all command buffers handed out by commandBuffer() in order of
+  // their acquisition and presents the image. Returns false if the swap chain
+  // is out of date.
+  bool endFrame(VkPipelineStageFlags waitStage =
+                    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT) noexcept(
+      ExceptionsDisabled);
+
+  // New primary command buffer of the current frame, submitted by endFrame().
+  // Must be called from the thread recording for the primary command pool.
+  PrimaryCommandBuffer &commandBuffer() noexcept(ExceptionsDisabled);
+
+  // Sub-allocates current frame's upload buffer. Only valid between
+  // beginFrame() and endFrame().
+  UploadRegion upload(VkDeviceSize size, VkDeviceSize alignment = 16) noexcept(
+      ExceptionsDisabled);
+
+  // Swap chain must be replaced after it went out of date.
+  void setSwapChain(SwapChain &swapChain) noexcept(ExceptionsDisabled);
+
+  void setFrameLatency(uint32_t latency) noexcept(ExceptionsDisabled);
+
+  uint32_t frameLatency() const noexcept { return m_latency; }
+
+  uint32_t framesInFlight() const noexcept { return m_frames.size(); }
+
+  uint64_t frameNumber() const noexcept { return m_frameNumber; }
+
+  uint32_t imageIndex() const noexcept(ExceptionsDisabled) {
+    return m_swapChain.get().currentImage();
+  }
+
+  CommandPoolRing &commandPools() noexcept { return m_commandPools; }
+
+private:
+  struct Frame {
+    Frame(Device &device, VkDeviceSize uploadSize,
+          VkBufferUsageFlags uploadUsage) noexcept(ExceptionsDisabled);
+
+    Semaphore imageAcquired;
+    Semaphore renderFinished;
+    std::optional<Buffer<unsigned char>> uploadBuffer;
+    VkDeviceSize uploadOffset = 0;
+
+    // Storage pointed to by submitInfo
+    VkSemaphore waitSemaphore;
+    VkSemaphore signalSemaphore;
+    VkPipelineStageFlags waitStage = 0;
+    boost::container::small_vector<VkCommandBuffer, 4> commandBuffers;
+    VkSubmitInfo submitInfo{};
+
+    // Built on first present: swap chain has no current image before that
+    std::optional<PresentInfo> presentInfo;
+  };
+
+  Frame &m_current() noexcept {
+    return m_frames[m_commandPools.currentFrame()];
+  }
+
+  std::reference_wrapper<Queue const> m_queue;
+  std::reference_wrapper<SwapChain> m_swapChain;
+  CommandPoolRing m_commandPools;
+  std::deque<Frame> m_frames;
+  uint32_t m_latency;
+  uint64_t m_frameNumber = 0;
+  bool m_frameBegun = false;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_FRAMECONTEXT_HPP
@@ -0,0 +1,322 @@
+#ifndef VKWRAPPER_FRAMEGRAPH_HPP
+#define VKWRAPPER_FRAMEGRAPH_HPP
+
+#include <vkw/CommandBuffer.hpp>
+#include <vkw/Image.hpp>
+#include <vkw/ResourceTracker.hpp>
+
+#include <boost/container/small_vector.hpp>
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace vkw {
+
+/**
+ * @class FrameGraph
+ *
+ * @brief Describes a frame as a sequence of passes that read and write
+ * images and buffers and records it into primary command buffers.
+ *
+ * Passes are declared in submission order. Each pass declares every access
+ * to graph resources together with the layout, pipeline stage and access
+ * mask it requires and supplies a callback that records the actual work
+ * (render passes, pipeline binds, draws, dispatches, copies).
+ *
+ * compile() culls passes that contribute neither to imported resources nor
+ * to passes marked with sideEffect(), computes the barriers and layout
+ * transitions needed before each remaining pass and assigns transient images
+ * from an internal pool. Transient images with equal description and
+ * disjoint lifetimes share the same pooled image. If the structure of the
+ * graph didn't change since the last compile() the previous result is
+ * reused, so rebuilding the same graph every frame is cheap.
+ *
+ * Layout transitions are performed by the graph: render passes recorded by
+ * pass callbacks must use the declared layout of their attachments as both
+ * initial and final layout.
+ *
+ * Transient images are reused every time the graph is executed. Execution
+ * of a frame must not overlap with a previous execution that is still in
+ * flight; use one FrameGraph per frame in flight otherwise.
+ */
+class FrameGraph {
+public:
+  struct ImageHandle {
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+
+    bool valid() const noexcept {
+      return index != std::numeric_limits<uint32_t>::max();
+    }
+
+    bool operator==(ImageHandle const &another) const noexcept = default;
+  };
+
+  struct BufferHandle {
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+
+    bool valid() const noexcept {
+      return index != std::numeric_limits<uint32_t>::max();
+    }
+
+    bool operator==(BufferHandle const &another) const noexcept = default;
+  };
+
+  struct TransientImageInfo {
+    ImagePixelType pixelType = COLOR;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Usage implied by declared accesses is added automatically: shader
+    // writes imply STORAGE, other shader reads imply SAMPLED. Storage images
+    // that shaders only read must request STORAGE here.
+    VkImageUsageFlags usage = 0;
+
+    bool operator==(TransientImageInfo const &another) const noexcept =
+        default;
+  };
+
+  class Resources {
+  public:
+    ImageInterface const &
+    image(ImageHandle handle) const noexcept(ExceptionsDisabled);
+
+    // Concrete type of transient image. Useful to create image views and
+    // frame buffers for it. Cached views stay valid while generation() of
+    // the graph stays the same.
+    template <ImagePixelType ptype>
+    Image<ptype, I2D> const &
+    transientImage(ImageHandle handle) const noexcept(ExceptionsDisabled);
+
+    BufferBase const &
+    buffer(BufferHandle handle) const noexcept(ExceptionsDisabled);
+
+  private:
+    friend class FrameGraph;
+    explicit Resources(FrameGraph const &graph) noexcept : m_graph(graph) {}
+
+    FrameGraph const &m_graph;
+  };
+
+  using RecordCallback =
+      std::function<void(PrimaryCommandBuffer &, Resources const &)>;
+
+  class PassBuilder {
+  public:
+    PassBuilder &read(ImageHandle image, VkImageLayout layout,
+                      VkPipelineStageFlags stage,
+                      VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+    PassBuilder &write(ImageHandle image, VkImageLayout layout,
+                       VkPipelineStageFlags stage,
+                       VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+    PassBuilder &read(BufferHandle buffer, VkPipelineStageFlags stage,
+                      VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+    PassBuilder &write(BufferHandle buffer, VkPipelineStageFlags stage,
+                       VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+    // Pass is never culled, even if nothing reads its results.
+    PassBuilder &sideEffect() noexcept;
+
+  private:
+    friend class FrameGraph;
+    PassBuilder(FrameGraph &graph, uint32_t index) noexcept
+        : m_graph(graph), m_index(index) {}
+
+    FrameGraph &m_graph;
+    uint32_t m_index;
+  };
+
+  explicit FrameGraph(Device const &device) noexcept;
+
+  FrameGraph(FrameGraph const &another) = delete;
+  FrameGraph &operator=(FrameGraph const &another) = delete;
+
+  // Imported resources are considered visible outside of the graph: passes
+  // writing them are never culled. If finalLayout is not
+  // VK_IMAGE_LAYOUT_UNDEFINED, the image is transitioned to it after the
+  // last pass.
+  ImageHandle importImage(
+      ImageInterface const &image, VkImageLayout currentLayout,
+      VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED) noexcept(
+      ExceptionsDisabled);
+
+  BufferHandle
+  importBuffer(BufferBase const &buffer) noexcept(ExceptionsDisabled);
+
+  ImageHandle createImage(TransientImageInfo const &info) noexcept(
+      ExceptionsDisabled);
+
+  PassBuilder addPass(std::string_view name,
+                      RecordCallback callback) noexcept(ExceptionsDisabled);
+
+  // Clears graph description. Compiled schedule and transient images are
+  // kept to be reused if the same graph is built again.
+  void reset() noexcept;
+
+  void compile() noexcept(ExceptionsDisabled);
+
+  // Records all scheduled passes into command buffer which must be in
+  // recording state and outside of any render pass.
+  void execute(PrimaryCommandBuffer &commandBuffer) const
+      noexcept(ExceptionsDisabled);
+
+  // Splits scheduled passes into contiguous chunks, one per command buffer.
+  // Command buffers must be submitted in the same order to the same queue.
+  template <std::ranges::forward_range T>
+  requires std::convertible_to<std::ranges::range_reference_t<T>,
+                               PrimaryCommandBuffer &>
+  void execute(T &&commandBuffers) const noexcept(ExceptionsDisabled) {
+    auto count = std::ranges::distance(commandBuffers);
+    if (count == 0)
+      postError(Error("FrameGraph: no command buffers to execute into"));
+
+    m_checkCompiled();
+
+    size_t passCount = m_schedule.size();
+    size_t position = 0;
+    size_t chunk = 0;
+    PrimaryCommandBuffer *last = nullptr;
+    for (PrimaryCommandBuffer &commandBuffer : commandBuffers) {
+      size_t end = passCount * ++chunk / count;
+      m_record(commandBuffer, position, end);
+      position = end;
+      last = &commandBuffer;
+    }
+    m_recordFinal(*last);
+  }
+
+  // Names of passes that survived culling in execution order.
+  std::vector<std::string_view> scheduledPasses() const
+      noexcept(ExceptionsDisabled);
+
+  // Incremented each time compile() produces a new schedule. Objects
+  // created from transient images must be recreated when it changes.
+  uint64_t generation() const noexcept { return m_generation; }
+
+  // Releases pooled transient images not used by the current schedule.
+  // GPU must not use any of them at this point.
+  void trimTransientPool() noexcept;
+
+private:
+  enum class ResourceKind { Image, Buffer };
+
+  struct Access {
+    ResourceKind kind;
+    uint32_t index;
+    VkImageLayout layout;
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    bool read;
+    bool write;
+
+    bool operator==(Access const &another) const noexcept = default;
+  };
+
+  struct PassDesc {
+    std::string name;
+    boost::container::small_vector<Access, 4> accesses;
+    bool sideEffect = false;
+
+    bool operator==(PassDesc const &another) const noexcept = default;
+  };
+
+  struct ImageDesc {
+    ImageInterface const *imported = nullptr;
+    VkImage handle = VK_NULL_HANDLE;
+    VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    TransientImageInfo info{};
+
+    bool operator==(ImageDesc const &another) const noexcept = default;
+  };
+
+  struct BufferDesc {
+    BufferBase const *buffer;
+    VkBuffer handle;
+
+    bool operator==(BufferDesc const &another) const noexcept = default;
+  };
+
+  struct Structure {
+    std::vector<PassDesc> passes;
+    std::vector<ImageDesc> images;
+    std::vector<BufferDesc> buffers;
+
+    bool operator==(Structure const &another) const noexcept = default;
+  };
+
+  using TransientImage =
+      std::variant<std::unique_ptr<Image<COLOR, I2D>>,
+                   std::unique_ptr<Image<DEPTH, I2D>>,
+                   std::unique_ptr<Image<DEPTH_STENCIL, I2D>>>;
+
+  struct PooledImage {
+    TransientImageInfo info;
+    TransientImage image;
+  };
+
+  void m_addAccess(uint32_t pass, Access access) noexcept(ExceptionsDisabled);
+
+  void m_cull() noexcept(ExceptionsDisabled);
+
+  void m_assignTransientImages() noexcept(ExceptionsDisabled);
+
+  void m_computeBarriers() noexcept(ExceptionsDisabled);
+
+  ImageInterface const &
+  m_image(uint32_t index) const noexcept(ExceptionsDisabled);
+
+  void m_checkCompiled() const noexcept(ExceptionsDisabled);
+
+  void m_record(PrimaryCommandBuffer &commandBuffer, size_t begin,
+                size_t end) const noexcept(ExceptionsDisabled);
+
+  void m_recordFinal(PrimaryCommandBuffer &commandBuffer) const
+      noexcept(ExceptionsDisabled);
+
+  static void
+  m_recordBarriers(PrimaryCommandBuffer &commandBuffer,
+                   ResourceTracker::PendingBarriers const &barriers) noexcept;
+
+  StrongReference<Device const> m_device;
+
+  Structure m_structure;
+  std::vector<RecordCallback> m_callbacks;
+  bool m_dirty = true;
+
+  // Compilation results
+  Structure m_compiledStructure;
+  bool m_compiled = false;
+  uint64_t m_generation = 0;
+  std::vector<uint32_t> m_schedule;
+  std::vector<ResourceTracker::PendingBarriers> m_barriers;
+  ResourceTracker::PendingBarriers m_finalBarriers;
+  // Index into m_pool for every transient image or -1 if culled
+  std::vector<int32_t> m_transientAssignment;
+  std::vector<PooledImage> m_pool;
+};
+
+template <ImagePixelType ptype>
+Image<ptype, I2D> const &FrameGraph::Resources::transientImage(
+    ImageHandle handle) const noexcept(ExceptionsDisabled) {
+  if (handle.index >= m_graph.m_transientAssignment.size() ||
+      m_graph.m_transientAssignment[handle.index] < 0)
+    postError(Error("FrameGraph: image is not an allocated transient image"));
+
+  auto &pooled = m_graph.m_pool.at(m_graph.m_transientAssignment[handle.index]);
+  auto *image = std::get_if<std::unique_ptr<Image<ptype, I2D>>>(&pooled.image);
+  if (!image)
+    postError(Error("FrameGraph: transient image pixel type mismatch"));
+
+  return **image;
+}
+
+} // namespace vkw
+#endif // VKWRAPPER_FRAMEGRAPH_HPP
@@ -0,0 +1,33 @@
+#ifndef VKWRAPPER_INDIRECTBUFFER_HPP
+#define VKWRAPPER_INDIRECTBUFFER_HPP
+
+#include <vkw/Buffer.hpp>
+
+#include <concepts>
+
+namespace vkw {
+
+/** @Concept: Element of a buffer consumed by indirect draw or dispatch
+ * commands. Types derived from command structs may carry additional per-draw
+ * data, elements are then read with sizeof(T) stride. */
+template <typename T>
+concept IndirectCommand = std::derived_from<T, VkDrawIndirectCommand> ||
+                          std::derived_from<T, VkDrawIndexedIndirectCommand> ||
+                          std::derived_from<T, VkDispatchIndirectCommand>;
+
+/** @template: Buffer of indirect commands or of draw counts (uint32_t) */
+template <typename T>
+requires IndirectCommand<T> || std::same_as<T, uint32_t>
+class IndirectBuffer : public Buffer<T> {
+public:
+  IndirectBuffer(Device &device, uint64_t count,
+                 VmaAllocationCreateInfo const &createInfo,
+                 VkBufferUsageFlags usage = 0,
+                 SharingInfo const &sharingInfo = {}) noexcept(
+      ExceptionsDisabled)
+      : Buffer<T>(device, count, usage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                  createInfo, sharingInfo) {}
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_INDIRECTBUFFER_HPP
@@ -0,0 +1,57 @@
+#ifndef VKWRAPPER_PARALLELRECORDER_HPP
+#define VKWRAPPER_PARALLELRECORDER_HPP
+
+#include <vkw/CommandBuffer.hpp>
+#include <vkw/CommandPoolRing.hpp>
+#include <vkw/ThreadPool.hpp>
+
+#include <functional>
+
+namespace vkw {
+
+/**
+ * @class ParallelRecorder
+ *
+ * @brief Records a sequence of work items into secondary command buffers on
+ * ThreadPool workers and executes them from a primary command buffer in
+ * order.
+ *
+ * Worker i allocates its secondaries from CommandPoolRing thread slot
+ * (firstThread + i), so the ring must have at least
+ * firstThread + threadPool.workerCount() thread slots. Slots below
+ * firstThread stay available to the recording thread for primaries.
+ */
+class ParallelRecorder {
+public:
+  // Records items [begin, end) into already begun secondary command buffer.
+  using RecordCallback = std::function<void(SecondaryCommandBuffer &commands,
+                                            size_t begin, size_t end)>;
+
+  ParallelRecorder(CommandPoolRing &ring, ThreadPool &threadPool,
+                   uint32_t firstThread = 1) noexcept(ExceptionsDisabled);
+
+  // Records chunks of draws inside current subpass of primary, which must
+  // have been begun with useSecondary set.
+  void record(PrimaryCommandBuffer &primary, RenderPass const &renderPass,
+              uint32_t subpass, FrameBuffer const &frameBuffer,
+              size_t itemCount, size_t chunkSize,
+              RecordCallback const &callback) noexcept(ExceptionsDisabled);
+
+  // Records chunks of commands outside of render pass instance.
+  void record(PrimaryCommandBuffer &primary, size_t itemCount,
+              size_t chunkSize,
+              RecordCallback const &callback) noexcept(ExceptionsDisabled);
+
+private:
+  void m_record(PrimaryCommandBuffer &primary,
+                VkCommandBufferInheritanceInfo const &inheritance,
+                size_t itemCount, size_t chunkSize,
+                RecordCallback const &callback) noexcept(ExceptionsDisabled);
+
+  CommandPoolRing &m_ring;
+  ThreadPool &m_threadPool;
+  uint32_t m_firstThread;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_PARALLELRECORDER_HPP
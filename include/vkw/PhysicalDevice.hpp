@@ -86,6 +86,30 @@ public:
 #undef VKW_FEATURE_ENTRY
   };
 
+  // Features that are not part of VkPhysicalDeviceFeatures and have to be
+  // queried and enabled through VkPhysicalDeviceFeatures2 pNext chain.
+  enum class extended_feature {
+    synchronization2,
+    timelineSemaphore,
+    multiDraw,
+    bufferDeviceAddress,
+    descriptorBuffer,
+    // Core 1.2 feature if supported, VK_KHR_draw_indirect_count otherwise.
+    // Core path requires api version 1.2 to be requested before enabling.
+    drawIndirectCount,
+    // VkPhysicalDeviceDescriptorIndexingFeatures
+    shaderSampledImageArrayNonUniformIndexing,
+    shaderStorageBufferArrayNonUniformIndexing,
+    shaderStorageImageArrayNonUniformIndexing,
+    descriptorBindingSampledImageUpdateAfterBind,
+    descriptorBindingStorageImageUpdateAfterBind,
+    descriptorBindingStorageBufferUpdateAfterBind,
+    descriptorBindingUpdateUnusedWhilePending,
+    descriptorBindingPartiallyBound,
+    descriptorBindingVariableDescriptorCount,
+    runtimeDescriptorArray
+  };
+
   PhysicalDevice(Instance const &instance,
                  uint32_t id) noexcept(ExceptionsDisabled);
   PhysicalDevice(Instance const &instance,
@@ -136,6 +160,73 @@ public:
 
   void enableFeature(feature feature) noexcept(ExceptionsDisabled);
 
+  bool isFeatureSupported(extended_feature feature) const
+      noexcept(ExceptionsDisabled);
+
+  bool isFeatureEnabled(extended_feature feature) const
+      noexcept(ExceptionsDisabled);
+
+  void enableFeature(extended_feature feature) noexcept(ExceptionsDisabled);
+
+  VkPhysicalDeviceSynchronization2Features const &
+  enabledSynchronization2Features() const noexcept {
+    return m_enabledSynchronization2Features;
+  }
+
+  VkPhysicalDeviceTimelineSemaphoreFeatures const &
+  enabledTimelineSemaphoreFeatures() const noexcept {
+    return m_enabledTimelineSemaphoreFeatures;
+  }
+
+  VkPhysicalDeviceMultiDrawFeaturesEXT const &
+  enabledMultiDrawFeatures() const noexcept {
+    return m_enabledMultiDrawFeatures;
+  }
+
+  // Only filled if VK_EXT_multi_draw is supported
+  VkPhysicalDeviceMultiDrawPropertiesEXT const &
+  multiDrawProperties() const noexcept {
+    return m_multiDrawProperties;
+  }
+
+  VkPhysicalDeviceBufferDeviceAddressFeatures const &
+  enabledBufferDeviceAddressFeatures() const noexcept {
+    return m_enabledBufferDeviceAddressFeatures;
+  }
+
+  VkPhysicalDeviceDescriptorBufferFeaturesEXT const &
+  enabledDescriptorBufferFeatures() const noexcept {
+    return m_enabledDescriptorBufferFeatures;
+  }
+
+  // Only filled if VK_EXT_descriptor_buffer is supported
+  VkPhysicalDeviceDescriptorBufferPropertiesEXT const &
+  descriptorBufferProperties() const noexcept {
+    return m_descriptorBufferProperties;
+  }
+
+  // Only drawIndirectCount is ever enabled here: other features of the
+  // structure are enabled through their own feature structures.
+  VkPhysicalDeviceVulkan12Features const &
+  enabledVulkan12Features() const noexcept {
+    return m_enabledVulkan12Features;
+  }
+
+  // True if any of descriptor indexing extended features is enabled.
+  bool descriptorIndexingEnabled() const noexcept;
+
+  VkPhysicalDeviceDescriptorIndexingFeatures const &
+  enabledDescriptorIndexingFeatures() const noexcept {
+    return m_enabledDescriptorIndexingFeatures;
+  }
+
+  // Only filled if either device supports Vulkan 1.2 or
+  // VK_EXT_descriptor_indexing
+  VkPhysicalDeviceDescriptorIndexingProperties const &
+  descriptorIndexingProperties() const noexcept {
+    return m_descriptorIndexingProperties;
+  }
+
   bool extensionSupported(ext extension) const noexcept(ExceptionsDisabled);
 
   void enableExtension(ext extension) noexcept(ExceptionsDisabled);
@@ -157,6 +248,44 @@ protected:
   VkPhysicalDeviceFeatures m_features{};
   /** @brief Features that have been enabled for use on the physical device */
   VkPhysicalDeviceFeatures m_enabledFeatures{};
+  /** @brief Synchronization2 feature support. Only filled if either device
+   * supports Vulkan 1.3 or VK_KHR_synchronization2 */
+  VkPhysicalDeviceSynchronization2Features m_synchronization2Features{};
+  VkPhysicalDeviceSynchronization2Features
+      m_enabledSynchronization2Features{};
+  /** @brief Timeline semaphore feature support. Only filled if either device
+   * supports Vulkan 1.2 or VK_KHR_timeline_semaphore */
+  VkPhysicalDeviceTimelineSemaphoreFeatures m_timelineSemaphoreFeatures{};
+  VkPhysicalDeviceTimelineSemaphoreFeatures
+      m_enabledTimelineSemaphoreFeatures{};
+  /** @brief Multi draw feature support and limits. Only filled if device
+   * supports VK_EXT_multi_draw */
+  VkPhysicalDeviceMultiDrawFeaturesEXT m_multiDrawFeatures{};
+  VkPhysicalDeviceMultiDrawFeaturesEXT m_enabledMultiDrawFeatures{};
+  VkPhysicalDeviceMultiDrawPropertiesEXT m_multiDrawProperties{};
+  /** @brief Buffer device address feature support. Only filled if either
+   * device supports Vulkan 1.2 or VK_KHR_buffer_device_address */
+  VkPhysicalDeviceBufferDeviceAddressFeatures m_bufferDeviceAddressFeatures{};
+  VkPhysicalDeviceBufferDeviceAddressFeatures
+      m_enabledBufferDeviceAddressFeatures{};
+  /** @brief Descriptor buffer feature support and limits. Only filled if
+   * device supports VK_EXT_descriptor_buffer */
+  VkPhysicalDeviceDescriptorBufferFeaturesEXT m_descriptorBufferFeatures{};
+  VkPhysicalDeviceDescriptorBufferFeaturesEXT
+      m_enabledDescriptorBufferFeatures{};
+  VkPhysicalDeviceDescriptorBufferPropertiesEXT
+      m_descriptorBufferProperties{};
+  /** @brief Descriptor indexing features and limits. Only filled if either
+   * device supports Vulkan 1.2 or VK_EXT_descriptor_indexing */
+  VkPhysicalDeviceDescriptorIndexingFeatures m_descriptorIndexingFeatures{};
+  VkPhysicalDeviceDescriptorIndexingFeatures
+      m_enabledDescriptorIndexingFeatures{};
+  VkPhysicalDeviceDescriptorIndexingProperties
+      m_descriptorIndexingProperties{};
+  /** @brief Vulkan 1.2 features without a structure of their own. Only filled
+   * if device supports Vulkan 1.2 */
+  VkPhysicalDeviceVulkan12Features m_vulkan12Features{};
+  VkPhysicalDeviceVulkan12Features m_enabledVulkan12Features{};
   /** @brief Memory types and heaps of the physical device */
   VkPhysicalDeviceMemoryProperties m_memoryProperties{};
   /** @brief Queue family properties of the physical device */
@@ -166,7 +166,8 @@ private:
  */
 
 class PipelineLayout : public PipelineLayoutInfo,
-                       public UniqueVulkanObject<VkPipelineLayout> {
+                       public UniqueVulkanObject<VkPipelineLayout>,
+                       public std::enable_shared_from_this<PipelineLayout> {
 public:
   explicit PipelineLayout(
       Device const &device,
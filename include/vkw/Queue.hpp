@@ -5,7 +5,11 @@
 #include <vkw/Semaphore.hpp>
 #include <vkw/SwapChain.hpp>
 
+#include <atomic>
 #include <cassert>
+#include <mutex>
+#include <span>
+#include <thread>
 #include <utility>
 
 namespace vkw {
@@ -288,6 +292,132 @@ private:
 
   VkSubmitInfo m_info{};
 };
+
+// Semaphore operation of a synchronization2 submission. Unlike SubmitInfo,
+// every semaphore carries its own stage mask.
+class SemaphoreSubmitInfo {
+public:
+  SemaphoreSubmitInfo(Semaphore const &semaphore,
+                      VkPipelineStageFlags2 stageMask,
+                      uint64_t value = 0) noexcept {
+    m_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    m_info.pNext = nullptr;
+    m_info.semaphore = semaphore;
+    m_info.stageMask = stageMask;
+    m_info.value = value;
+    m_info.deviceIndex = 0;
+  }
+
+  operator VkSemaphoreSubmitInfo() const noexcept { return m_info; }
+
+private:
+  VkSemaphoreSubmitInfo m_info{};
+};
+
+class SubmitInfo2 {
+public:
+  template <forward_range_of<PrimaryCommandBuffer const> PCMDA,
+            forward_range_of<SemaphoreSubmitInfo const> SSIA =
+                boost::container::small_vector<SemaphoreSubmitInfo, 2>>
+  SubmitInfo2(PCMDA const &commandBuffers, SSIA const &waitFor = {},
+              SSIA const &signalTo = {}) noexcept(ExceptionsDisabled)
+      : SubmitInfo2(waitFor, signalTo) {
+    auto commandBufferSub =
+        ranges::make_subrange<PrimaryCommandBuffer const>(commandBuffers);
+    using commandBufferSubT = decltype(commandBufferSub);
+
+    std::transform(commandBufferSub.begin(), commandBufferSub.end(),
+                   std::back_inserter(m_cmd_buffers),
+                   [](auto const &cmd) -> VkCommandBufferSubmitInfo {
+                     return m_cmd_buffer_info(commandBufferSubT::get(cmd));
+                   });
+
+    m_fill_info();
+  }
+
+  template <forward_range_of<SemaphoreSubmitInfo const> SSIA =
+                boost::container::small_vector<SemaphoreSubmitInfo, 2>>
+  SubmitInfo2(PrimaryCommandBuffer const &commandBuffer,
+              SSIA const &waitFor = {},
+              SSIA const &signalTo = {}) noexcept(ExceptionsDisabled)
+      : SubmitInfo2(waitFor, signalTo) {
+    m_cmd_buffers.emplace_back(m_cmd_buffer_info(commandBuffer));
+
+    m_fill_info();
+  }
+
+  template <forward_range_of<SemaphoreSubmitInfo const> SSIA =
+                boost::container::small_vector<SemaphoreSubmitInfo, 2>>
+  SubmitInfo2(SSIA const &waitFor = {},
+              SSIA const &signalTo = {}) noexcept(ExceptionsDisabled) {
+    auto waitForSub = ranges::make_subrange<SemaphoreSubmitInfo const>(waitFor);
+    auto signalToSub =
+        ranges::make_subrange<SemaphoreSubmitInfo const>(signalTo);
+    using SSIASubT = decltype(waitForSub);
+
+    std::transform(waitForSub.begin(), waitForSub.end(),
+                   std::back_inserter(m_wait_semaphores),
+                   [](auto const &smr) -> VkSemaphoreSubmitInfo {
+                     return SSIASubT::get(smr);
+                   });
+    std::transform(signalToSub.begin(), signalToSub.end(),
+                   std::back_inserter(m_signal_semaphores),
+                   [](auto const &smr) -> VkSemaphoreSubmitInfo {
+                     return SSIASubT::get(smr);
+                   });
+
+    m_fill_info();
+  }
+
+  operator VkSubmitInfo2() const noexcept { return m_info; }
+
+  SubmitInfo2(SubmitInfo2 const &another) noexcept(ExceptionsDisabled)
+      : m_cmd_buffers(another.m_cmd_buffers),
+        m_signal_semaphores(another.m_signal_semaphores),
+        m_wait_semaphores(another.m_wait_semaphores) {
+    m_fill_info();
+  }
+  SubmitInfo2(SubmitInfo2 &&another) noexcept
+      : m_cmd_buffers(std::move(another.m_cmd_buffers)),
+        m_signal_semaphores(std::move(another.m_signal_semaphores)),
+        m_wait_semaphores(std::move(another.m_wait_semaphores)) {
+    m_fill_info();
+  }
+
+  SubmitInfo2 &
+  operator=(SubmitInfo2 const &another) noexcept(ExceptionsDisabled) {
+    m_cmd_buffers = another.m_cmd_buffers;
+    m_signal_semaphores = another.m_signal_semaphores;
+    m_wait_semaphores = another.m_wait_semaphores;
+    m_fill_info();
+    return *this;
+  }
+  SubmitInfo2 &operator=(SubmitInfo2 &&another) noexcept {
+    m_cmd_buffers = std::move(another.m_cmd_buffers);
+    m_signal_semaphores = std::move(another.m_signal_semaphores);
+    m_wait_semaphores = std::move(another.m_wait_semaphores);
+    m_fill_info();
+    return *this;
+  }
+
+private:
+  static VkCommandBufferSubmitInfo
+  m_cmd_buffer_info(PrimaryCommandBuffer const &commandBuffer) noexcept;
+
+  boost::container::small_vector<VkCommandBufferSubmitInfo, 2> m_cmd_buffers;
+  boost::container::small_vector<VkSemaphoreSubmitInfo, 2> m_signal_semaphores;
+  boost::container::small_vector<VkSemaphoreSubmitInfo, 2> m_wait_semaphores;
+
+  void m_fill_info() noexcept;
+
+  VkSubmitInfo2 m_info{};
+};
+
+class SubmissionQueue;
+
+// Submits, presents and waits on a queue are serialized by a lock of the
+// queue itself. While a SubmissionQueue owns the queue only its submission
+// thread may submit to it, other threads still may present and wait.
 class Queue {
 public:
   bool present(PresentInfo const &presentInfo) const
@@ -304,6 +434,23 @@ public:
     m_submit(&rawInfo, 1, &fence);
   }
 
+  // Returned awaitable suspends coroutine until fence is signaled and
+  // resumes it on executor.
+  FenceAwaitable submit(SubmitInfo const &info, Fence const &fence,
+                        CompletionWatcher &watcher,
+                        Executor executor = {}) const
+      noexcept(ExceptionsDisabled) {
+    submit(info, fence);
+    return {watcher, fence, std::move(executor)};
+  }
+
+  // Same, waiting on Device::completionWatcher().
+  FenceAwaitable submit(SubmitInfo const &info, Fence const &fence,
+                        Executor executor) const noexcept(ExceptionsDisabled) {
+    return submit(info, fence, m_parent.get().completionWatcher(),
+                  std::move(executor));
+  }
+
   template <forward_range_of<SubmitInfo const> SubmitRange>
   void submit(SubmitRange const &info, Fence const &fence) const
       noexcept(ExceptionsDisabled) {
@@ -331,6 +478,60 @@ public:
     m_submit(m_infos.data(), m_infos.size(), nullptr);
   }
 
+  // Prebuilt infos, for callers that keep their VkSubmitInfo structures
+  // around and only patch them. Empty span only signals the fence.
+  void submit(std::span<VkSubmitInfo const> infos, Fence const &fence) const
+      noexcept(ExceptionsDisabled) {
+    m_submit(infos.data(), infos.size(), &fence);
+  }
+
+  void submit(std::span<VkSubmitInfo const> infos) const
+      noexcept(ExceptionsDisabled) {
+    m_submit(infos.data(), infos.size(), nullptr);
+  }
+
+  // Synchronization2 submission. Requires
+  // PhysicalDevice::extended_feature::synchronization2 to be enabled.
+
+  void submit2(SubmitInfo2 const &info) const noexcept(ExceptionsDisabled) {
+    VkSubmitInfo2 rawInfo = info;
+    m_submit2(&rawInfo, 1, nullptr);
+  }
+
+  void submit2(SubmitInfo2 const &info, Fence const &fence) const
+      noexcept(ExceptionsDisabled) {
+    VkSubmitInfo2 rawInfo = info;
+    m_submit2(&rawInfo, 1, &fence);
+  }
+
+  FenceAwaitable submit2(SubmitInfo2 const &info, Fence const &fence,
+                         CompletionWatcher &watcher,
+                         Executor executor = {}) const
+      noexcept(ExceptionsDisabled) {
+    submit2(info, fence);
+    return {watcher, fence, std::move(executor)};
+  }
+
+  FenceAwaitable submit2(SubmitInfo2 const &info, Fence const &fence,
+                         Executor executor) const
+      noexcept(ExceptionsDisabled) {
+    return submit2(info, fence, m_parent.get().completionWatcher(),
+                   std::move(executor));
+  }
+
+  template <forward_range_of<SubmitInfo2 const> SubmitRange>
+  void submit2(SubmitRange const &info, Fence const &fence) const
+      noexcept(ExceptionsDisabled) {
+    auto infos = m_raw_infos2(info);
+    m_submit2(infos.data(), infos.size(), &fence);
+  }
+
+  template <forward_range_of<SubmitInfo2 const> SubmitRange>
+  void submit2(SubmitRange const &info) const noexcept(ExceptionsDisabled) {
+    auto infos = m_raw_infos2(info);
+    m_submit2(infos.data(), infos.size(), nullptr);
+  }
+
   QueueFamily const &family() const noexcept(ExceptionsDisabled);
 
   unsigned index() const noexcept { return m_queueIndex; }
@@ -347,13 +548,39 @@ private:
         uint32_t queueIndex) noexcept(ExceptionsDisabled);
 
   friend class Device;
+  friend class SubmissionQueue;
+
+  // Posts error if a SubmissionQueue owns the queue and it is not the
+  // calling thread.
+  void m_checkOwner() const noexcept(ExceptionsDisabled);
 
   void m_submit(VkSubmitInfo const *info, size_t infoCount,
                 Fence const *fence) const noexcept(ExceptionsDisabled);
+
+  template <forward_range_of<SubmitInfo2 const> SubmitRange>
+  static auto m_raw_infos2(SubmitRange const &info) noexcept(
+      ExceptionsDisabled) {
+    auto infoSubrange = ranges::make_subrange<SubmitInfo2 const>(info);
+    using infoSubrangeT = decltype(infoSubrange);
+    boost::container::small_vector<VkSubmitInfo2, 3> infos;
+    std::transform(infoSubrange.begin(), infoSubrange.end(),
+                   std::back_inserter(infos),
+                   [](auto const &info) -> VkSubmitInfo2 {
+                     return infoSubrangeT::get(info);
+                   });
+    return infos;
+  }
+
+  void m_submit2(VkSubmitInfo2 const *info, size_t infoCount,
+                 Fence const *fence) const noexcept(ExceptionsDisabled);
   StrongReference<Device> m_parent;
   VkQueue m_queue = VK_NULL_HANDLE;
   uint32_t m_familyIndex;
   uint32_t m_queueIndex;
+  // Vulkan requires external synchronization of queue access
+  mutable std::mutex m_mutex;
+  // Submission thread of the owning SubmissionQueue, if any
+  mutable std::atomic<std::thread::id> m_owner{};
 };
 } // namespace vkw
 #endif // VKRENDERER_QUEUE_HPP
@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <vkw/Exception.hpp>
 
 namespace vkw {
@@ -75,6 +76,29 @@ public:
   virtual ~ReferenceGuard() = default;
 };
 #endif
+namespace internal {
+
+template <typename T>
+concept SharedFromThis = requires(T &object) { object.weak_from_this(); };
+
+// Objects owned by std::shared_ptr and deriving std::enable_shared_from_this
+// are kept alive by strong references to them.
+template <typename T> class ReferenceOwner {
+public:
+  explicit ReferenceOwner(T &) noexcept {}
+};
+
+template <SharedFromThis T> class ReferenceOwner<T> {
+public:
+  explicit ReferenceOwner(T &object) noexcept
+      : m_owner(object.weak_from_this().lock()) {}
+
+private:
+  std::shared_ptr<T> m_owner;
+};
+
+} // namespace internal
+
 /**
  *
  *
@@ -99,26 +123,34 @@ public:
  * U must be derived from T and U& must be implicitly
  * convertible to T&.
  *
+ * If T derives std::enable_shared_from_this and the object is owned by a
+ * shared pointer, the reference shares that ownership too. Objects handed
+ * out by StateCache stay alive as long as anything references them.
+ *
  */
 #ifdef VKW_ENABLE_REFERENCE_GUARD
 template <typename T, typename TBase = T>
 requires std::derived_from<TBase, ReferenceGuard> and
     std::is_base_of_v<TBase, T>
-class StrongReference : public std::reference_wrapper<T> {
+class StrongReference : public std::reference_wrapper<T>,
+                        private internal::ReferenceOwner<T> {
 public:
   template <class U>
   requires std::derived_from<U, T> StrongReference(U &object)
-      : std::reference_wrapper<T>{object} {
+      : std::reference_wrapper<T>{object}, internal::ReferenceOwner<T>{
+                                               object} {
     std::invoke(&TBase::add_reference, static_cast<TBase &>(object));
   }
 
   StrongReference(StrongReference &&another) noexcept
-      : std::reference_wrapper<T>(another) {
+      : std::reference_wrapper<T>(another),
+        internal::ReferenceOwner<T>(std::move(another)) {
     another.m_moved_out = true;
   }
 
   StrongReference(StrongReference const &another)
-      : std::reference_wrapper<T>(another) {
+      : std::reference_wrapper<T>(another),
+        internal::ReferenceOwner<T>(another) {
     std::invoke(&TBase::add_reference,
                 static_cast<TBase &>(std::reference_wrapper<T>::get()));
   }
@@ -131,6 +163,8 @@ public:
                 static_cast<TBase &>(std::reference_wrapper<T>::get()));
     std::swap(static_cast<std::reference_wrapper<T> &>(*this),
               static_cast<std::reference_wrapper<T> &>(another));
+    std::swap(static_cast<internal::ReferenceOwner<T> &>(*this),
+              static_cast<internal::ReferenceOwner<T> &>(another));
     return *this;
   }
 
@@ -157,11 +191,13 @@ private:
 template <typename T, typename TBase = T>
 requires std::derived_from<TBase, ReferenceGuard> and
     std::is_base_of_v<TBase, T>
-class StrongReference : public std::reference_wrapper<T> {
+class StrongReference : public std::reference_wrapper<T>,
+                        private internal::ReferenceOwner<T> {
 public:
   template <class U>
   requires std::derived_from<U, T> StrongReference(U &object)
-      : std::reference_wrapper<T>{object} {}
+      : std::reference_wrapper<T>{object}, internal::ReferenceOwner<T>{
+                                               object} {}
 };
 
 #endif
@@ -186,7 +186,8 @@ private:
 };
 
 class RenderPass : public RenderPassCreateInfo,
-                   public UniqueVulkanObject<VkRenderPass> {
+                   public UniqueVulkanObject<VkRenderPass>,
+                   public std::enable_shared_from_this<RenderPass> {
 public:
   RenderPass(Device const &device,
              RenderPassCreateInfo createInfo) noexcept(ExceptionsDisabled)
@@ -0,0 +1,114 @@
+#ifndef VKWRAPPER_RESOURCETRACKER_HPP
+#define VKWRAPPER_RESOURCETRACKER_HPP
+
+#include <vkw/Exception.hpp>
+
+#include <boost/container/small_vector.hpp>
+#include <vulkan/vulkan.h>
+
+#include <unordered_map>
+
+namespace vkw {
+
+class BufferBase;
+class ImageInterface;
+
+/**
+ * @class ResourceTracker
+ *
+ * @brief Records last access of buffers and image subresources used by a
+ * command buffer and computes minimal set of barriers needed before the next
+ * access.
+ *
+ * Buffers are tracked as a whole, images are tracked per (mip level, array
+ * layer) pair. Resources seen for the first time are assumed to have no
+ * pending work from this command buffer. Images seen for the first time are
+ * assumed to already be in the layout of their first access, so existing
+ * contents are never discarded. Images in some other layout, e.g. freshly
+ * created ones in VK_IMAGE_LAYOUT_UNDEFINED, must be declared with
+ * assumeImageLayout() before their first use.
+ *
+ * Computed barriers are accumulated until clearPending() is called.
+ */
+class ResourceTracker {
+public:
+  struct PendingBarriers {
+    VkPipelineStageFlags srcStage = 0;
+    VkPipelineStageFlags dstStage = 0;
+    boost::container::small_vector<VkImageMemoryBarrier, 4> imageBarriers;
+    boost::container::small_vector<VkBufferMemoryBarrier, 4> bufferBarriers;
+
+    bool empty() const noexcept { return dstStage == 0; }
+  };
+
+  void useBuffer(BufferBase const &buffer, VkPipelineStageFlags stage,
+                 VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+  void useImage(ImageInterface const &image, VkImageSubresourceRange range,
+                VkImageLayout layout, VkPipelineStageFlags stage,
+                VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+  // Declares the layout of the whole image at the current point of recording.
+  // Useful for images transitioned by render passes or by previously
+  // submitted command buffers.
+  void assumeImageLayout(ImageInterface const &image,
+                         VkImageLayout layout) noexcept(ExceptionsDisabled);
+
+  PendingBarriers const &pending() const noexcept { return m_pending; }
+
+  void clearPending() noexcept;
+
+  void reset() noexcept;
+
+private:
+  // Layout of image subresources not seen yet
+  static constexpr VkImageLayout UnknownLayout = VK_IMAGE_LAYOUT_MAX_ENUM;
+
+  struct AccessState {
+    VkImageLayout layout = UnknownLayout;
+    // Stage and access of the last write (or layout transition)
+    VkPipelineStageFlags writeStage = 0;
+    VkAccessFlags writeAccess = 0;
+    // Stages that read the resource since the last write
+    VkPipelineStageFlags readStages = 0;
+    // Stages and accesses to which the last write has been made visible
+    VkPipelineStageFlags visibleStages = 0;
+    VkAccessFlags visibleAccess = 0;
+
+    bool operator==(AccessState const &another) const noexcept = default;
+  };
+
+  struct ImageState {
+    uint32_t mipLevels;
+    uint32_t arrayLayers;
+    boost::container::small_vector<AccessState, 1> subresources;
+  };
+
+  struct Dependency {
+    bool needed = false;
+    VkPipelineStageFlags srcStage = 0;
+    VkAccessFlags srcAccess = 0;
+    VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    bool operator==(Dependency const &another) const noexcept = default;
+  };
+
+  static Dependency m_access(AccessState &state, VkImageLayout layout,
+                             VkPipelineStageFlags stage,
+                             VkAccessFlags access) noexcept;
+
+  ImageState &m_image_state(ImageInterface const &image) noexcept(
+      ExceptionsDisabled);
+
+  void m_add_image_barrier(VkImage image, VkImageSubresourceRange range,
+                           Dependency const &dependency, VkImageLayout layout,
+                           VkPipelineStageFlags stage,
+                           VkAccessFlags access) noexcept(ExceptionsDisabled);
+
+  std::unordered_map<VkBuffer, AccessState> m_buffers;
+  std::unordered_map<VkImage, ImageState> m_images;
+  PendingBarriers m_pending;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_RESOURCETRACKER_HPP
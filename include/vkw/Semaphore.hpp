@@ -1,6 +1,7 @@
 #ifndef VKRENDERER_SEMAPHORE_HPP
 #define VKRENDERER_SEMAPHORE_HPP
 
+#include <vkw/Awaitable.hpp>
 #include <vkw/Device.hpp>
 
 namespace vkw {
@@ -8,6 +9,40 @@ namespace vkw {
 class Semaphore : public UniqueVulkanObject<VkSemaphore> {
 public:
   Semaphore(Device const &device) noexcept(ExceptionsDisabled);
+
+protected:
+  Semaphore(Device const &device,
+            VkSemaphoreCreateInfo const &createInfo) noexcept(
+      ExceptionsDisabled);
+};
+
+// Requires PhysicalDevice::extended_feature::timelineSemaphore to be enabled.
+// Values to wait for and signal on GPU are passed via SemaphoreSubmitInfo.
+class TimelineSemaphore : public Semaphore {
+public:
+  TimelineSemaphore(Device const &device,
+                    uint64_t initialValue = 0) noexcept(ExceptionsDisabled);
+
+  uint64_t value() const noexcept(ExceptionsDisabled);
+
+  // Signals value from host.
+  void signal(uint64_t value) noexcept(ExceptionsDisabled);
+
+  // returns true if semaphore reached value before timeout
+  bool wait(uint64_t value, uint64_t timeout = UINT64_MAX) const
+      noexcept(ExceptionsDisabled);
+
+  // co_await-able: suspends coroutine until semaphore reaches value.
+  TimelineAwaitable whenReached(uint64_t value, CompletionWatcher &watcher,
+                                Executor executor = {}) const noexcept {
+    return {watcher, *this, value, std::move(executor)};
+  }
+
+  TimelineAwaitable whenReached(uint64_t value, Executor executor = {}) const
+      noexcept(ExceptionsDisabled) {
+    return whenReached(value, parent().completionWatcher(),
+                       std::move(executor));
+  }
 };
 
 } // namespace vkw
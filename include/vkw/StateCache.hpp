@@ -0,0 +1,131 @@
+#ifndef VKWRAPPER_STATECACHE_HPP
+#define VKWRAPPER_STATECACHE_HPP
+
+#include <vkw/DescriptorSet.hpp>
+#include <vkw/Pipeline.hpp>
+#include <vkw/RenderPass.hpp>
+#include <vkw/Sampler.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace vkw {
+
+/**
+ * @class StateCache
+ *
+ * @brief Interns immutable state objects of a device: descriptor set
+ * layouts, pipeline layouts, samplers and render passes.
+ *
+ * Requests are hashed by their create infos. Identical requests share one
+ * Vulkan object handed out as a shared pointer, so equal layouts of different
+ * materials also have equal handles and pipelines built from them can share
+ * cache entries.
+ *
+ * The cache keeps every object alive until trim() finds its shared pointer
+ * held by nobody else. Layouts and render passes are shared with objects
+ * referencing them (pipelines, descriptor sets, framebuffers, ...) through
+ * StrongReference, so trim() never destroys one still in use. Samplers are
+ * only referenced by handle from descriptors: keep the returned pointer for
+ * as long as descriptor sets using it are alive. A cached render pass is
+ * built from its own copies of the attachment descriptions: descriptions and
+ * subpasses of the request may be temporaries. Samplers with pNext chains
+ * are not interned.
+ *
+ * All methods are thread safe. Device::stateCache() returns the cache of a
+ * device.
+ */
+class StateCache {
+public:
+  struct Statistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+
+  explicit StateCache(Device const &device) noexcept;
+
+  StateCache(StateCache const &another) = delete;
+  StateCache &operator=(StateCache const &another) = delete;
+
+  template <forward_range_of<DescriptorSetLayoutBinding> T>
+  std::shared_ptr<DescriptorSetLayout const> descriptorSetLayout(
+      T const &bindings,
+      VkDescriptorSetLayoutCreateFlags flags = 0) noexcept(ExceptionsDisabled) {
+    return m_descriptorSetLayout(
+        DescriptorSetLayoutInfo{bindings, flags}, [&]() {
+          return std::make_shared<DescriptorSetLayout>(m_device.get(),
+                                                       bindings, flags);
+        });
+  }
+
+  template <StaticSetLayoutLike T>
+  std::shared_ptr<DescriptorSetLayout const> descriptorSetLayout(
+      T layout,
+      VkDescriptorSetLayoutCreateFlags flags = 0) noexcept(ExceptionsDisabled) {
+    // Created from the static description as well: bindings stay sorted
+    // and validated at compile time
+    return m_descriptorSetLayout(
+        DescriptorSetLayoutInfo{layout, flags}, [&]() {
+          return std::make_shared<DescriptorSetLayout>(m_device.get(), layout,
+                                                       flags);
+        });
+  }
+
+  // Set layouts are identified by handle: pass interned ones.
+  std::shared_ptr<PipelineLayout const> pipelineLayout(
+      std::span<const std::shared_ptr<DescriptorSetLayout const>> setLayouts,
+      std::span<const VkPushConstantRange> pushConstants = {},
+      VkPipelineLayoutCreateFlags flags = 0) noexcept(ExceptionsDisabled);
+
+  std::shared_ptr<Sampler const>
+  sampler(VkSamplerCreateInfo const &createInfo) noexcept(ExceptionsDisabled);
+
+  std::shared_ptr<RenderPass const>
+  renderPass(RenderPassCreateInfo const &createInfo) noexcept(
+      ExceptionsDisabled);
+
+  // Drops objects nobody else references. Returns the number dropped.
+  size_t trim() noexcept;
+
+  size_t size() const noexcept;
+
+  Statistics statistics() const noexcept;
+
+  void resetStatistics() noexcept;
+
+private:
+  struct SetLayoutNode {
+    std::shared_ptr<DescriptorSetLayout const> layout;
+    // Create info only points at immutable samplers, keep them for compare
+    std::vector<VkSampler> immutableSamplers;
+  };
+
+  struct PipelineLayoutNode {
+    // Declared first: must outlive the layout referencing them
+    std::vector<std::shared_ptr<DescriptorSetLayout const>> setLayouts;
+    std::vector<VkPushConstantRange> pushConstants;
+    std::shared_ptr<PipelineLayout const> layout;
+  };
+
+  // create is only called on a miss
+  std::shared_ptr<DescriptorSetLayout const> m_descriptorSetLayout(
+      DescriptorSetLayoutInfo const &info,
+      std::function<std::shared_ptr<DescriptorSetLayout>()> const
+          &create) noexcept(ExceptionsDisabled);
+
+  StrongReference<Device const> m_device;
+
+  mutable std::mutex m_mutex;
+  std::unordered_multimap<size_t, SetLayoutNode> m_setLayouts;
+  std::unordered_multimap<size_t, PipelineLayoutNode> m_pipelineLayouts;
+  std::unordered_multimap<size_t, std::shared_ptr<Sampler const>> m_samplers;
+  std::unordered_multimap<size_t, std::shared_ptr<RenderPass const>>
+      m_renderPasses;
+  Statistics m_statistics;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_STATECACHE_HPP
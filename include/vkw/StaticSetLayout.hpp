@@ -0,0 +1,275 @@
+#ifndef VKWRAPPER_STATICSETLAYOUT_HPP
+#define VKWRAPPER_STATICSETLAYOUT_HPP
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+
+namespace vkw {
+
+/**
+ * @concept SetBindingLike
+ *
+ * Used by @class StaticSetLayout to check if parameters representing
+ * VkDescriptorSetLayoutBinding satisfy following constraints:
+ *
+ *   1. Class must have static constexpr @member 'value' of type
+ *   VkDescriptorSetLayoutBinding, representing binding info.
+ *   2. Class must have static constexpr @member 'flags' of type
+ *   VkDescriptorBindingFlags.
+ *
+ */
+
+template <typename T>
+concept SetBindingLike = requires {
+  T::value;
+  requires std::same_as<std::remove_cv_t<decltype(T::value)>,
+                        VkDescriptorSetLayoutBinding>;
+  T::flags;
+  requires std::same_as<std::remove_cv_t<decltype(T::flags)>,
+                        VkDescriptorBindingFlags>;
+};
+
+/**
+ *
+ * @class set_binding
+ * @brief Implementation of SetBindingLike class describing one binding of a
+ * descriptor set layout. Immutable samplers can't be described.
+ *
+ * @tparam bindingT is binding number.
+ * @tparam typeT is descriptor type.
+ * @tparam stagesT are shader stages that can access the binding.
+ * @tparam countT is number of descriptors in the binding.
+ * @tparam flagsT are descriptor indexing flags of the binding.
+ */
+
+template <uint32_t bindingT, VkDescriptorType typeT,
+          VkShaderStageFlags stagesT = VK_SHADER_STAGE_ALL,
+          uint32_t countT = 1, VkDescriptorBindingFlags flagsT = 0>
+struct set_binding {
+  constexpr static const VkDescriptorSetLayoutBinding value = {
+      .binding = bindingT,
+      .descriptorType = typeT,
+      .descriptorCount = countT,
+      .stageFlags = stagesT,
+      .pImmutableSamplers = nullptr};
+  constexpr static const VkDescriptorBindingFlags flags = flagsT;
+};
+
+namespace internal {
+
+// Same order as DescriptorSetLayoutInfo keeps: descending binding numbers
+template <SetBindingLike... Bindings>
+constexpr auto sortedSetBindings() noexcept {
+  std::array<VkDescriptorSetLayoutBinding, sizeof...(Bindings)> sorted = {
+      Bindings::value...};
+  std::sort(sorted.begin(), sorted.end(),
+            [](auto const &lhs, auto const &rhs) {
+              return lhs.binding > rhs.binding;
+            });
+  return sorted;
+}
+
+template <SetBindingLike... Bindings>
+constexpr VkDescriptorBindingFlags setBindingFlags(uint32_t binding) noexcept {
+  VkDescriptorBindingFlags flags = 0;
+  ((flags |= Bindings::value.binding == binding ? Bindings::flags : 0), ...);
+  return flags;
+}
+
+// Flags of each binding in order of sortedSetBindings()
+template <SetBindingLike... Bindings>
+constexpr auto sortedSetBindingFlags() noexcept {
+  auto bindings = sortedSetBindings<Bindings...>();
+  std::array<VkDescriptorBindingFlags, sizeof...(Bindings)> flags{};
+  for (size_t i = 0; i < bindings.size(); ++i)
+    flags[i] = setBindingFlags<Bindings...>(bindings[i].binding);
+  return flags;
+}
+
+constexpr bool isDynamicDescriptor(VkDescriptorType type) noexcept {
+  return type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+         type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+}
+
+template <SetBindingLike... Bindings>
+constexpr bool uniqueSetBindings() noexcept {
+  auto bindings = sortedSetBindings<Bindings...>();
+  return std::adjacent_find(bindings.begin(), bindings.end(),
+                            [](auto const &lhs, auto const &rhs) {
+                              return lhs.binding == rhs.binding;
+                            }) == bindings.end();
+}
+
+template <SetBindingLike... Bindings>
+constexpr bool validSetBindingFlags() noexcept {
+  auto bindings = sortedSetBindings<Bindings...>();
+  for (size_t i = 0; i < bindings.size(); ++i) {
+    auto flags = setBindingFlags<Bindings...>(bindings[i].binding);
+    bool dynamic = isDynamicDescriptor(bindings[i].descriptorType);
+    if (dynamic && (flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT))
+      return false;
+    // Sorted descending: only the first binding may have variable count
+    if ((flags & VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT) &&
+        (i != 0 || dynamic))
+      return false;
+  }
+  return true;
+}
+
+template <SetBindingLike... Bindings>
+constexpr size_t setDescriptorTypeCount() noexcept {
+  auto bindings = sortedSetBindings<Bindings...>();
+  size_t count = 0;
+  for (size_t i = 0; i < bindings.size(); ++i)
+    if (std::none_of(bindings.begin(), bindings.begin() + i,
+                     [&](auto const &binding) {
+                       return binding.descriptorType ==
+                              bindings[i].descriptorType;
+                     }))
+      ++count;
+  return count;
+}
+
+template <typename... Ranges> constexpr bool disjointPushStages() noexcept {
+  VkShaderStageFlags seen = 0;
+  bool disjoint = true;
+  ((disjoint = disjoint && !(seen & Ranges::value.stageFlags),
+    seen |= Ranges::value.stageFlags),
+   ...);
+  return disjoint;
+}
+
+} // namespace internal
+
+/**
+ *
+ * @class StaticSetLayout
+ * @brief Descriptor set layout known in compile time, represented by a pack
+ * of SetBindingLike structure types.
+ *
+ * Bindings are validated, sorted and turned into VkDescriptorSetLayoutBinding
+ * and VkDescriptorPoolSize arrays during compilation. DescriptorSetLayout
+ * constructed from it points the create info at those arrays instead of
+ * sorting and checking bindings at runtime:
+ *
+ *    using MaterialLayout = StaticSetLayout<
+ *        set_binding<0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+ *                    VK_SHADER_STAGE_VERTEX_BIT>,
+ *        set_binding<1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+ *                    VK_SHADER_STAGE_FRAGMENT_BIT>>;
+ *
+ *    DescriptorSetLayout layout{device, MaterialLayout{}};
+ *    DescriptorPool pool{device, 64, MaterialLayout::poolSizes(64)};
+ *
+ * Bindings are ordered the same way as in DescriptorSetLayoutInfo, so the
+ * layout compares equal to one built from the same bindings at runtime.
+ *
+ * @tparam Bindings is a pack of SetBindingLike structure types.
+ */
+
+template <SetBindingLike... Bindings> class StaticSetLayout {
+  static_assert(internal::uniqueSetBindings<Bindings...>(),
+                "StaticSetLayout: bindings have duplicate binding index");
+  static_assert(internal::validSetBindingFlags<Bindings...>(),
+                "StaticSetLayout: dynamic buffer bindings can't be updated "
+                "after bind and only the highest non-dynamic binding may have "
+                "variable descriptor count");
+
+  constexpr static const size_t m_typeCount =
+      internal::setDescriptorTypeCount<Bindings...>();
+
+public:
+  constexpr static const std::array<VkDescriptorSetLayoutBinding,
+                                    sizeof...(Bindings)>
+      bindings = internal::sortedSetBindings<Bindings...>();
+
+  constexpr static const std::array<VkDescriptorBindingFlags,
+                                    sizeof...(Bindings)>
+      bindingFlags = internal::sortedSetBindingFlags<Bindings...>();
+
+  constexpr static const bool hasBindingFlags =
+      ((Bindings::flags != 0) || ...);
+
+  // Pool sizes needed to allocate setCount sets of this layout
+  constexpr static std::array<VkDescriptorPoolSize, m_typeCount>
+  poolSizes(uint32_t setCount = 1) noexcept {
+    std::array<VkDescriptorPoolSize, m_typeCount> sizes{};
+    size_t count = 0;
+    for (auto const &binding : bindings) {
+      auto found = std::find_if(sizes.begin(), sizes.begin() + count,
+                                [&binding](auto const &size) {
+                                  return size.type == binding.descriptorType;
+                                });
+      if (found == sizes.begin() + count) {
+        found->type = binding.descriptorType;
+        found->descriptorCount = 0;
+        ++count;
+      }
+      found->descriptorCount += binding.descriptorCount * setCount;
+    }
+    return sizes;
+  }
+};
+
+/**
+ * @concept StaticSetLayoutLike
+ *
+ * Satisfied by StaticSetLayout instantiations and classes providing the same
+ * constexpr 'bindings', 'bindingFlags' and 'hasBindingFlags' members.
+ */
+
+template <typename T>
+concept StaticSetLayoutLike = requires {
+  T::bindings;
+  T::bindingFlags;
+  T::hasBindingFlags;
+  requires T::bindings.size() == T::bindingFlags.size();
+};
+
+/**
+ *
+ * @class push_constant
+ * @brief Push constant range holding a structure of type T.
+ *
+ * @tparam T is type of pushed structure.
+ * @tparam stagesT are shader stages that can access the range.
+ * @tparam offsetT is offset of the range.
+ */
+
+template <typename T, VkShaderStageFlags stagesT, uint32_t offsetT = 0>
+struct push_constant {
+  static_assert(offsetT % 4 == 0 && sizeof(T) % 4 == 0,
+                "push_constant: offset and size must be multiples of 4");
+
+  constexpr static const VkPushConstantRange value = {
+      .stageFlags = stagesT,
+      .offset = offsetT,
+      .size = static_cast<uint32_t>(sizeof(T))};
+};
+
+/**
+ *
+ * @class StaticPushConstants
+ * @brief Push constant ranges of a pipeline layout known in compile time.
+ * 'ranges' can be passed to PipelineLayout directly.
+ *
+ * @tparam Ranges is a pack of push_constant structure types.
+ */
+
+template <typename... Ranges> class StaticPushConstants {
+  static_assert(internal::disjointPushStages<Ranges...>(),
+                "StaticPushConstants: a shader stage may only be used by "
+                "one push constant range");
+
+public:
+  constexpr static const std::array<VkPushConstantRange, sizeof...(Ranges)>
+      ranges = {Ranges::value...};
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_STATICSETLAYOUT_HPP
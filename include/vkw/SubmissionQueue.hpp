@@ -0,0 +1,110 @@
+#ifndef VKWRAPPER_SUBMISSIONQUEUE_HPP
+#define VKWRAPPER_SUBMISSIONQUEUE_HPP
+
+#include <vkw/Queue.hpp>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace vkw {
+
+class Fence;
+
+/**
+ * @class SubmissionQueue
+ *
+ * @brief Moves vkQueueSubmit of a Queue to a dedicated thread.
+ *
+ * Producers push SubmitInfo's into a bounded lock-free ring and return
+ * immediately. The submission thread takes everything pending and hands it
+ * to the driver with as few vkQueueSubmit calls as possible: a batch is cut
+ * only after an entry that carries a fence, since a fence signals once all
+ * preceding work of the same call completes.
+ *
+ * While a SubmissionQueue exists it owns its Queue: direct submits to the
+ * queue from any other thread (Queue::submit, Queue::submit2, FrameContext)
+ * post an error. Presents and waits stay allowed, the queue serializes them
+ * with the submission thread by its own lock. Command buffers, semaphores and
+ * fences of an entry must stay alive until it is submitted, use flush() to
+ * wait for that.
+ */
+class SubmissionQueue {
+public:
+  // Capacity is rounded up to power of two. When the ring is full producers
+  // yield until the submission thread catches up.
+  explicit SubmissionQueue(Queue const &queue,
+                           size_t capacity = 64) noexcept(ExceptionsDisabled);
+
+  SubmissionQueue(SubmissionQueue const &another) = delete;
+  SubmissionQueue &operator=(SubmissionQueue const &another) = delete;
+
+  // Submits everything pending and joins submission thread.
+  ~SubmissionQueue();
+
+  // Safe to call from any number of threads concurrently.
+  void enqueue(SubmitInfo info, Fence const *fence = nullptr) noexcept(
+      ExceptionsDisabled);
+
+  void enqueue(SubmitInfo info, Fence const &fence) noexcept(
+      ExceptionsDisabled) {
+    enqueue(std::move(info), &fence);
+  }
+
+  // Blocks until everything enqueued before the call reached the driver.
+  // Rethrows the first error raised by vkQueueSubmit since the last flush.
+  void flush() noexcept(ExceptionsDisabled);
+
+  Queue const &queue() const noexcept { return m_queue; }
+
+  // Number of vkQueueSubmit calls made so far.
+  uint64_t submitCalls() const noexcept {
+    return m_submitCalls.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Entry {
+    SubmitInfo info;
+    Fence const *fence;
+  };
+
+  // Vyukov bounded queue cell: sequence tells whether the cell is free for
+  // position `pos` (sequence == pos) or holds its entry (sequence == pos + 1).
+  struct Cell {
+    std::atomic<size_t> sequence;
+    std::optional<Entry> entry;
+  };
+
+  void m_run() noexcept;
+
+  std::optional<Entry> m_dequeue() noexcept;
+
+  void m_submit(boost::container::small_vector<Entry, 8> &batch) noexcept;
+
+  std::reference_wrapper<Queue const> m_queue;
+  std::unique_ptr<Cell[]> m_cells;
+  size_t m_mask;
+
+  alignas(64) std::atomic<size_t> m_enqueuePos = 0;
+  // Only touched by the submission thread.
+  alignas(64) size_t m_dequeuePos = 0;
+
+  // Bumped on every publish and on shutdown, submission thread sleeps on it.
+  alignas(64) std::atomic<uint32_t> m_wakeUp = 0;
+  // Count of entries handed to the driver, flush() sleeps on it.
+  alignas(64) std::atomic<size_t> m_submitted = 0;
+
+  std::atomic<uint64_t> m_submitCalls = 0;
+  std::atomic<bool> m_stop = false;
+
+  std::mutex m_errorMutex;
+  std::exception_ptr m_error;
+
+  std::thread m_thread;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_SUBMISSIONQUEUE_HPP
@@ -0,0 +1,67 @@
+#ifndef VKWRAPPER_THREADPOOL_HPP
+#define VKWRAPPER_THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vkw {
+
+/**
+ * @class ThreadPool
+ *
+ * @brief Fixed set of worker threads with work stealing.
+ *
+ * Every worker owns a task queue. Tasks submitted from a worker go to its
+ * own queue and are taken in LIFO order, tasks submitted from other threads
+ * are distributed round-robin. A worker whose queue is empty steals the
+ * oldest task from other queues before going to sleep.
+ *
+ * Tasks receive index of the worker that runs them, so per-thread resources
+ * (e.g. command pools) can be indexed with it.
+ */
+class ThreadPool {
+public:
+  using Task = std::function<void(uint32_t worker)>;
+
+  explicit ThreadPool(
+      uint32_t workerCount = std::thread::hardware_concurrency());
+
+  ThreadPool(ThreadPool const &another) = delete;
+  ThreadPool &operator=(ThreadPool const &another) = delete;
+
+  // Runs all queued tasks and joins workers.
+  ~ThreadPool();
+
+  void submit(Task task);
+
+  uint32_t workerCount() const noexcept { return m_workers.size(); }
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  void m_run(uint32_t index);
+
+  bool m_pop(uint32_t index, Task &task);
+
+  bool m_steal(uint32_t index, Task &task);
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::atomic<size_t> m_pending = 0;
+  std::atomic<uint32_t> m_nextWorker = 0;
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wakeUp;
+  bool m_stop = false;
+};
+
+} // namespace vkw
+#endif // VKWRAPPER_THREADPOOL_HPP
@@ -1,6 +1,7 @@
 #ifndef VKWRAPPER_UNIQUEVULKANOBJECT_HPP
 #define VKWRAPPER_UNIQUEVULKANOBJECT_HPP
 
+#include <vkw/DeletionQueue.hpp>
 #include <vkw/ReferenceGuard.hpp>
 #include <vkw/VulkanTypeTraits.hpp>
 
@@ -44,11 +45,23 @@ public:
       : m_creator(creator){};
 
   void operator()(T handle) noexcept {
+    if constexpr (std::same_as<typename TypeTraits::CreatorType, Device>) {
+      if (m_creator.get().deletionQueue().retire(
+              &m_destroy, DeletionQueue::toRaw(handle)))
+        return;
+    }
     std::invoke(TypeTraits::getDestructor(m_creator.get()), m_creator.get(),
                 handle, m_creator.get().hostAllocator().allocator());
   }
 
 private:
+  static void m_destroy(typename TypeTraits::CreatorType const &creator,
+                        uint64_t handle, VmaAllocation) noexcept {
+    std::invoke(TypeTraits::getDestructor(creator), creator,
+                DeletionQueue::fromRaw<T>(handle),
+                creator.hostAllocator().allocator());
+  }
+
   StrongReference<typename TypeTraits::CreatorType const> m_creator;
 };
 /**
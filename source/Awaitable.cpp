@@ -0,0 +1,57 @@
+#include "vkw/Awaitable.hpp"
+#include "vkw/Fence.hpp"
+#include "vkw/Semaphore.hpp"
+#include "vkw/ThreadPool.hpp"
+
+namespace vkw {
+
+Executor threadPoolExecutor(ThreadPool &threadPool) noexcept(
+    ExceptionsDisabled) {
+  return [&threadPool](std::coroutine_handle<> handle) {
+    threadPool.submit([handle](uint32_t) { handle.resume(); });
+  };
+}
+
+CompletionWatcher::Callback GPUAwaitable::m_resumeCallback(
+    std::coroutine_handle<> handle) noexcept(ExceptionsDisabled) {
+  // Awaitable lives in the coroutine frame until the coroutine is resumed, so
+  // the result can be stored in it. Executor is not touched after suspension
+  // and can be moved out.
+  if (!m_executor)
+    return [this, handle](VkResult result) {
+      m_result = result;
+      handle.resume();
+    };
+
+  return [this, executor = std::move(m_executor), handle](VkResult result) {
+    m_result = result;
+    executor(handle);
+  };
+}
+
+void GPUAwaitable::await_resume() const noexcept(ExceptionsDisabled) {
+  if (m_result == CompletionWatcher::Abandoned)
+    postError(Error("CompletionWatcher destroyed before the wait completed"));
+  if (m_result != VK_SUCCESS)
+    postError(VulkanError(m_result, __FILE__, __LINE__));
+}
+
+bool FenceAwaitable::await_ready() const noexcept(ExceptionsDisabled) {
+  return m_fence.get().signaled();
+}
+
+void FenceAwaitable::await_suspend(std::coroutine_handle<> handle) noexcept(
+    ExceptionsDisabled) {
+  m_watcher.get().onComplete(m_fence, m_resumeCallback(handle));
+}
+
+bool TimelineAwaitable::await_ready() const noexcept(ExceptionsDisabled) {
+  return m_semaphore.get().value() >= m_value;
+}
+
+void TimelineAwaitable::await_suspend(std::coroutine_handle<> handle) noexcept(
+    ExceptionsDisabled) {
+  m_watcher.get().onComplete(m_semaphore, m_value, m_resumeCallback(handle));
+}
+
+} // namespace vkw
@@ -0,0 +1,227 @@
+#include "vkw/BindlessTable.hpp"
+#include "vkw/Device.hpp"
+#include "vkw/Semaphore.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <vector>
+
+namespace vkw {
+
+namespace {
+
+constexpr VkDescriptorBindingFlags BindlessFlags =
+    VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+std::array<DescriptorSetLayoutBinding, 3>
+layoutBindings(Device const &device, BindlessTable::Capacity capacity,
+               VkShaderStageFlags stages) noexcept(ExceptionsDisabled) {
+  using feature = PhysicalDevice::extended_feature;
+  auto &physicalDevice = device.physicalDevice();
+  for (auto required : {feature::descriptorBindingPartiallyBound,
+                        feature::descriptorBindingSampledImageUpdateAfterBind,
+                        feature::descriptorBindingStorageBufferUpdateAfterBind,
+                        feature::descriptorBindingUpdateUnusedWhilePending})
+    if (!physicalDevice.isFeatureEnabled(required))
+      postError(Error("BindlessTable: required descriptor indexing features "
+                      "were not enabled on device creation",
+                      ErrorCode::FEATURE_UNSUPPORTED));
+
+  auto &limits = physicalDevice.descriptorIndexingProperties();
+  if (capacity.sampledImages >
+          limits.maxDescriptorSetUpdateAfterBindSampledImages ||
+      capacity.samplers > limits.maxDescriptorSetUpdateAfterBindSamplers ||
+      capacity.storageBuffers >
+          limits.maxDescriptorSetUpdateAfterBindStorageBuffers)
+    postError(Error("BindlessTable: capacity exceeds device limits"));
+
+  return {DescriptorSetLayoutBinding{BindlessTable::SampledImageBinding,
+                                     VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, stages,
+                                     capacity.sampledImages, nullptr,
+                                     BindlessFlags},
+          DescriptorSetLayoutBinding{BindlessTable::SamplerBinding,
+                                     VK_DESCRIPTOR_TYPE_SAMPLER, stages,
+                                     capacity.samplers, nullptr,
+                                     BindlessFlags},
+          DescriptorSetLayoutBinding{BindlessTable::StorageBufferBinding,
+                                     VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages,
+                                     capacity.storageBuffers, nullptr,
+                                     BindlessFlags}};
+}
+
+std::vector<VkDescriptorPoolSize>
+poolSizes(BindlessTable::Capacity capacity) noexcept(ExceptionsDisabled) {
+  std::vector<VkDescriptorPoolSize> sizes;
+  // Pool sizes must not be empty
+  if (capacity.sampledImages != 0)
+    sizes.push_back(
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, capacity.sampledImages});
+  if (capacity.samplers != 0)
+    sizes.push_back({VK_DESCRIPTOR_TYPE_SAMPLER, capacity.samplers});
+  if (capacity.storageBuffers != 0)
+    sizes.push_back(
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, capacity.storageBuffers});
+  return sizes;
+}
+
+} // namespace
+
+BindlessTable::IndexAllocator::IndexAllocator(uint32_t capacity) noexcept(
+    ExceptionsDisabled)
+    : m_next(std::make_unique<std::atomic<uint32_t>[]>(capacity)),
+      m_capacity(capacity) {}
+
+uint32_t BindlessTable::IndexAllocator::allocate() noexcept {
+  auto head = m_head.load(std::memory_order_acquire);
+  for (;;) {
+    auto index = static_cast<uint32_t>(head);
+    if (index == InvalidIndex)
+      break;
+
+    auto next = m_next[index].load(std::memory_order_relaxed);
+    if (m_head.compare_exchange_weak(
+            head, m_pack(next, static_cast<uint32_t>(head >> 32) + 1),
+            std::memory_order_acq_rel, std::memory_order_acquire))
+      return index;
+  }
+
+  // Free list is empty: take a slot that was never used
+  auto fresh = m_fresh.load(std::memory_order_relaxed);
+  while (fresh < m_capacity &&
+         !m_fresh.compare_exchange_weak(fresh, fresh + 1,
+                                        std::memory_order_relaxed))
+    ;
+  return fresh < m_capacity ? fresh : InvalidIndex;
+}
+
+void BindlessTable::IndexAllocator::free(uint32_t index) noexcept {
+  auto head = m_head.load(std::memory_order_relaxed);
+  do {
+    m_next[index].store(static_cast<uint32_t>(head),
+                        std::memory_order_relaxed);
+  } while (!m_head.compare_exchange_weak(
+      head, m_pack(index, static_cast<uint32_t>(head >> 32) + 1),
+      std::memory_order_release, std::memory_order_relaxed));
+}
+
+BindlessTable::BindlessTable(Device const &device, Capacity capacity,
+                             VkShaderStageFlags stages) noexcept(
+    ExceptionsDisabled)
+    : m_device(device),
+      m_layout(device, layoutBindings(device, capacity, stages),
+               VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT),
+      m_pool(device, 1, poolSizes(capacity),
+             VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT),
+      m_set(m_pool, m_layout), m_images(capacity.sampledImages),
+      m_samplers(capacity.samplers), m_buffers(capacity.storageBuffers) {}
+
+uint32_t BindlessTable::m_allocate(IndexAllocator &indices,
+                                   char const *kind) noexcept(
+    ExceptionsDisabled) {
+  auto index = indices.allocate();
+  if (index == IndexAllocator::InvalidIndex)
+    postError(Error("BindlessTable: all " + std::to_string(indices.capacity()) +
+                    " " + kind + " slots are taken"));
+  return index;
+}
+
+void BindlessTable::m_retire(IndexAllocator &indices,
+                             uint32_t index) noexcept {
+  auto &deletionQueue = m_device.get().deletionQueue();
+  if (!deletionQueue.deferralEnabled()) {
+    indices.free(index);
+    return;
+  }
+
+  std::lock_guard lock{m_retiredMutex};
+  // Key is read under the lock to keep m_retired sorted by it
+  m_retired.push_back({deletionQueue.currentKey(), &indices, index});
+}
+
+size_t BindlessTable::collect(uint64_t completedKey) noexcept {
+  std::lock_guard lock{m_retiredMutex};
+  auto end = std::find_if(m_retired.begin(), m_retired.end(),
+                          [completedKey](RetiredSlot const &slot) {
+                            return slot.key > completedKey;
+                          });
+  auto count = static_cast<size_t>(std::distance(m_retired.begin(), end));
+  for (auto slot = m_retired.begin(); slot != end; ++slot)
+    slot->indices->free(slot->index);
+  m_retired.erase(m_retired.begin(), end);
+  return count;
+}
+
+size_t BindlessTable::collect(TimelineSemaphore const &semaphore) noexcept(
+    ExceptionsDisabled) {
+  return collect(semaphore.value());
+}
+
+void BindlessTable::m_write(VkWriteDescriptorSet const &write) noexcept {
+  auto &device = m_device.get();
+  std::lock_guard lock{m_writeMutex};
+  device.core<1, 0>().vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+uint32_t
+BindlessTable::add(ImageViewBase const &image,
+                   VkImageLayout layout) noexcept(ExceptionsDisabled) {
+  auto index = m_allocate(m_images, "image");
+
+  VkDescriptorImageInfo imageInfo{VK_NULL_HANDLE, image, layout};
+  VkWriteDescriptorSet writeSet{};
+  writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  writeSet.pNext = nullptr;
+  writeSet.dstSet = m_set;
+  writeSet.dstBinding = SampledImageBinding;
+  writeSet.dstArrayElement = index;
+  writeSet.descriptorCount = 1;
+  writeSet.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  writeSet.pImageInfo = &imageInfo;
+  m_write(writeSet);
+
+  return index;
+}
+
+uint32_t
+BindlessTable::add(Sampler const &sampler) noexcept(ExceptionsDisabled) {
+  auto index = m_allocate(m_samplers, "sampler");
+
+  VkDescriptorImageInfo imageInfo{sampler, VK_NULL_HANDLE,
+                                  VK_IMAGE_LAYOUT_UNDEFINED};
+  VkWriteDescriptorSet writeSet{};
+  writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  writeSet.pNext = nullptr;
+  writeSet.dstSet = m_set;
+  writeSet.dstBinding = SamplerBinding;
+  writeSet.dstArrayElement = index;
+  writeSet.descriptorCount = 1;
+  writeSet.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+  writeSet.pImageInfo = &imageInfo;
+  m_write(writeSet);
+
+  return index;
+}
+
+uint32_t BindlessTable::add(BufferBase const &buffer, VkDeviceSize offset,
+                            VkDeviceSize range) noexcept(ExceptionsDisabled) {
+  auto index = m_allocate(m_buffers, "storage buffer");
+
+  VkDescriptorBufferInfo bufferInfo{buffer, offset, range};
+  VkWriteDescriptorSet writeSet{};
+  writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  writeSet.pNext = nullptr;
+  writeSet.dstSet = m_set;
+  writeSet.dstBinding = StorageBufferBinding;
+  writeSet.dstArrayElement = index;
+  writeSet.descriptorCount = 1;
+  writeSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  writeSet.pBufferInfo = &bufferInfo;
+  m_write(writeSet);
+
+  return index;
+}
+
+} // namespace vkw
@@ -14,10 +14,24 @@ BufferBase::BufferBase(
 }
 
 BufferBase::~BufferBase() {
-  if (m_buffer != VK_NULL_HANDLE) {
-    unmap();
-    vmaDestroyBuffer(m_allocator, m_buffer, m_allocation);
-  }
+  if (m_buffer == VK_NULL_HANDLE)
+    return;
+
+  unmap();
+
+  auto *deletionQueue = DeletionQueue::find(m_allocator);
+  if (deletionQueue &&
+      deletionQueue->retire(
+          [](Device const &device, uint64_t buffer,
+             VmaAllocation allocation) noexcept {
+            vmaDestroyBuffer(device.getAllocator(),
+                             DeletionQueue::fromRaw<VkBuffer>(buffer),
+                             allocation);
+          },
+          DeletionQueue::toRaw(m_buffer), m_allocation))
+    return;
+
+  vmaDestroyBuffer(m_allocator, m_buffer, m_allocation);
 }
 
 } // namespace vkw
\ No newline at end of file
@@ -9,8 +9,90 @@
 #include "vkw/Pipeline.hpp"
 #include "vkw/RenderPass.hpp"
 
+#include <algorithm>
+#include <limits>
+
 namespace vkw {
 
+namespace {
+
+// Distinct subresource ranges touched by copy regions. Several regions may
+// address the same subresource and must not produce barriers against each
+// other.
+template <typename T, typename Projection>
+auto regionRanges(std::span<T> regions, Projection projection) noexcept {
+  boost::container::small_vector<VkImageSubresourceRange, 4> ranges;
+  for (auto const &region : regions) {
+    VkImageSubresourceLayers const &layers = projection(region);
+    VkImageSubresourceRange range{layers.aspectMask, layers.mipLevel, 1,
+                                  layers.baseArrayLayer, layers.layerCount};
+    auto same = [&range](VkImageSubresourceRange const &another) {
+      return range.aspectMask == another.aspectMask &&
+             range.baseMipLevel == another.baseMipLevel &&
+             range.baseArrayLayer == another.baseArrayLayer &&
+             range.layerCount == another.layerCount;
+    };
+    if (std::none_of(ranges.begin(), ranges.end(), same))
+      ranges.push_back(range);
+  }
+  return ranges;
+}
+
+bool overlaps(VkImageSubresourceRange const &lhs,
+              VkImageSubresourceRange const &rhs) noexcept {
+  // VK_REMAINING_* counts produce ends past any real subresource
+  auto intersects = [](uint32_t lhsBase, uint32_t lhsCount, uint32_t rhsBase,
+                       uint32_t rhsCount) {
+    return lhsBase < uint64_t(rhsBase) + rhsCount &&
+           rhsBase < uint64_t(lhsBase) + lhsCount;
+  };
+  return (lhs.aspectMask & rhs.aspectMask) &&
+         intersects(lhs.baseMipLevel, lhs.levelCount, rhs.baseMipLevel,
+                    rhs.levelCount) &&
+         intersects(lhs.baseArrayLayer, lhs.layerCount, rhs.baseArrayLayer,
+                    rhs.layerCount);
+}
+
+bool overlaps(VkBufferMemoryBarrier const &lhs,
+              VkBufferMemoryBarrier const &rhs) noexcept {
+  auto end = [](VkBufferMemoryBarrier const &barrier) {
+    return barrier.size == VK_WHOLE_SIZE
+               ? std::numeric_limits<VkDeviceSize>::max()
+               : barrier.offset + barrier.size;
+  };
+  return lhs.buffer == rhs.buffer && lhs.offset < end(rhs) &&
+         rhs.offset < end(lhs);
+}
+
+bool same(VkViewport const &lhs, VkViewport const &rhs) noexcept {
+  return lhs.x == rhs.x && lhs.y == rhs.y && lhs.width == rhs.width &&
+         lhs.height == rhs.height && lhs.minDepth == rhs.minDepth &&
+         lhs.maxDepth == rhs.maxDepth;
+}
+
+bool same(VkRect2D const &lhs, VkRect2D const &rhs) noexcept {
+  return lhs.offset.x == rhs.offset.x && lhs.offset.y == rhs.offset.y &&
+         lhs.extent.width == rhs.extent.width &&
+         lhs.extent.height == rhs.extent.height;
+}
+
+// Returns true if values are already set in shadow, otherwise updates it.
+template <typename T, size_t N>
+bool elideDynamicState(std::array<std::optional<T>, N> &shadow,
+                       uint32_t first, std::span<const T> values) noexcept {
+  bool elide = first + values.size() <= N;
+  for (size_t i = 0; i < values.size() && first + i < N; ++i) {
+    auto &current = shadow[first + i];
+    if (current && same(*current, values[i]))
+      continue;
+    elide = false;
+    current = values[i];
+  }
+  return elide;
+}
+
+} // namespace
+
 CommandBuffer::CommandBuffer(
     CommandPool &pool,
     VkCommandBufferLevel bufferLevel) noexcept(ExceptionsDisabled)
@@ -20,11 +102,16 @@ CommandBuffer::CommandBuffer(
   allocInfo.pNext = nullptr;
   allocInfo.commandBufferCount = 1;
   allocInfo.commandPool = pool;
+  allocInfo.level = bufferLevel;
 
   VK_CHECK_RESULT(m_device.get().core<1, 0>().vkAllocateCommandBuffers(
       m_device.get(), &allocInfo, &m_commandBuffer))
 }
 
+CommandBuffer::CommandBuffer(CommandPool &pool,
+                             VkCommandBuffer commandBuffer) noexcept
+    : m_pool(pool), m_device(pool.parent()), m_commandBuffer(commandBuffer) {}
+
 uint32_t CommandBuffer::queueFamily() const noexcept {
   return m_pool.get().queueFamilyIndex();
 }
@@ -41,10 +128,164 @@ void CommandBuffer::m_begin(VkCommandBufferUsageFlags flags,
   VK_CHECK_RESULT(m_device.get().core<1, 0>().vkBeginCommandBuffer(
       m_commandBuffer, &beginInfo))
 
+  if (m_tracker)
+    m_tracker->reset();
+  m_insideRenderPass = flags & VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  if (m_barrierBatch)
+    m_barrierBatch->clear();
+  invalidateBindState();
+
   m_recording = true;
 }
 
+void CommandBuffer::enableBindElision(bool enable) noexcept(
+    ExceptionsDisabled) {
+  if (!enable) {
+    m_bindState.reset();
+    return;
+  }
+  if (!m_bindState)
+    m_bindState = std::make_unique<BindState>();
+}
+
+void CommandBuffer::invalidateBindState() noexcept {
+  if (m_bindState)
+    m_bindState->clear();
+}
+
+CommandBuffer::BindState::BindPoint *
+CommandBuffer::BindState::bindPoint(VkPipelineBindPoint point) noexcept {
+  switch (point) {
+  case VK_PIPELINE_BIND_POINT_GRAPHICS:
+    return &bindPoints[0];
+  case VK_PIPELINE_BIND_POINT_COMPUTE:
+    return &bindPoints[1];
+  default:
+    return nullptr;
+  }
+}
+
+bool CommandBuffer::m_elidePipeline(VkPipelineBindPoint bindPoint,
+                                    VkPipeline pipeline) noexcept {
+  if (!m_bindState)
+    return false;
+  auto *state = m_bindState->bindPoint(bindPoint);
+  if (!state)
+    return false;
+
+  if (state->pipeline == pipeline) {
+    ++m_skippedBinds.pipelines;
+    return true;
+  }
+
+  state->pipeline = pipeline;
+  // Pipeline with static viewport or scissor state overwrites them
+  if (bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+    m_bindState->viewports.fill(std::nullopt);
+    m_bindState->scissors.fill(std::nullopt);
+  }
+  return false;
+}
+
+void CommandBuffer::enableBarrierBatching(bool enable) noexcept {
+  if (!enable) {
+    flushBarriers();
+    m_barrierBatch.reset();
+    return;
+  }
+  if (!m_barrierBatch)
+    m_barrierBatch = std::make_unique<BarrierBatch>();
+}
+
+void CommandBuffer::flushBarriers() noexcept {
+  m_flushTrackedBarriers();
+  m_flushBarrierBatch();
+}
+
+void CommandBuffer::m_flushBarrierBatch() noexcept {
+  if (!m_barrierBatch || m_barrierBatch->empty())
+    return;
+
+  auto &batch = *m_barrierBatch;
+  m_recordPipelineBarrier(
+      batch.srcStage, batch.dstStage,
+      {batch.memoryBarriers.data(), batch.memoryBarriers.size()},
+      {batch.imageBarriers.data(), batch.imageBarriers.size()},
+      {batch.bufferBarriers.data(), batch.bufferBarriers.size()},
+      batch.flags);
+  batch.clear();
+}
+
+void CommandBuffer::BarrierBatch::clear() noexcept {
+  srcStage = 0;
+  dstStage = 0;
+  flags = 0;
+  memoryBarriers.clear();
+  imageBarriers.clear();
+  bufferBarriers.clear();
+}
+
+void CommandBuffer::enableResourceTracking(bool enable) noexcept(
+    ExceptionsDisabled) {
+  if (!enable) {
+    m_tracker.reset();
+    return;
+  }
+  if (!m_tracker)
+    m_tracker = std::make_unique<ResourceTracker>();
+}
+
+void CommandBuffer::useBuffer(
+    BufferBase const &buffer, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  if (!m_tracker)
+    return;
+  m_tracker->useBuffer(buffer, stage, access);
+  m_checkTrackedBarriers();
+}
+
+void CommandBuffer::useImage(
+    ImageInterface const &image, VkImageSubresourceRange range,
+    VkImageLayout layout, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  if (!m_tracker)
+    return;
+  m_tracker->useImage(image, range, layout, stage, access);
+  m_checkTrackedBarriers();
+}
+
+void CommandBuffer::assumeImageLayout(
+    ImageInterface const &image,
+    VkImageLayout layout) noexcept(ExceptionsDisabled) {
+  if (m_tracker)
+    m_tracker->assumeImageLayout(image, layout);
+}
+
+void CommandBuffer::m_checkTrackedBarriers() noexcept(ExceptionsDisabled) {
+  if (!m_insideRenderPass || m_tracker->pending().empty())
+    return;
+
+  m_tracker->clearPending();
+  postError(Error("CommandBuffer record failed: resource used inside a render "
+                  "pass instance needs a barrier, declare its use before "
+                  "beginRenderPass()"));
+}
+
+void CommandBuffer::m_flushTrackedBarriers() noexcept {
+  if (!m_tracker || m_tracker->pending().empty())
+    return;
+
+  auto const &pending = m_tracker->pending();
+  pipelineBarrier(
+      pending.srcStage, pending.dstStage, {},
+      {pending.imageBarriers.data(), pending.imageBarriers.size()},
+      {pending.bufferBarriers.data(), pending.bufferBarriers.size()});
+  m_tracker->clearPending();
+}
+
 void CommandBuffer::end() noexcept(ExceptionsDisabled) {
+  flushBarriers();
+
   VK_CHECK_RESULT(
       m_device.get().core<1, 0>().vkEndCommandBuffer(m_commandBuffer))
   m_recording = false;
@@ -53,14 +294,39 @@ void CommandBuffer::end() noexcept(ExceptionsDisabled) {
 
 void CommandBuffer::copyBufferToBuffer(
     const BufferBase &src, const BufferBase &dst,
-    std::span<const VkBufferCopy> regions) noexcept {
+    std::span<const VkBufferCopy> regions) noexcept(ExceptionsDisabled) {
+  useBuffer(src, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+  useBuffer(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+  flushBarriers();
+
   m_device.get().core<1, 0>().vkCmdCopyBuffer(m_commandBuffer, src, dst,
                                               regions.size(), regions.data());
 }
 
+void CommandBuffer::fillBuffer(BufferBase const &dst, uint32_t data,
+                               VkDeviceSize offset, VkDeviceSize size) noexcept(
+    ExceptionsDisabled) {
+  useBuffer(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+  flushBarriers();
+
+  m_device.get().core<1, 0>().vkCmdFillBuffer(m_commandBuffer, dst, offset,
+                                              size, data);
+}
+
 void CommandBuffer::copyBufferToImage(
     const BufferBase &src, const AllocatedImage &dst, VkImageLayout layout,
-    std::span<const VkBufferImageCopy> regions) noexcept {
+    std::span<const VkBufferImageCopy> regions) noexcept(ExceptionsDisabled) {
+  if (m_tracker) {
+    useBuffer(src, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    for (auto const &range :
+         regionRanges(regions, [](auto &region) -> auto & {
+           return region.imageSubresource;
+         }))
+      useImage(dst, range, layout, VK_PIPELINE_STAGE_TRANSFER_BIT,
+               VK_ACCESS_TRANSFER_WRITE_BIT);
+  }
+  flushBarriers();
+
   m_device.get().core<1, 0>().vkCmdCopyBufferToImage(
       m_commandBuffer, src, dst, layout, regions.size(), regions.data());
 }
@@ -68,7 +334,23 @@ void CommandBuffer::copyBufferToImage(
 void CommandBuffer::copyImageToImage(
     AllocatedImage const &src, VkImageLayout srcLayout,
     AllocatedImage const &dst, VkImageLayout dstLayout,
-    std::span<const VkImageCopy> regions) noexcept {
+    std::span<const VkImageCopy> regions) noexcept(ExceptionsDisabled) {
+  if (m_tracker) {
+    for (auto const &range :
+         regionRanges(regions, [](auto &region) -> auto & {
+           return region.srcSubresource;
+         }))
+      useImage(src, range, srcLayout, VK_PIPELINE_STAGE_TRANSFER_BIT,
+               VK_ACCESS_TRANSFER_READ_BIT);
+    for (auto const &range :
+         regionRanges(regions, [](auto &region) -> auto & {
+           return region.dstSubresource;
+         }))
+      useImage(dst, range, dstLayout, VK_PIPELINE_STAGE_TRANSFER_BIT,
+               VK_ACCESS_TRANSFER_WRITE_BIT);
+  }
+  flushBarriers();
+
   m_device.get().core<1, 0>().vkCmdCopyImage(m_commandBuffer, src, srcLayout,
                                              dst, dstLayout, regions.size(),
                                              regions.data());
@@ -80,6 +362,67 @@ void CommandBuffer::pipelineBarrier(
     std::span<const VkImageMemoryBarrier> imageMemoryBarrier,
     std::span<const VkBufferMemoryBarrier> bufferMemoryBarrier,
     VkDependencyFlags flags) noexcept {
+  if (!m_barrierBatch) {
+    m_recordPipelineBarrier(srcStage, dstStage, memBarriers,
+                            imageMemoryBarrier, bufferMemoryBarrier, flags);
+    return;
+  }
+
+  auto &batch = *m_barrierBatch;
+
+  // Barriers within a single vkCmdPipelineBarrier are unordered, so
+  // transitions of already batched resources must go into the next batch.
+  bool conflicts = !batch.empty() && batch.flags != flags;
+  for (auto const &barrier : imageMemoryBarrier) {
+    if (conflicts)
+      break;
+    conflicts = std::any_of(batch.imageBarriers.begin(),
+                            batch.imageBarriers.end(),
+                            [&barrier](VkImageMemoryBarrier const &batched) {
+                              return batched.image == barrier.image &&
+                                     overlaps(batched.subresourceRange,
+                                              barrier.subresourceRange);
+                            });
+  }
+  for (auto const &barrier : bufferMemoryBarrier) {
+    if (conflicts)
+      break;
+    conflicts = std::any_of(batch.bufferBarriers.begin(),
+                            batch.bufferBarriers.end(),
+                            [&barrier](VkBufferMemoryBarrier const &batched) {
+                              return overlaps(batched, barrier);
+                            });
+  }
+  if (conflicts)
+    m_flushBarrierBatch();
+
+  batch.srcStage |= srcStage;
+  batch.dstStage |= dstStage;
+  batch.flags = flags;
+
+  // Global memory barriers are folded into one
+  for (auto const &barrier : memBarriers) {
+    if (batch.memoryBarriers.empty()) {
+      batch.memoryBarriers.push_back(barrier);
+      continue;
+    }
+    batch.memoryBarriers.front().srcAccessMask |= barrier.srcAccessMask;
+    batch.memoryBarriers.front().dstAccessMask |= barrier.dstAccessMask;
+  }
+  batch.imageBarriers.insert(batch.imageBarriers.end(),
+                             imageMemoryBarrier.begin(),
+                             imageMemoryBarrier.end());
+  batch.bufferBarriers.insert(batch.bufferBarriers.end(),
+                              bufferMemoryBarrier.begin(),
+                              bufferMemoryBarrier.end());
+}
+
+void CommandBuffer::m_recordPipelineBarrier(
+    VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+    std::span<const VkMemoryBarrier> memBarriers,
+    std::span<const VkImageMemoryBarrier> imageMemoryBarrier,
+    std::span<const VkBufferMemoryBarrier> bufferMemoryBarrier,
+    VkDependencyFlags flags) noexcept {
   m_device.get().core<1, 0>().vkCmdPipelineBarrier(
       m_commandBuffer, srcStage, dstStage, flags, memBarriers.size(),
       memBarriers.data(), bufferMemoryBarrier.size(),
@@ -87,63 +430,286 @@ void CommandBuffer::pipelineBarrier(
       imageMemoryBarrier.data());
 }
 
-void CommandBuffer::m_bindVertexBuffer(VkBuffer buffer, uint32_t binding,
-                                       VkDeviceSize offset) noexcept {
-  m_device.get().core<1, 0>().vkCmdBindVertexBuffers(m_commandBuffer, binding,
-                                                     1, &buffer, &offset);
+void CommandBuffer::pipelineBarrier2(
+    VkDependencyInfo const &dependencyInfo) noexcept(ExceptionsDisabled) {
+  flushBarriers();
+  m_device.get().synchronization2().vkCmdPipelineBarrier2(m_commandBuffer,
+                                                          &dependencyInfo);
+}
+
+void CommandBuffer::pipelineBarrier2(
+    std::span<const VkMemoryBarrier2> memBarriers,
+    std::span<const VkImageMemoryBarrier2> imageMemoryBarrier,
+    std::span<const VkBufferMemoryBarrier2> bufferMemoryBarrier,
+    VkDependencyFlags flags) noexcept(ExceptionsDisabled) {
+  VkDependencyInfo dependencyInfo{};
+  dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependencyInfo.pNext = nullptr;
+  dependencyInfo.dependencyFlags = flags;
+  dependencyInfo.memoryBarrierCount = memBarriers.size();
+  dependencyInfo.pMemoryBarriers = memBarriers.data();
+  dependencyInfo.imageMemoryBarrierCount = imageMemoryBarrier.size();
+  dependencyInfo.pImageMemoryBarriers = imageMemoryBarrier.data();
+  dependencyInfo.bufferMemoryBarrierCount = bufferMemoryBarrier.size();
+  dependencyInfo.pBufferMemoryBarriers = bufferMemoryBarrier.data();
+
+  pipelineBarrier2(dependencyInfo);
+}
+
+void CommandBuffer::m_bindVertexBuffers(
+    uint32_t firstBinding, std::span<BufferBase const *const> buffers,
+    std::span<const VkDeviceSize> offsets) noexcept(ExceptionsDisabled) {
+  if (buffers.size() != offsets.size())
+    postError(Error("CommandBuffer: vertex buffer and offset counts differ"));
+
+  boost::container::small_vector<VkBuffer, 4> rawBuffers;
+  for (auto *buffer : buffers) {
+    useBuffer(*buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+              VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+    rawBuffers.push_back(*buffer);
+  }
+
+  size_t first = 0;
+  size_t last = rawBuffers.size();
+  if (m_bindState) {
+    // Only the span of changed bindings is rebound
+    auto &bound = m_bindState->vertexBuffers;
+    auto unchanged = [&](size_t i) {
+      return firstBinding + i < BindState::MaxVertexBindings &&
+             bound[firstBinding + i] == std::pair{rawBuffers[i], offsets[i]};
+    };
+    while (first < last && unchanged(first))
+      ++first;
+    while (last > first && unchanged(last - 1))
+      --last;
+
+    m_skippedBinds.vertexBuffers += rawBuffers.size() - (last - first);
+    if (first == last)
+      return;
+
+    for (size_t i = first;
+         i < last && firstBinding + i < BindState::MaxVertexBindings; ++i)
+      bound[firstBinding + i] = {rawBuffers[i], offsets[i]};
+  }
+
+  m_device.get().core<1, 0>().vkCmdBindVertexBuffers(
+      m_commandBuffer, firstBinding + first, last - first,
+      rawBuffers.data() + first, offsets.data() + first);
 }
 
-void CommandBuffer::m_bindIndexBuffer(VkBuffer buffer, VkIndexType type,
-                                      VkDeviceSize offset) noexcept {
+void CommandBuffer::m_bindIndexBuffer(
+    BufferBase const &buffer, VkIndexType type,
+    VkDeviceSize offset) noexcept(ExceptionsDisabled) {
+  useBuffer(buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VK_ACCESS_INDEX_READ_BIT);
+
+  if (m_bindState) {
+    auto &state = *m_bindState;
+    VkBuffer rawBuffer = buffer;
+    if (state.indexBuffer == rawBuffer && state.indexOffset == offset &&
+        state.indexType == type) {
+      ++m_skippedBinds.indexBuffers;
+      return;
+    }
+    state.indexBuffer = rawBuffer;
+    state.indexOffset = offset;
+    state.indexType = type;
+  }
+
   m_device.get().core<1, 0>().vkCmdBindIndexBuffer(m_commandBuffer, buffer,
                                                    offset, type);
 }
 
 void CommandBuffer::draw(uint32_t vertexCount, uint32_t instanceCount,
                          uint32_t firstVertex,
-                         uint32_t firstInstance) noexcept {
+                         uint32_t firstInstance) noexcept(ExceptionsDisabled) {
+  flushBarriers();
   m_device.get().core<1, 0>().vkCmdDraw(
       m_commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
 void CommandBuffer::drawIndexed(uint32_t indexCount, uint32_t instanceCount,
                                 uint32_t firstIndex, int32_t vertexOffset,
-                                uint32_t firstInstance) noexcept {
+                                uint32_t firstInstance) noexcept(
+    ExceptionsDisabled) {
+  flushBarriers();
   m_device.get().core<1, 0>().vkCmdDrawIndexed(m_commandBuffer, indexCount,
                                                instanceCount, firstIndex,
                                                vertexOffset, firstInstance);
 }
 
 void CommandBuffer::dispatch(uint32_t groupCountX, uint32_t groupCountY,
-                             uint32_t groupCountZ) noexcept {
+                             uint32_t groupCountZ) noexcept(
+    ExceptionsDisabled) {
+  flushBarriers();
   m_device.get().core<1, 0>().vkCmdDispatch(m_commandBuffer, groupCountX,
                                             groupCountY, groupCountZ);
 }
 
+void CommandBuffer::drawMulti(std::span<const VkMultiDrawInfoEXT> draws,
+                              uint32_t instanceCount,
+                              uint32_t firstInstance) noexcept(
+    ExceptionsDisabled) {
+  flushBarriers();
+
+  auto &device = m_device.get();
+  if (!device.physicalDevice().isFeatureEnabled(
+          PhysicalDevice::extended_feature::multiDraw)) {
+    for (auto const &draw : draws)
+      device.core<1, 0>().vkCmdDraw(m_commandBuffer, draw.vertexCount,
+                                    instanceCount, draw.firstVertex,
+                                    firstInstance);
+    return;
+  }
+
+  auto &symbols = device.multiDraw();
+  size_t maxCount =
+      device.physicalDevice().multiDrawProperties().maxMultiDrawCount;
+  for (size_t first = 0; first < draws.size(); first += maxCount) {
+    auto count = std::min(maxCount, draws.size() - first);
+    symbols.vkCmdDrawMultiEXT(m_commandBuffer, count, draws.data() + first,
+                              instanceCount, firstInstance,
+                              sizeof(VkMultiDrawInfoEXT));
+  }
+}
+
+void CommandBuffer::drawMultiIndexed(
+    std::span<const VkMultiDrawIndexedInfoEXT> draws, uint32_t instanceCount,
+    uint32_t firstInstance,
+    std::optional<int32_t> vertexOffset) noexcept(ExceptionsDisabled) {
+  flushBarriers();
+
+  auto &device = m_device.get();
+  if (!device.physicalDevice().isFeatureEnabled(
+          PhysicalDevice::extended_feature::multiDraw)) {
+    for (auto const &draw : draws)
+      device.core<1, 0>().vkCmdDrawIndexed(
+          m_commandBuffer, draw.indexCount, instanceCount, draw.firstIndex,
+          vertexOffset.value_or(draw.vertexOffset), firstInstance);
+    return;
+  }
+
+  auto &symbols = device.multiDraw();
+  size_t maxCount =
+      device.physicalDevice().multiDrawProperties().maxMultiDrawCount;
+  int32_t const *pVertexOffset = vertexOffset ? &*vertexOffset : nullptr;
+  for (size_t first = 0; first < draws.size(); first += maxCount) {
+    auto count = std::min(maxCount, draws.size() - first);
+    symbols.vkCmdDrawMultiIndexedEXT(
+        m_commandBuffer, count, draws.data() + first, instanceCount,
+        firstInstance, sizeof(VkMultiDrawIndexedInfoEXT), pVertexOffset);
+  }
+}
+
+void CommandBuffer::drawIndirect(BufferBase const &buffer, VkDeviceSize offset,
+                                 uint32_t drawCount, uint32_t stride) noexcept(
+    ExceptionsDisabled) {
+  useBuffer(buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+  flushBarriers();
+  m_device.get().core<1, 0>().vkCmdDrawIndirect(m_commandBuffer, buffer,
+                                                offset, drawCount, stride);
+}
+
+void CommandBuffer::drawIndexedIndirect(
+    BufferBase const &buffer, VkDeviceSize offset, uint32_t drawCount,
+    uint32_t stride) noexcept(ExceptionsDisabled) {
+  useBuffer(buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+  flushBarriers();
+  m_device.get().core<1, 0>().vkCmdDrawIndexedIndirect(
+      m_commandBuffer, buffer, offset, drawCount, stride);
+}
+
+void CommandBuffer::drawIndirectCount(
+    BufferBase const &buffer, VkDeviceSize offset,
+    BufferBase const &countBuffer, VkDeviceSize countOffset,
+    uint32_t maxDrawCount, uint32_t stride) noexcept(ExceptionsDisabled) {
+  auto &symbols = m_device.get().drawIndirectCount();
+  useBuffer(buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+  useBuffer(countBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+  flushBarriers();
+  symbols.vkCmdDrawIndirectCount(m_commandBuffer, buffer, offset, countBuffer,
+                                 countOffset, maxDrawCount, stride);
+}
+
+void CommandBuffer::drawIndexedIndirectCount(
+    BufferBase const &buffer, VkDeviceSize offset,
+    BufferBase const &countBuffer, VkDeviceSize countOffset,
+    uint32_t maxDrawCount, uint32_t stride) noexcept(ExceptionsDisabled) {
+  auto &symbols = m_device.get().drawIndirectCount();
+  useBuffer(buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+  useBuffer(countBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+  flushBarriers();
+  symbols.vkCmdDrawIndexedIndirectCount(m_commandBuffer, buffer, offset,
+                                        countBuffer, countOffset, maxDrawCount,
+                                        stride);
+}
+
+void CommandBuffer::dispatchIndirect(BufferBase const &buffer,
+                                     VkDeviceSize offset) noexcept(
+    ExceptionsDisabled) {
+  useBuffer(buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+  flushBarriers();
+  m_device.get().core<1, 0>().vkCmdDispatchIndirect(m_commandBuffer, buffer,
+                                                    offset);
+}
+
 void CommandBuffer::bindGraphicsPipeline(
     GraphicsPipeline const &pipeline) noexcept {
+  if (m_elidePipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline))
+    return;
   m_device.get().core<1, 0>().vkCmdBindPipeline(
       m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 }
 
 void CommandBuffer::bindComputePipeline(
     ComputePipeline const &pipeline) noexcept {
+  if (m_elidePipeline(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline))
+    return;
   m_device.get().core<1, 0>().vkCmdBindPipeline(
       m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 }
 void CommandBuffer::copyImageToBuffer(
     AllocatedImage const &src, VkImageLayout layout, BufferBase const &dst,
-    std::span<VkBufferImageCopy> regions) noexcept {
+    std::span<VkBufferImageCopy> regions) noexcept(ExceptionsDisabled) {
+  if (m_tracker) {
+    for (auto const &range :
+         regionRanges(regions, [](auto &region) -> auto & {
+           return region.imageSubresource;
+         }))
+      useImage(src, range, layout, VK_PIPELINE_STAGE_TRANSFER_BIT,
+               VK_ACCESS_TRANSFER_READ_BIT);
+    useBuffer(dst, VK_PIPELINE_STAGE_TRANSFER_BIT,
+              VK_ACCESS_TRANSFER_WRITE_BIT);
+  }
+  flushBarriers();
+
   m_device.get().core<1, 0>().vkCmdCopyImageToBuffer(
       m_commandBuffer, src, layout, dst, regions.size(), regions.data());
 }
 void CommandBuffer::setScissors(std::span<const VkRect2D> scissors,
                                 uint32_t firstScissor) noexcept {
+  if (m_bindState &&
+      elideDynamicState(m_bindState->scissors, firstScissor, scissors)) {
+    ++m_skippedBinds.scissors;
+    return;
+  }
   m_device.get().core<1, 0>().vkCmdSetScissor(m_commandBuffer, firstScissor,
                                               scissors.size(), scissors.data());
 }
 void CommandBuffer::setViewports(std::span<const VkViewport> viewports,
                                  uint32_t firstViewport) noexcept {
+  if (m_bindState &&
+      elideDynamicState(m_bindState->viewports, firstViewport, viewports)) {
+    ++m_skippedBinds.viewports;
+    return;
+  }
   m_device.get().core<1, 0>().vkCmdSetViewport(
       m_commandBuffer, firstViewport, viewports.size(), viewports.data());
 }
@@ -158,6 +724,8 @@ void PrimaryCommandBuffer::beginRenderPass(
         Error("CommandBuffer record failed: called beginRenderPass() while "
               "having another RenderPass active"));
 #endif
+  flushBarriers();
+
   VkRenderPassBeginInfo beginInfo{};
   beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
   beginInfo.pNext = nullptr;
@@ -171,6 +739,8 @@ void PrimaryCommandBuffer::beginRenderPass(
       m_commandBuffer, &beginInfo,
       useSecondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
                    : VK_SUBPASS_CONTENTS_INLINE);
+  invalidateBindState();
+  m_insideRenderPass = true;
 #ifdef VKW_COMMAND_BUFFER_TRACK_RENDER_PASSES
   m_currentPass = renderPass;
   m_currentSubpass = 0;
@@ -187,6 +757,7 @@ void PrimaryCommandBuffer::nextSubpass(bool useSecondary) noexcept(
     postError(Error("CommandBuffer record failed: call to nextSubpass() caused "
                     "subpass overflow"));
 #endif
+  flushBarriers();
   m_device.get().core<1, 0>().vkCmdNextSubpass(
       m_commandBuffer, useSecondary
                            ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
@@ -202,7 +773,9 @@ void PrimaryCommandBuffer::endRenderPass() noexcept(ExceptionsDisabled) {
     postError(Error("CommandBuffer record failed: called endRenderPass() while "
                     "having no RenderPass active"));
 #endif
+  flushBarriers();
   m_device.get().core<1, 0>().vkCmdEndRenderPass(m_commandBuffer);
+  m_insideRenderPass = false;
 #ifdef VKW_COMMAND_BUFFER_TRACK_RENDER_PASSES
   m_currentPass.reset();
 #endif
@@ -210,8 +783,11 @@ void PrimaryCommandBuffer::endRenderPass() noexcept(ExceptionsDisabled) {
 
 void PrimaryCommandBuffer::m_executeCommands(
     size_t nbufs, const VkCommandBuffer *buffers) noexcept {
+  flushBarriers();
   m_device.get().core<1, 0>().vkCmdExecuteCommands(m_commandBuffer, nbufs,
                                                    buffers);
+  // State of the primary command buffer is undefined after execution
+  invalidateBindState();
 }
 
 void CommandBuffer::m_pushConstants(PipelineLayout const &layout,
@@ -223,22 +799,136 @@ void CommandBuffer::m_pushConstants(PipelineLayout const &layout,
 }
 void CommandBuffer::blitImage(const AllocatedImage &targetImage,
                               VkImageBlit blit, bool usingGeneralLayout,
-                              VkFilter filter) noexcept {
+                              VkFilter filter) noexcept(ExceptionsDisabled) {
   auto srcLayout = usingGeneralLayout ? VK_IMAGE_LAYOUT_GENERAL
                                       : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
   auto dstLayout = usingGeneralLayout ? VK_IMAGE_LAYOUT_GENERAL
                                       : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 
+  if (m_tracker) {
+    auto range = [](VkImageSubresourceLayers const &layers) {
+      return VkImageSubresourceRange{layers.aspectMask, layers.mipLevel, 1,
+                                     layers.baseArrayLayer, layers.layerCount};
+    };
+    useImage(targetImage, range(blit.srcSubresource), srcLayout,
+             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    useImage(targetImage, range(blit.dstSubresource), dstLayout,
+             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+  }
+  flushBarriers();
+
   m_device.get().core<1, 0>().vkCmdBlitImage(m_commandBuffer, targetImage,
                                              srcLayout, targetImage, dstLayout,
                                              1, &blit, filter);
 }
+void CommandBuffer::pushDescriptorSet(
+    PipelineLayout const &layout, VkPipelineBindPoint bindPoint, uint32_t set,
+    PushDescriptorSet const &writes) noexcept(ExceptionsDisabled) {
+  auto &symbols = m_device.get().pushDescriptor();
+  m_invalidatePushedSet(bindPoint, layout, set);
+
+  auto rawWrites = writes.m_writes();
+  symbols.vkCmdPushDescriptorSet(m_commandBuffer, bindPoint, layout, set,
+                                 rawWrites.size(), rawWrites.data());
+}
+
+void CommandBuffer::pushDescriptorSet(
+    DescriptorUpdateTemplate const &updateTemplate,
+    void const *data) noexcept(ExceptionsDisabled) {
+  if (!updateTemplate.pushDescriptors())
+    postError(Error("CommandBuffer: descriptor update template was not "
+                    "created for push descriptors"));
+
+  auto &symbols = m_device.get().pushDescriptor();
+  if (!symbols.vkCmdPushDescriptorSetWithTemplate)
+    postError(Error{"Cannot push descriptors with template: descriptor update "
+                    "templates are unavailable",
+                    ErrorCode::EXTENSION_MISSING});
+
+  m_invalidatePushedSet(updateTemplate.bindPoint(),
+                        updateTemplate.pipelineLayout(), updateTemplate.set());
+  symbols.vkCmdPushDescriptorSetWithTemplate(
+      m_commandBuffer, updateTemplate, updateTemplate.pipelineLayout(),
+      updateTemplate.set(), data);
+}
+
+void CommandBuffer::bindDescriptorBuffers(
+    std::span<const VkDescriptorBufferBindingInfoEXT> bindingInfos) noexcept(
+    ExceptionsDisabled) {
+  m_device.get().descriptorBuffer().vkCmdBindDescriptorBuffersEXT(
+      m_commandBuffer, bindingInfos.size(), bindingInfos.data());
+}
+
+void CommandBuffer::setDescriptorBufferOffsets(
+    PipelineLayout const &layout, VkPipelineBindPoint bindPoint,
+    uint32_t firstSet, std::span<const uint32_t> bufferIndices,
+    std::span<const VkDeviceSize> offsets) noexcept(ExceptionsDisabled) {
+  if (bufferIndices.size() != offsets.size())
+    postError(Error("CommandBuffer: " + std::to_string(bufferIndices.size()) +
+                    " descriptor buffer indices given for " +
+                    std::to_string(offsets.size()) + " offsets"));
+
+  auto &symbols = m_device.get().descriptorBuffer();
+
+  // Sets bound with vkCmdBindDescriptorSets don't survive switching to
+  // descriptor buffers
+  auto *state = m_bindState ? m_bindState->bindPoint(bindPoint) : nullptr;
+  if (state) {
+    state->sets.fill(VK_NULL_HANDLE);
+    state->layout = layout;
+  }
+
+  symbols.vkCmdSetDescriptorBufferOffsetsEXT(
+      m_commandBuffer, bindPoint, layout, firstSet, offsets.size(),
+      bufferIndices.data(), offsets.data());
+}
+
+void CommandBuffer::m_invalidatePushedSet(VkPipelineBindPoint bindPoint,
+                                          VkPipelineLayout layout,
+                                          uint32_t set) noexcept {
+  // Pushed set replaces whatever was bound to its slot
+  auto *state = m_bindState ? m_bindState->bindPoint(bindPoint) : nullptr;
+  if (!state)
+    return;
+
+  if (state->layout != layout) {
+    state->sets.fill(VK_NULL_HANDLE);
+    state->layout = layout;
+  }
+  if (set < BindState::MaxSets)
+    state->sets[set] = VK_NULL_HANDLE;
+}
+
 void CommandBuffer::m_bindDescriptorSets(const PipelineLayout &layout,
                                          VkPipelineBindPoint bindPoint,
                                          size_t firstSet,
                                          VkDescriptorSet const *sets,
-                                         size_t nsets, uint32_t *dynOffsets,
+                                         size_t nsets,
+                                         uint32_t const *dynOffsets,
                                          size_t ndynOffsets) noexcept {
+  auto *state = m_bindState ? m_bindState->bindPoint(bindPoint) : nullptr;
+  if (state) {
+    VkPipelineLayout rawLayout = layout;
+    // Sets with dynamic offsets are always rebound: offsets are not shadowed
+    if (ndynOffsets == 0 && state->layout == rawLayout &&
+        firstSet + nsets <= BindState::MaxSets &&
+        std::equal(sets, sets + nsets, state->sets.begin() + firstSet,
+                   [](VkDescriptorSet set, VkDescriptorSet bound) {
+                     return set != VK_NULL_HANDLE && set == bound;
+                   })) {
+      ++m_skippedBinds.descriptorSets;
+      return;
+    }
+
+    // Binding with another layout may disturb any previously bound set
+    if (state->layout != rawLayout) {
+      state->sets.fill(VK_NULL_HANDLE);
+      state->layout = rawLayout;
+    }
+    for (size_t i = 0; i < nsets && firstSet + i < BindState::MaxSets; ++i)
+      state->sets[firstSet + i] = ndynOffsets == 0 ? sets[i] : VK_NULL_HANDLE;
+  }
+
   m_device.get().core<1, 0>().vkCmdBindDescriptorSets(
       m_commandBuffer, bindPoint, layout, firstSet, nsets, sets, ndynOffsets,
       dynOffsets);
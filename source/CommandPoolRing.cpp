@@ -0,0 +1,102 @@
+#include "vkw/CommandPoolRing.hpp"
+#include "Utils.hpp"
+
+#include <boost/container/small_vector.hpp>
+
+namespace vkw {
+
+CommandPoolRing::CommandPoolRing(
+    Device const &device, uint32_t queueFamily, uint32_t framesInFlight,
+    uint32_t threadCount,
+    uint32_t allocationBatch) noexcept(ExceptionsDisabled)
+    : m_device(device), m_threadCount(threadCount),
+      m_allocationBatch(std::max(allocationBatch, 1u)),
+      m_currentFrame(framesInFlight - 1) {
+  if (framesInFlight == 0 || threadCount == 0)
+    postError(Error("CommandPoolRing: frame and thread count must be "
+                    "non-zero"));
+
+  for (uint32_t frame = 0; frame < framesInFlight; ++frame) {
+    auto &slot = m_frames.emplace_back(device);
+    for (uint32_t thread = 0; thread < threadCount; ++thread)
+      slot.pools.emplace_back(device, queueFamily);
+  }
+}
+
+void CommandPoolRing::beginFrame() noexcept(ExceptionsDisabled) {
+  m_currentFrame = (m_currentFrame + 1) % m_frames.size();
+  auto &frame = m_frames[m_currentFrame];
+
+  frame.fence.wait();
+  frame.fence.reset();
+
+  auto &device = m_device.get();
+  for (auto &threadPool : frame.pools) {
+    // Keep pool memory around: the next frame will most likely need the
+    // same amount.
+    VK_CHECK_RESULT(device.core<1, 0>().vkResetCommandPool(
+        device, threadPool.pool, 0))
+
+    for (auto &buffer : threadPool.primaries.buffers) {
+      buffer->m_recording = false;
+      buffer->m_executable = false;
+    }
+    for (auto &buffer : threadPool.secondaries.buffers) {
+      buffer->m_recording = false;
+      buffer->m_executable = false;
+    }
+    threadPool.primaries.used = 0;
+    threadPool.secondaries.used = 0;
+  }
+}
+
+PrimaryCommandBuffer &
+CommandPoolRing::primary(uint32_t thread) noexcept(ExceptionsDisabled) {
+  auto &threadPool = m_threadPool(thread);
+  return m_acquire(threadPool.pool, threadPool.primaries,
+                   VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+}
+
+SecondaryCommandBuffer &
+CommandPoolRing::secondary(uint32_t thread) noexcept(ExceptionsDisabled) {
+  auto &threadPool = m_threadPool(thread);
+  return m_acquire(threadPool.pool, threadPool.secondaries,
+                   VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+}
+
+CommandPoolRing::ThreadPool &
+CommandPoolRing::m_threadPool(uint32_t thread) noexcept(ExceptionsDisabled) {
+  if (thread >= m_threadCount)
+    postError(Error("CommandPoolRing: thread index out of range"));
+
+  return m_frames[m_currentFrame].pools[thread];
+}
+
+template <typename T>
+T &CommandPoolRing::m_acquire(
+    CommandPool &pool, FreeList<T> &freeList,
+    VkCommandBufferLevel level) noexcept(ExceptionsDisabled) {
+  if (freeList.used < freeList.buffers.size())
+    return *freeList.buffers[freeList.used++];
+
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.pNext = nullptr;
+  allocInfo.commandPool = pool;
+  allocInfo.level = level;
+  allocInfo.commandBufferCount = m_allocationBatch;
+
+  boost::container::small_vector<VkCommandBuffer, 8> handles(
+      m_allocationBatch);
+  auto &device = m_device.get();
+  VK_CHECK_RESULT(device.core<1, 0>().vkAllocateCommandBuffers(
+      device, &allocInfo, handles.data()))
+
+  freeList.buffers.reserve(freeList.buffers.size() + handles.size());
+  for (auto handle : handles)
+    freeList.buffers.emplace_back(new T(pool, handle));
+
+  return *freeList.buffers[freeList.used++];
+}
+
+} // namespace vkw
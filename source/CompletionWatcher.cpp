@@ -0,0 +1,237 @@
+#include "vkw/CompletionWatcher.hpp"
+#include "Utils.hpp"
+#include "vkw/Fence.hpp"
+#include "vkw/Semaphore.hpp"
+
+#include <boost/container/small_vector.hpp>
+
+#include <algorithm>
+#include <memory>
+
+namespace vkw {
+
+CompletionWatcher::CompletionWatcher(
+    Device const &device, std::chrono::microseconds pollInterval) noexcept
+    : m_device(device), m_pollInterval(pollInterval) {
+  m_thread = std::thread([this]() { m_run(); });
+}
+
+CompletionWatcher::~CompletionWatcher() {
+  {
+    std::lock_guard lock{m_mutex};
+    m_stop = true;
+  }
+  m_wakeUp.notify_one();
+  m_thread.join();
+}
+
+void CompletionWatcher::onComplete(Fence const &fence,
+                                   Callback callback) noexcept(
+    ExceptionsDisabled) {
+  {
+    std::lock_guard lock{m_mutex};
+    m_newFences.emplace_back(FenceWait{fence, std::move(callback)});
+  }
+  m_wakeUp.notify_one();
+}
+
+void CompletionWatcher::onComplete(TimelineSemaphore const &semaphore,
+                                   uint64_t value, Callback callback) noexcept(
+    ExceptionsDisabled) {
+  // Fail on the calling thread rather than on the watcher thread
+  m_device.get().timelineSemaphore();
+
+  {
+    std::lock_guard lock{m_mutex};
+    m_newTimelines.emplace_back(
+        TimelineWait{semaphore, value, std::move(callback)});
+  }
+  m_wakeUp.notify_one();
+}
+
+namespace {
+
+CompletionWatcher::Callback
+promiseCallback(std::shared_ptr<std::promise<void>> promise) noexcept(
+    ExceptionsDisabled) {
+  return [promise = std::move(promise)](VkResult result) {
+    if (result == VK_SUCCESS)
+      promise->set_value();
+    else if (result == CompletionWatcher::Abandoned)
+      promise->set_exception(std::make_exception_ptr(
+          Error("CompletionWatcher destroyed before the wait completed")));
+    else
+      promise->set_exception(
+          std::make_exception_ptr(VulkanError(result, __FILE__, __LINE__)));
+  };
+}
+
+} // namespace
+
+std::future<void> CompletionWatcher::whenComplete(Fence const &fence) noexcept(
+    ExceptionsDisabled) {
+  auto promise = std::make_shared<std::promise<void>>();
+  auto future = promise->get_future();
+  onComplete(fence, promiseCallback(std::move(promise)));
+  return future;
+}
+
+std::future<void>
+CompletionWatcher::whenComplete(TimelineSemaphore const &semaphore,
+                                uint64_t value) noexcept(ExceptionsDisabled) {
+  auto promise = std::make_shared<std::promise<void>>();
+  auto future = promise->get_future();
+  onComplete(semaphore, value, promiseCallback(std::move(promise)));
+  return future;
+}
+
+void CompletionWatcher::m_run() noexcept {
+  for (;;) {
+    bool stop;
+    {
+      std::unique_lock lock{m_mutex};
+      m_wakeUp.wait(lock, [this]() {
+        return m_stop || !m_newFences.empty() || !m_newTimelines.empty() ||
+               !m_fences.empty() || !m_timelines.empty();
+      });
+
+      std::move(m_newFences.begin(), m_newFences.end(),
+                std::back_inserter(m_fences));
+      m_newFences.clear();
+      std::move(m_newTimelines.begin(), m_newTimelines.end(),
+                std::back_inserter(m_timelines));
+      m_newTimelines.clear();
+      stop = m_stop;
+    }
+
+    auto timeout =
+        stop ? 0
+             : std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   m_pollInterval)
+                   .count();
+
+    m_poll(timeout);
+
+    if (stop) {
+      // Nothing is going to complete these anymore: resume the waiters
+      // instead of leaking them
+      for (auto &wait : m_fences)
+        wait.callback(Abandoned);
+      for (auto &wait : m_timelines)
+        wait.callback(Abandoned);
+      m_fences.clear();
+      m_timelines.clear();
+      return;
+    }
+  }
+}
+
+void CompletionWatcher::m_poll(uint64_t timeout) noexcept {
+  // Block on one kind of primitive only, the other one gets polled right
+  // after. Failure of the blocking wait is not reported by itself: every
+  // wait gets its own result from the status queries below.
+  auto waitResult = VK_SUCCESS;
+  if (!m_fences.empty())
+    waitResult = m_waitFences(timeout);
+  else if (!m_timelines.empty())
+    waitResult = m_waitTimelines(timeout);
+
+  auto &device = m_device.get();
+
+  for (auto &wait : m_fences)
+    wait.result = device.core<1, 0>().vkGetFenceStatus(device, wait.fence);
+
+  if (!m_timelines.empty()) {
+    // One counter query per semaphore, however many values are awaited
+    struct Counter {
+      VkSemaphore semaphore;
+      VkResult result;
+      uint64_t value;
+    };
+    boost::container::small_vector<Counter, 8> counters;
+    auto counter = [&](VkSemaphore semaphore) -> Counter const & {
+      auto found = std::find_if(
+          counters.begin(), counters.end(),
+          [semaphore](auto const &c) { return c.semaphore == semaphore; });
+      if (found != counters.end())
+        return *found;
+
+      uint64_t value = 0;
+      auto result = device.timelineSemaphore().vkGetSemaphoreCounterValue(
+          device, semaphore, &value);
+      return counters.emplace_back(Counter{semaphore, result, value});
+    };
+
+    for (auto &wait : m_timelines) {
+      auto &current = counter(wait.semaphore);
+      if (current.result != VK_SUCCESS)
+        wait.result = current.result;
+      else
+        wait.result = current.value < wait.value ? VK_NOT_READY : VK_SUCCESS;
+    }
+  }
+
+  boost::container::small_vector<std::pair<Callback, VkResult>, 8> completed;
+  auto collect = [&completed](auto &waits) {
+    auto end = std::stable_partition(
+        waits.begin(), waits.end(),
+        [](auto const &wait) { return wait.result == VK_NOT_READY; });
+    std::for_each(end, waits.end(), [&completed](auto &wait) {
+      completed.emplace_back(std::move(wait.callback), wait.result);
+    });
+    waits.erase(end, waits.end());
+  };
+  collect(m_fences);
+  collect(m_timelines);
+
+  for (auto &[callback, result] : completed)
+    callback(result);
+
+  // Waits that failed immediately without failing any status query would
+  // otherwise keep this thread spinning
+  if (waitResult != VK_SUCCESS && waitResult != VK_TIMEOUT && timeout != 0 &&
+      (!m_fences.empty() || !m_timelines.empty()))
+    std::this_thread::sleep_for(m_pollInterval);
+}
+
+VkResult CompletionWatcher::m_waitFences(uint64_t timeout) noexcept {
+  boost::container::small_vector<VkFence, 16> fences;
+  for (auto const &wait : m_fences)
+    if (std::find(fences.begin(), fences.end(), wait.fence) == fences.end())
+      fences.push_back(wait.fence);
+
+  auto &device = m_device.get();
+  return device.core<1, 0>().vkWaitForFences(device, fences.size(),
+                                             fences.data(), VK_FALSE, timeout);
+}
+
+VkResult CompletionWatcher::m_waitTimelines(uint64_t timeout) noexcept {
+  // Only the smallest awaited value of every semaphore matters
+  boost::container::small_vector<VkSemaphore, 16> semaphores;
+  boost::container::small_vector<uint64_t, 16> values;
+  for (auto const &wait : m_timelines) {
+    auto found =
+        std::find(semaphores.begin(), semaphores.end(), wait.semaphore);
+    if (found == semaphores.end()) {
+      semaphores.push_back(wait.semaphore);
+      values.push_back(wait.value);
+      continue;
+    }
+    auto &value = values[found - semaphores.begin()];
+    value = std::min(value, wait.value);
+  }
+
+  VkSemaphoreWaitInfo waitInfo{};
+  waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  waitInfo.pNext = nullptr;
+  waitInfo.flags = VK_SEMAPHORE_WAIT_ANY_BIT;
+  waitInfo.semaphoreCount = semaphores.size();
+  waitInfo.pSemaphores = semaphores.data();
+  waitInfo.pValues = values.data();
+
+  auto &device = m_device.get();
+  return device.timelineSemaphore().vkWaitSemaphores(device, &waitInfo,
+                                                     timeout);
+}
+
+} // namespace vkw
@@ -0,0 +1,113 @@
+#include "vkw/CullingPass.hpp"
+#include "vkw/PipelineCache.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace vkw {
+
+namespace {
+
+// Generated from shaders/CullingPass.comp at build time
+#include "CullingPass.comp.inc"
+
+std::array<DescriptorSetLayoutBinding, 5> cullingBindings() noexcept {
+  return {DescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                     VK_SHADER_STAGE_COMPUTE_BIT},
+          DescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                     VK_SHADER_STAGE_COMPUTE_BIT},
+          DescriptorSetLayoutBinding{2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                     VK_SHADER_STAGE_COMPUTE_BIT},
+          DescriptorSetLayoutBinding{3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                     VK_SHADER_STAGE_COMPUTE_BIT},
+          DescriptorSetLayoutBinding{
+              4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+              VK_SHADER_STAGE_COMPUTE_BIT}};
+}
+
+// Must match push constants declared in shaders/CullingPass.comp
+struct CullingConstants {
+  uint32_t instanceCount;
+  uint32_t capacity;
+};
+
+constexpr std::array<VkPushConstantRange, 1> cullingPushConstants{
+    VkPushConstantRange{VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                        sizeof(CullingConstants)}};
+
+} // namespace
+
+CullingPass::CullingPass(Device &device) noexcept(ExceptionsDisabled)
+    : m_shader(device, SPIRVModule{CullingPassSPIRV}),
+      m_setLayout(device, cullingBindings()),
+      m_layout(device, m_setLayout, cullingPushConstants),
+      m_pipeline(device, ComputePipelineCreateInfo{m_layout, m_shader}) {}
+
+CullingPass::CullingPass(Device &device, PipelineCache const &cache) noexcept(
+    ExceptionsDisabled)
+    : m_shader(device, SPIRVModule{CullingPassSPIRV}),
+      m_setLayout(device, cullingBindings()),
+      m_layout(device, m_setLayout, cullingPushConstants),
+      m_pipeline(device, ComputePipelineCreateInfo{m_layout, m_shader},
+                 cache) {}
+
+void CullingPass::updateSet(DescriptorSet &set,
+                            Resources const &resources) const noexcept {
+  set.write(0, resources.view);
+  set.write(1, resources.instances, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+  set.write(2, resources.commands, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+  set.write(3, resources.drawCount, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+  set.write(4, resources.hiZ, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            resources.hiZSampler);
+}
+
+void CullingPass::record(CommandBuffer &commandBuffer, DescriptorSet const &set,
+                         Resources const &resources,
+                         uint32_t instanceCount) const
+    noexcept(ExceptionsDisabled) {
+  // Only the counter itself is reset
+  commandBuffer.fillBuffer(resources.drawCount, 0, 0, sizeof(uint32_t));
+
+  if (commandBuffer.resourceTrackingEnabled()) {
+    commandBuffer.useBuffer(resources.view,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                            VK_ACCESS_UNIFORM_READ_BIT);
+    commandBuffer.useBuffer(resources.instances,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                            VK_ACCESS_SHADER_READ_BIT);
+    commandBuffer.useBuffer(resources.commands,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                            VK_ACCESS_SHADER_WRITE_BIT);
+    commandBuffer.useBuffer(resources.drawCount,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                            VK_ACCESS_SHADER_READ_BIT |
+                                VK_ACCESS_SHADER_WRITE_BIT);
+  } else {
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = resources.drawCount;
+    barrier.offset = 0;
+    barrier.size = sizeof(uint32_t);
+    commandBuffer.bufferMemoryBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                      {&barrier, 1});
+  }
+
+  commandBuffer.bindComputePipeline(m_pipeline);
+  commandBuffer.bindDescriptorSets(m_layout, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                   set, 0);
+  CullingConstants constants{};
+  constants.instanceCount = instanceCount;
+  constants.capacity = static_cast<uint32_t>(resources.commands.size());
+  commandBuffer.pushConstants(m_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                              constants);
+  commandBuffer.dispatch((instanceCount + WorkGroupSize - 1) / WorkGroupSize,
+                         1, 1);
+}
+
+} // namespace vkw
@@ -0,0 +1,154 @@
+#include "vkw/DeletionQueue.hpp"
+#include "vkw/Device.hpp"
+#include "vkw/Semaphore.hpp"
+
+#include <boost/container/small_vector.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <shared_mutex>
+
+namespace vkw {
+
+namespace {
+
+// VMA objects only know their allocator, this maps it back to the queue of
+// the device owning it.
+std::shared_mutex registryMutex;
+boost::container::small_vector<std::pair<VmaAllocator, DeletionQueue *>, 2>
+    registry;
+
+} // namespace
+
+DeletionQueue::DeletionQueue(Device const &device) noexcept(ExceptionsDisabled)
+    : m_device(device), m_allocator(device.getAllocator()) {
+  std::unique_lock lock{registryMutex};
+  registry.emplace_back(m_allocator, this);
+}
+
+DeletionQueue::~DeletionQueue() {
+  flush();
+
+  std::unique_lock lock{registryMutex};
+  registry.erase(std::remove_if(registry.begin(), registry.end(),
+                               [this](auto const &entry) {
+                                 return entry.second == this;
+                               }),
+                 registry.end());
+}
+
+DeletionQueue *DeletionQueue::find(VmaAllocator allocator) noexcept {
+  std::shared_lock lock{registryMutex};
+  auto found = std::find_if(
+      registry.begin(), registry.end(),
+      [allocator](auto const &entry) { return entry.first == allocator; });
+  return found != registry.end() ? found->second : nullptr;
+}
+
+void DeletionQueue::setCurrentKey(uint64_t key) noexcept {
+  std::lock_guard lock{m_mutex};
+  m_currentKey = key;
+}
+
+uint64_t DeletionQueue::currentKey() const noexcept {
+  std::lock_guard lock{m_mutex};
+  return m_currentKey;
+}
+
+bool DeletionQueue::retire(DestroyFn destroy, uint64_t handle,
+                           VmaAllocation allocation) noexcept {
+  return m_retire(Entry{0, destroy, handle, allocation});
+}
+
+bool DeletionQueue::retire(FreeFn free, uint64_t parent,
+                           uint64_t handle) noexcept {
+  return m_retire(Entry{0, nullptr, handle, VK_NULL_HANDLE, free, parent});
+}
+
+bool DeletionQueue::m_retire(Entry entry) noexcept {
+  if (m_observerCount.load(std::memory_order_acquire) != 0)
+    m_notifyObservers(entry.handle);
+
+  if (!deferralEnabled())
+    return false;
+
+  std::lock_guard lock{m_mutex};
+  entry.key = m_currentKey;
+  m_entries.emplace_back(entry);
+  return true;
+}
+
+uint64_t DeletionQueue::addObserver(DestroyObserver observer) noexcept(
+    ExceptionsDisabled) {
+  std::unique_lock lock{m_observerMutex};
+  auto id = m_nextObserverId++;
+  m_observers.emplace_back(id, std::move(observer));
+  m_observerCount.store(m_observers.size(), std::memory_order_release);
+  return id;
+}
+
+void DeletionQueue::removeObserver(uint64_t id) noexcept {
+  std::unique_lock lock{m_observerMutex};
+  m_observers.erase(std::remove_if(m_observers.begin(), m_observers.end(),
+                                   [id](auto const &entry) {
+                                     return entry.first == id;
+                                   }),
+                    m_observers.end());
+  m_observerCount.store(m_observers.size(), std::memory_order_release);
+}
+
+void DeletionQueue::m_notifyObservers(uint64_t handle) const noexcept {
+  std::shared_lock lock{m_observerMutex};
+  for (auto const &entry : m_observers)
+    entry.second(handle);
+}
+
+size_t DeletionQueue::collect(uint64_t completedKey) noexcept {
+  std::deque<Entry> completed;
+  {
+    std::lock_guard lock{m_mutex};
+    // Keys never decrease, so completed entries form a prefix
+    auto end = std::find_if(m_entries.begin(), m_entries.end(),
+                            [completedKey](Entry const &entry) {
+                              return entry.key > completedKey;
+                            });
+    std::move(m_entries.begin(), end, std::back_inserter(completed));
+    m_entries.erase(m_entries.begin(), end);
+  }
+
+  return m_destroy(completed);
+}
+
+size_t DeletionQueue::collect(TimelineSemaphore const &semaphore) noexcept(
+    ExceptionsDisabled) {
+  return collect(semaphore.value());
+}
+
+size_t DeletionQueue::flush() noexcept {
+  std::deque<Entry> all;
+  {
+    std::lock_guard lock{m_mutex};
+    std::swap(all, m_entries);
+  }
+
+  return m_destroy(all);
+}
+
+size_t DeletionQueue::pending() const noexcept {
+  std::lock_guard lock{m_mutex};
+  return m_entries.size();
+}
+
+size_t DeletionQueue::m_destroy(std::deque<Entry> const &entries) const
+    noexcept {
+  auto &device = m_device.get();
+  for (auto const &entry : entries) {
+    if (entry.free)
+      entry.free(device, entry.parent, entry.handle);
+    else
+      entry.destroy(device, entry.handle, entry.allocation);
+  }
+  return entries.size();
+}
+
+} // namespace vkw
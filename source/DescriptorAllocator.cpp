@@ -0,0 +1,121 @@
+#include "vkw/DescriptorAllocator.hpp"
+#include "Utils.hpp"
+#include "vkw/Device.hpp"
+
+namespace vkw {
+
+DescriptorAllocator::DescriptorAllocator(
+    Device const &device, uint32_t initialSets,
+    std::span<const VkDescriptorPoolSize> ratios,
+    uint32_t maxSetsPerPool) noexcept(ExceptionsDisabled)
+    : m_device(device), m_ratios(ratios.begin(), ratios.end()),
+      m_maxSetsPerPool(maxSetsPerPool) {
+  if (initialSets == 0 || initialSets > maxSetsPerPool)
+    postError(Error("DescriptorAllocator: initial set count must be in range "
+                    "[1, maxSetsPerPool]"));
+  m_createPool(initialSets);
+}
+
+void DescriptorAllocator::m_createPool(uint32_t maxSets) noexcept(
+    ExceptionsDisabled) {
+  boost::container::small_vector<VkDescriptorPoolSize, 6> poolSizes;
+  for (auto const &ratio : m_ratios)
+    poolSizes.push_back({ratio.type, ratio.descriptorCount * maxSets});
+  m_pools.emplace_back(m_device.get(), maxSets,
+                       std::span<const VkDescriptorPoolSize>{
+                           poolSizes.data(), poolSizes.size()});
+}
+
+bool DescriptorAllocator::m_nextPool(uint32_t minSets) noexcept(
+    ExceptionsDisabled) {
+  if (++m_currentPool < m_pools.size())
+    return false;
+
+  auto maxSets = std::max(
+      std::min(m_pools.back().maxSets() * 2, m_maxSetsPerPool), minSets);
+  m_createPool(maxSets);
+  return true;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(
+    DescriptorSetLayout const &layout) noexcept(ExceptionsDisabled) {
+  VkDescriptorSetLayout rawLayout = layout;
+  uint32_t variableCount = layout.variableDescriptorCount();
+  VkDescriptorSet set;
+  allocate({&rawLayout, 1}, {&set, 1},
+           variableCount != 0 ? std::span<const uint32_t>{&variableCount, 1}
+                              : std::span<const uint32_t>{});
+  return set;
+}
+
+void DescriptorAllocator::allocate(
+    std::span<const VkDescriptorSetLayout> layouts,
+    std::span<VkDescriptorSet> sets,
+    std::span<const uint32_t> variableCounts) noexcept(ExceptionsDisabled) {
+  if (sets.size() < layouts.size())
+    postError(Error("DescriptorAllocator: not enough room for allocated sets"));
+  if (!variableCounts.empty() && variableCounts.size() != layouts.size())
+    postError(Error("DescriptorAllocator: variable descriptor counts don't "
+                    "match layouts"));
+  if (layouts.empty())
+    return;
+
+  VkDescriptorSetAllocateInfo allocateInfo{};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocateInfo.pNext = nullptr;
+  allocateInfo.descriptorSetCount = layouts.size();
+  allocateInfo.pSetLayouts = layouts.data();
+
+  VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+  if (!variableCounts.empty()) {
+    variableCountInfo.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    variableCountInfo.pNext = nullptr;
+    variableCountInfo.descriptorSetCount = variableCounts.size();
+    variableCountInfo.pDescriptorCounts = variableCounts.data();
+    allocateInfo.pNext = &variableCountInfo;
+  }
+
+  auto &device = m_device.get();
+  bool poolCreated = false;
+  for (;;) {
+    allocateInfo.descriptorPool = m_pools[m_currentPool];
+    auto result = device.core<1, 0>().vkAllocateDescriptorSets(
+        device, &allocateInfo, sets.data());
+    if (result == VK_SUCCESS)
+      break;
+
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY &&
+        result != VK_ERROR_FRAGMENTED_POOL)
+      postError(VulkanError(result, __FILE__, __LINE__));
+
+    // Even an empty pool sized for the request can't hold it
+    if (poolCreated)
+      postError(Error("DescriptorAllocator: sets don't fit into an empty "
+                      "pool, pool ratios are too small for their layouts"));
+
+    poolCreated = m_nextPool(layouts.size());
+  }
+
+  m_allocatedSets += layouts.size();
+}
+
+void DescriptorAllocator::reset() noexcept(ExceptionsDisabled) {
+  // Frame has overflowed the first pool: replace the chain with one pool
+  // that fits it
+  auto fittingSets = std::min(m_allocatedSets, m_maxSetsPerPool);
+  if (m_currentPool != 0 && fittingSets > m_pools.front().maxSets()) {
+    m_pools.clear();
+    m_createPool(fittingSets);
+  } else {
+    auto &device = m_device.get();
+    for (size_t i = 0; i <= m_currentPool; ++i)
+      VK_CHECK_RESULT(
+          device.core<1, 0>().vkResetDescriptorPool(device, m_pools[i], 0))
+  }
+
+  m_currentPool = 0;
+  m_allocatedSets = 0;
+}
+
+} // namespace vkw
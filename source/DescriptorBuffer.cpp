@@ -0,0 +1,185 @@
+#include "vkw/DescriptorBuffer.hpp"
+#include "vkw/Device.hpp"
+
+namespace vkw {
+
+namespace {
+
+VkDeviceAddress bufferAddress(Device const &device,
+                              VkBuffer buffer) noexcept(ExceptionsDisabled) {
+  VkBufferDeviceAddressInfo addressInfo{};
+  addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+  addressInfo.pNext = nullptr;
+  addressInfo.buffer = buffer;
+  return device.bufferDeviceAddress().vkGetBufferDeviceAddress(device,
+                                                               &addressInfo);
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) noexcept {
+  return alignment == 0 ? value
+                        : (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+DescriptorBuffer::DescriptorBuffer(Device const &device, VkDeviceSize frameSize,
+                                   uint32_t framesInFlight,
+                                   VkBufferUsageFlags usage) noexcept(
+    ExceptionsDisabled)
+    : m_device(device),
+      m_buffer(device,
+               alignUp(frameSize, device.physicalDevice()
+                                      .descriptorBufferProperties()
+                                      .descriptorBufferOffsetAlignment) *
+                   framesInFlight,
+               usage | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+               VmaAllocationCreateInfo{
+                   .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+                   .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+                   .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT}),
+      m_alignment(device.physicalDevice()
+                      .descriptorBufferProperties()
+                      .descriptorBufferOffsetAlignment),
+      m_regionSize(alignUp(frameSize, m_alignment)),
+      m_framesInFlight(framesInFlight) {
+  if (!(usage & DefaultUsage))
+    postError(Error("DescriptorBuffer: usage has neither resource nor "
+                    "sampler descriptor buffer bit"));
+  if (framesInFlight == 0)
+    postError(Error("DescriptorBuffer: framesInFlight must not be zero"));
+
+  m_address = bufferAddress(device, m_buffer);
+}
+
+DescriptorBuffer::Set DescriptorBuffer::allocate(
+    DescriptorSetLayout const &layout) noexcept(ExceptionsDisabled) {
+  auto offset = alignUp(m_used, m_alignment);
+  auto size = layout.descriptorBufferSize();
+  if (offset + size > m_regionSize)
+    postError(Error("DescriptorBuffer: frame region of " +
+                    std::to_string(m_regionSize) + " bytes is exhausted"));
+
+  m_used = offset + size;
+  return Set{&layout, m_region * m_regionSize + offset};
+}
+
+void DescriptorBuffer::beginFrame() noexcept {
+  m_region = (m_region + 1) % m_framesInFlight;
+  m_used = 0;
+}
+
+VkDescriptorBufferBindingInfoEXT
+DescriptorBuffer::bindingInfo() const noexcept {
+  VkDescriptorBufferBindingInfoEXT bindingInfo{};
+  bindingInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+  bindingInfo.pNext = nullptr;
+  bindingInfo.address = m_address;
+  bindingInfo.usage = usage();
+  return bindingInfo;
+}
+
+void DescriptorBuffer::write(Set const &set, uint32_t binding,
+                             BufferBase const &buffer, VkDescriptorType type,
+                             VkDeviceSize offset,
+                             VkDeviceSize range) noexcept(ExceptionsDisabled) {
+  auto &device = m_device.get();
+  auto &properties = device.physicalDevice().descriptorBufferProperties();
+  // Descriptor sizes differ if the device checks bounds of buffer accesses
+  bool robust = device.physicalDevice().enabledFeatures().robustBufferAccess;
+
+  size_t size;
+  switch (type) {
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    size = robust ? properties.robustUniformBufferDescriptorSize
+                  : properties.uniformBufferDescriptorSize;
+    break;
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    size = robust ? properties.robustStorageBufferDescriptorSize
+                  : properties.storageBufferDescriptorSize;
+    break;
+  default:
+    postError(Error("DescriptorBuffer: descriptor type " +
+                    std::to_string(type) +
+                    " can't be written as a buffer descriptor"));
+  }
+
+  if (!(buffer.usage() & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT))
+    postError(Error("DescriptorBuffer: buffer was not created with shader "
+                    "device address usage"));
+
+  VkDescriptorAddressInfoEXT addressInfo{};
+  addressInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT;
+  addressInfo.pNext = nullptr;
+  addressInfo.address = bufferAddress(device, buffer) + offset;
+  // Descriptor buffers take no VK_WHOLE_SIZE
+  addressInfo.range =
+      range == VK_WHOLE_SIZE ? buffer.bufferSize() - offset : range;
+  addressInfo.format = VK_FORMAT_UNDEFINED;
+
+  VkDescriptorGetInfoEXT getInfo{};
+  getInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+  getInfo.pNext = nullptr;
+  getInfo.type = type;
+  if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+    getInfo.data.pUniformBuffer = &addressInfo;
+  else
+    getInfo.data.pStorageBuffer = &addressInfo;
+  m_put(set, binding, getInfo, size);
+}
+
+void DescriptorBuffer::write(Set const &set, uint32_t binding,
+                             ImageViewBase const &image, VkImageLayout layout,
+                             Sampler const &sampler) noexcept(
+    ExceptionsDisabled) {
+  VkDescriptorImageInfo imageInfo{sampler, image, layout};
+  VkDescriptorGetInfoEXT getInfo{};
+  getInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+  getInfo.pNext = nullptr;
+  getInfo.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  getInfo.data.pCombinedImageSampler = &imageInfo;
+  m_put(set, binding, getInfo,
+        m_device.get()
+            .physicalDevice()
+            .descriptorBufferProperties()
+            .combinedImageSamplerDescriptorSize);
+}
+
+void DescriptorBuffer::writeStorageImage(
+    Set const &set, uint32_t binding, ImageViewBase const &image,
+    VkImageLayout layout) noexcept(ExceptionsDisabled) {
+  VkDescriptorImageInfo imageInfo{VK_NULL_HANDLE, image, layout};
+  VkDescriptorGetInfoEXT getInfo{};
+  getInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+  getInfo.pNext = nullptr;
+  getInfo.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  getInfo.data.pStorageImage = &imageInfo;
+  m_put(set, binding, getInfo,
+        m_device.get()
+            .physicalDevice()
+            .descriptorBufferProperties()
+            .storageImageDescriptorSize);
+}
+
+void DescriptorBuffer::m_put(Set const &set, uint32_t binding,
+                             VkDescriptorGetInfoEXT const &info,
+                             size_t size) noexcept(ExceptionsDisabled) {
+  auto &layout = *set.layout;
+  auto found = std::find_if(layout.begin(), layout.end(),
+                            [binding](auto const &entry) {
+                              return entry.binding() == binding;
+                            });
+  if (found != layout.end() && found->type() != info.type)
+    postError(Error("DescriptorBuffer: binding " + std::to_string(binding) +
+                    " has descriptor type " + std::to_string(found->type()) +
+                    ", not " + std::to_string(info.type)));
+
+  auto offset = set.offset + layout.descriptorBufferOffset(binding);
+  auto &device = m_device.get();
+  device.descriptorBuffer().vkGetDescriptorEXT(
+      device, &info, size, m_buffer.mapped().data() + offset);
+
+  if (!m_buffer.coherent())
+    m_buffer.flush(offset, size);
+}
+
+} // namespace vkw
@@ -28,6 +28,17 @@ VkDescriptorSet DescriptorPool::allocateSet(
   VkDescriptorSetLayout v_layout = layout;
   allocateInfo.pSetLayouts = &v_layout;
 
+  VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+  uint32_t variableCount = layout.variableDescriptorCount();
+  if (variableCount != 0) {
+    variableCountInfo.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    variableCountInfo.pNext = nullptr;
+    variableCountInfo.descriptorSetCount = 1;
+    variableCountInfo.pDescriptorCounts = &variableCount;
+    allocateInfo.pNext = &variableCountInfo;
+  }
+
   VkDescriptorSet set;
   VK_CHECK_RESULT(parent().core<1, 0>().vkAllocateDescriptorSets(
       parent(), &allocateInfo, &set))
@@ -41,17 +52,29 @@ void DescriptorPool::freeSet(const DescriptorSet &set) noexcept {
   if (!(info().flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT))
     return;
   VkDescriptorSet vSet = set;
+  m_setCount--;
+
+  // Set may still be used by pending command buffers
+  if (parent().deletionQueue().retire(&m_free, DeletionQueue::toRaw(handle()),
+                                      DeletionQueue::toRaw(vSet)))
+    return;
 
-  // This function is meant to be called inside the DescriptorSet destructor.
-  // That means it is not allowed to pass any exceptions out.
-  // That's why irrecoverableError() is issued instead.
+  m_free(parent(), DeletionQueue::toRaw(handle()), DeletionQueue::toRaw(vSet));
+}
+
+void DescriptorPool::m_free(Device const &device, uint64_t pool,
+                            uint64_t set) noexcept {
+  auto vSet = DeletionQueue::fromRaw<VkDescriptorSet>(set);
+
+  // This function is meant to be called inside the DescriptorSet destructor
+  // or by the deletion queue. That means it is not allowed to pass any
+  // exceptions out. That's why irrecoverableError() is issued instead.
   try {
-    VK_CHECK_RESULT(parent().core<1, 0>().vkFreeDescriptorSets(
-        parent(), handle(), 1, &vSet))
+    VK_CHECK_RESULT(device.core<1, 0>().vkFreeDescriptorSets(
+        device, DeletionQueue::fromRaw<VkDescriptorPool>(pool), 1, &vSet))
   } catch (VulkanError &e) {
     irrecoverableError(std::move(e));
   }
-  m_setCount--;
 }
 
 } // namespace vkw
\ No newline at end of file
@@ -9,12 +9,14 @@ namespace vkw {
 
 DescriptorSetLayoutBinding::DescriptorSetLayoutBinding(
     uint32_t binding, VkDescriptorType type, VkShaderStageFlags shaderStages,
-    uint32_t descriptorCount, VkSampler *pImmutableSamplers) noexcept
+    uint32_t descriptorCount, VkSampler *pImmutableSamplers,
+    VkDescriptorBindingFlags flags) noexcept
     : m_binding{.binding = binding,
                 .descriptorType = type,
                 .descriptorCount = descriptorCount,
                 .stageFlags = shaderStages,
-                .pImmutableSamplers = pImmutableSamplers} {}
+                .pImmutableSamplers = pImmutableSamplers},
+      m_flags(flags) {}
 bool DescriptorSetLayoutBinding::hasDynamicOffset() const noexcept {
   return m_binding.descriptorType ==
              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
@@ -22,9 +24,10 @@ bool DescriptorSetLayoutBinding::hasDynamicOffset() const noexcept {
 }
 
 void DescriptorSetLayoutInfo::m_fillInfo(
+    std::span<DescriptorSetLayoutBinding> bindings,
     VkDescriptorSetLayoutCreateFlags flags) noexcept(ExceptionsDisabled) {
   // sort bindings by binding index (this will be useful)
-  std::sort(m_bindings.begin(), m_bindings.end(),
+  std::sort(bindings.begin(), bindings.end(),
             [](DescriptorSetLayoutBinding const &lhs,
                DescriptorSetLayoutBinding const &rhs) {
               return lhs.binding() > rhs.binding();
@@ -33,9 +36,9 @@ void DescriptorSetLayoutInfo::m_fillInfo(
   // validate bindings
 
   // 1. check for binding duplicates
-  if (m_bindings.size() > 1) {
-    auto predIt = m_bindings.begin();
-    if (std::any_of(m_bindings.begin() + 1, m_bindings.end(),
+  if (bindings.size() > 1) {
+    auto predIt = bindings.begin();
+    if (std::any_of(bindings.begin() + 1, bindings.end(),
                     [&predIt](DescriptorSetLayoutBinding const &elem) {
                       return elem.binding() == (predIt++)->binding();
                     })) {
@@ -45,7 +48,7 @@ void DescriptorSetLayoutInfo::m_fillInfo(
     }
   }
 
-  std::transform(m_bindings.begin(), m_bindings.end(),
+  std::transform(bindings.begin(), bindings.end(),
                  std::back_inserter(m_rawBindings),
                  [](DescriptorSetLayoutBinding const &entry) { return entry; });
 
@@ -54,6 +57,122 @@ void DescriptorSetLayoutInfo::m_fillInfo(
   m_createInfo.flags = flags;
   m_createInfo.bindingCount = m_rawBindings.size();
   m_createInfo.pBindings = m_rawBindings.data();
+
+  // Binding flags are only chained when used: the structure requires
+  // descriptor indexing support
+  if (std::none_of(bindings.begin(), bindings.end(),
+                   [](DescriptorSetLayoutBinding const &entry) {
+                     return entry.flags() != 0;
+                   }))
+    return;
+
+  std::transform(
+      bindings.begin(), bindings.end(),
+      std::back_inserter(m_rawBindingFlags),
+      [](DescriptorSetLayoutBinding const &entry) { return entry.flags(); });
+
+  m_bindingFlagsInfo.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  m_bindingFlagsInfo.pNext = nullptr;
+  m_bindingFlagsInfo.bindingCount = m_rawBindingFlags.size();
+  m_bindingFlagsInfo.pBindingFlags = m_rawBindingFlags.data();
+  m_createInfo.pNext = &m_bindingFlagsInfo;
+}
+
+void DescriptorSetLayoutInfo::m_fillInfo(
+    std::span<const VkDescriptorSetLayoutBinding> bindings,
+    std::span<const VkDescriptorBindingFlags> bindingFlags,
+    VkDescriptorSetLayoutCreateFlags flags) noexcept {
+  // Already sorted and validated: nothing to copy
+  m_staticBindings = bindings;
+  m_staticBindingFlags = bindingFlags;
+
+  m_createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  m_createInfo.pNext = nullptr;
+  m_createInfo.flags = flags;
+  m_createInfo.bindingCount = bindings.size();
+  m_createInfo.pBindings = bindings.data();
+
+  if (bindingFlags.empty())
+    return;
+
+  m_bindingFlagsInfo.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  m_bindingFlagsInfo.pNext = nullptr;
+  m_bindingFlagsInfo.bindingCount = bindingFlags.size();
+  m_bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+  m_createInfo.pNext = &m_bindingFlagsInfo;
+}
+
+bool DescriptorSetLayoutInfo::operator==(
+    DescriptorSetLayoutInfo const &rhs) const noexcept {
+  auto bindings = m_bindings();
+  auto rhsBindings = rhs.m_bindings();
+  if (bindings.size() != rhsBindings.size() ||
+      m_createInfo.flags != rhs.m_createInfo.flags)
+    return false;
+
+  auto bindingFlags = m_bindingFlags();
+  auto rhsBindingFlags = rhs.m_bindingFlags();
+  for (size_t i = 0; i < bindings.size(); ++i) {
+    auto &lhs = bindings[i];
+    auto &other = rhsBindings[i];
+    if (lhs.binding != other.binding ||
+        lhs.descriptorType != other.descriptorType ||
+        lhs.descriptorCount != other.descriptorCount ||
+        lhs.stageFlags != other.stageFlags ||
+        (bindingFlags.empty() ? 0 : bindingFlags[i]) !=
+            (rhsBindingFlags.empty() ? 0 : rhsBindingFlags[i]))
+      return false;
+  }
+  return true;
+}
+
+uint32_t DescriptorSetLayoutInfo::variableDescriptorCount() const noexcept {
+  // Bindings are sorted in descending order, so variable sized binding which
+  // must be the last one comes first
+  auto bindingFlags = m_bindingFlags();
+  if (!bindingFlags.empty() &&
+      bindingFlags.front() &
+          VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT)
+    return m_bindings().front().descriptorCount;
+  return 0;
+}
+
+namespace {
+
+void checkDescriptorBufferLayout(DescriptorSetLayout const &layout) noexcept(
+    ExceptionsDisabled) {
+  if (!(layout.flags() &
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT))
+    postError(Error("DescriptorSetLayout: layout was not created for "
+                    "descriptor buffers"));
+}
+
+} // namespace
+
+VkDeviceSize DescriptorSetLayout::descriptorBufferSize() const
+    noexcept(ExceptionsDisabled) {
+  checkDescriptorBufferLayout(*this);
+  VkDeviceSize size = 0;
+  parent().descriptorBuffer().vkGetDescriptorSetLayoutSizeEXT(parent(),
+                                                              handle(), &size);
+  return size;
+}
+
+VkDeviceSize DescriptorSetLayout::descriptorBufferOffset(uint32_t binding) const
+    noexcept(ExceptionsDisabled) {
+  checkDescriptorBufferLayout(*this);
+  if (std::none_of(begin(), end(), [binding](auto const &entry) {
+        return entry.binding() == binding;
+      }))
+    postError(Error("DescriptorSetLayout: layout has no binding " +
+                    std::to_string(binding)));
+
+  VkDeviceSize offset = 0;
+  parent().descriptorBuffer().vkGetDescriptorSetLayoutBindingOffsetEXT(
+      parent(), handle(), binding, &offset);
+  return offset;
 }
 
 DescriptorSet::DescriptorSet(
@@ -173,4 +292,56 @@ void DescriptorSet::write(uint32_t binding, BufferBase const &buffer,
   m_write(1, &writeSet);
 }
 
+void PushDescriptorSet::write(uint32_t binding, BufferBase const &buffer,
+                              VkDescriptorType type, VkDeviceSize offset,
+                              VkDeviceSize range) noexcept(ExceptionsDisabled) {
+  auto &entry = m_entries.emplace_back();
+  entry.binding = binding;
+  entry.type = type;
+  entry.bufferInfo.buffer = buffer;
+  entry.bufferInfo.offset = offset;
+  entry.bufferInfo.range = range;
+}
+
+void PushDescriptorSet::write(uint32_t binding, ImageViewBase const &image,
+                              VkImageLayout layout,
+                              Sampler const &sampler) noexcept(
+    ExceptionsDisabled) {
+  auto &entry = m_entries.emplace_back();
+  entry.binding = binding;
+  entry.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  entry.imageInfo = {sampler, image, layout};
+}
+
+void PushDescriptorSet::writeStorageImage(
+    uint32_t binding, ImageViewBase const &image,
+    VkImageLayout layout) noexcept(ExceptionsDisabled) {
+  auto &entry = m_entries.emplace_back();
+  entry.binding = binding;
+  entry.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  entry.imageInfo = {VK_NULL_HANDLE, image, layout};
+}
+
+boost::container::small_vector<VkWriteDescriptorSet, 4>
+PushDescriptorSet::m_writes() const noexcept(ExceptionsDisabled) {
+  boost::container::small_vector<VkWriteDescriptorSet, 4> writes;
+  for (auto const &entry : m_entries) {
+    VkWriteDescriptorSet writeSet{};
+    writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeSet.pNext = nullptr;
+    writeSet.descriptorCount = 1;
+    writeSet.dstSet = VK_NULL_HANDLE;
+    writeSet.dstArrayElement = 0;
+    writeSet.dstBinding = entry.binding;
+    writeSet.descriptorType = entry.type;
+    if (entry.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+        entry.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+      writeSet.pImageInfo = &entry.imageInfo;
+    else
+      writeSet.pBufferInfo = &entry.bufferInfo;
+    writes.push_back(writeSet);
+  }
+  return writes;
+}
+
 } // namespace vkw
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "vkw/DescriptorSetCache.hpp"
+#include "vkw/Device.hpp"
+
+#include <boost/container_hash/hash.hpp>
+
+#include <algorithm>
+
+namespace vkw {
+
+namespace {
+
+bool isImageEntry(VkDescriptorType type) noexcept {
+  return type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+         type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+}
+
+} // namespace
+
+DescriptorSetCache::Contents::Entry &
+DescriptorSetCache::Contents::m_entry(uint32_t binding) noexcept(
+    ExceptionsDisabled) {
+  auto found = std::lower_bound(
+      m_entries.begin(), m_entries.end(), binding,
+      [](Entry const &entry, uint32_t binding) {
+        return entry.binding < binding;
+      });
+  if (found == m_entries.end() || found->binding != binding)
+    found = m_entries.insert(found, Entry{});
+
+  *found = Entry{};
+  found->binding = binding;
+  return *found;
+}
+
+void DescriptorSetCache::Contents::write(
+    uint32_t binding, BufferBase const &buffer, VkDescriptorType type,
+    VkDeviceSize offset, VkDeviceSize range) noexcept(ExceptionsDisabled) {
+  auto &entry = m_entry(binding);
+  entry.type = type;
+  entry.bufferInfo = {buffer, offset, range};
+}
+
+void DescriptorSetCache::Contents::write(
+    uint32_t binding, ImageViewBase const &image, VkImageLayout layout,
+    Sampler const &sampler) noexcept(ExceptionsDisabled) {
+  auto &entry = m_entry(binding);
+  entry.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  entry.imageInfo = {sampler, image, layout};
+}
+
+void DescriptorSetCache::Contents::writeStorageImage(
+    uint32_t binding, ImageViewBase const &image,
+    VkImageLayout layout) noexcept(ExceptionsDisabled) {
+  auto &entry = m_entry(binding);
+  entry.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  entry.imageInfo = {VK_NULL_HANDLE, image, layout};
+}
+
+size_t DescriptorSetCache::Contents::hash() const noexcept {
+  size_t seed = m_entries.size();
+  for (auto const &entry : m_entries) {
+    boost::hash_combine(seed, entry.binding);
+    boost::hash_combine(seed, entry.type);
+    if (isImageEntry(entry.type)) {
+      boost::hash_combine(seed, DeletionQueue::toRaw(entry.imageInfo.sampler));
+      boost::hash_combine(seed,
+                          DeletionQueue::toRaw(entry.imageInfo.imageView));
+      boost::hash_combine(seed, entry.imageInfo.imageLayout);
+    } else {
+      boost::hash_combine(seed, DeletionQueue::toRaw(entry.bufferInfo.buffer));
+      boost::hash_combine(seed, entry.bufferInfo.offset);
+      boost::hash_combine(seed, entry.bufferInfo.range);
+    }
+  }
+  return seed;
+}
+
+bool DescriptorSetCache::Contents::operator==(
+    Contents const &rhs) const noexcept {
+  return std::equal(
+      m_entries.begin(), m_entries.end(), rhs.m_entries.begin(),
+      rhs.m_entries.end(), [](Entry const &lhs, Entry const &rhs) {
+        if (lhs.binding != rhs.binding || lhs.type != rhs.type)
+          return false;
+        if (isImageEntry(lhs.type))
+          return lhs.imageInfo.sampler == rhs.imageInfo.sampler &&
+                 lhs.imageInfo.imageView == rhs.imageInfo.imageView &&
+                 lhs.imageInfo.imageLayout == rhs.imageInfo.imageLayout;
+        return lhs.bufferInfo.buffer == rhs.bufferInfo.buffer &&
+               lhs.bufferInfo.offset == rhs.bufferInfo.offset &&
+               lhs.bufferInfo.range == rhs.bufferInfo.range;
+      });
+}
+
+bool DescriptorSetCache::Contents::m_referencesAny(
+    std::span<const uint64_t> handles) const noexcept {
+  auto contains = [handles](auto handle) {
+    return std::binary_search(handles.begin(), handles.end(),
+                              DeletionQueue::toRaw(handle));
+  };
+  return std::any_of(
+      m_entries.begin(), m_entries.end(), [&contains](Entry const &entry) {
+        if (isImageEntry(entry.type))
+          return contains(entry.imageInfo.sampler) ||
+                 contains(entry.imageInfo.imageView);
+        return contains(entry.bufferInfo.buffer);
+      });
+}
+
+DescriptorSetCache::DescriptorSetCache(
+    Device const &device, uint32_t framesInFlight, uint32_t maxUnusedFrames,
+    std::span<const VkDescriptorPoolSize> ratios) noexcept(ExceptionsDisabled)
+    : m_device(device), m_allocators{DescriptorAllocator{device, 64, ratios},
+                                     DescriptorAllocator{device, 64, ratios}},
+      m_writer(device),
+      m_framesInFlight(framesInFlight),
+      m_maxUnusedFrames(std::max(maxUnusedFrames, framesInFlight)) {
+  m_observerId = device.deletionQueue().addObserver([this](uint64_t handle) {
+    std::lock_guard lock{m_destroyedMutex};
+    m_destroyed.push_back(handle);
+    m_hasDestroyed.store(true, std::memory_order_release);
+  });
+}
+
+DescriptorSetCache::~DescriptorSetCache() {
+  m_device.get().deletionQueue().removeObserver(m_observerId);
+}
+
+VkDescriptorSet DescriptorSetCache::get(
+    DescriptorSetLayout const &layout,
+    Contents const &contents) noexcept(ExceptionsDisabled) {
+  if (m_hasDestroyed.load(std::memory_order_acquire))
+    m_processDestroyed();
+
+  VkDescriptorSetLayout rawLayout = layout;
+  auto hash = contents.hash();
+  boost::hash_combine(hash, DeletionQueue::toRaw(rawLayout));
+
+  auto [first, last] = m_index.equal_range(hash);
+  for (auto found = first; found != last; ++found) {
+    auto node = found->second;
+    if (node->layout != rawLayout || !(node->contents == contents))
+      continue;
+
+    node->lastUsedFrame = m_frame;
+    m_nodes.splice(m_nodes.begin(), m_nodes, node);
+    ++m_statistics.hits;
+    return node->set;
+  }
+
+  ++m_statistics.misses;
+  auto set = m_acquireSet(layout);
+  for (auto const &entry : contents.m_entries) {
+    if (isImageEntry(entry.type))
+      m_writer.write(set, entry.binding, entry.type, entry.imageInfo);
+    else
+      m_writer.write(set, entry.binding, entry.type, entry.bufferInfo);
+  }
+  m_writer.commit();
+
+  m_nodes.push_front(Node{rawLayout, contents, hash, set, m_frame});
+  m_index.emplace(hash, m_nodes.begin());
+  return set;
+}
+
+void DescriptorSetCache::beginFrame() noexcept(ExceptionsDisabled) {
+  if (m_hasDestroyed.load(std::memory_order_acquire))
+    m_processDestroyed();
+
+  ++m_frame;
+
+  // Least recently used entries are at the back
+  while (!m_nodes.empty() &&
+         m_nodes.back().lastUsedFrame + m_maxUnusedFrames <= m_frame) {
+    auto &node = m_nodes.back();
+    m_freeSets[node.layout].push_back(node.set);
+    m_erase(std::prev(m_nodes.end()));
+    ++m_statistics.evictions;
+  }
+
+  auto completed = std::partition(
+      m_retired.begin(), m_retired.end(), [this](Retired const &retired) {
+        return retired.lastUsedFrame + m_framesInFlight > m_frame;
+      });
+  for (auto it = completed; it != m_retired.end(); ++it)
+    m_freeSets[it->layout].push_back(it->set);
+  m_retired.erase(completed, m_retired.end());
+
+  if (m_drainFrame && *m_drainFrame + m_framesInFlight <= m_frame) {
+    m_allocators[(m_generation + 1) % 2].reset();
+    m_drainFrame.reset();
+  }
+
+  // Previous allocator must be reset before the current one is abandoned
+  if (!m_drainFrame && m_orphanedSets >= 64 &&
+      m_orphanedSets * 2 >= m_allocator().allocatedSets())
+    m_recycle();
+}
+
+void DescriptorSetCache::m_recycle() noexcept {
+  // Sets used up to the previous frame stay valid until the allocator reset
+  m_drainFrame = m_frame - 1;
+  m_statistics.evictions += m_nodes.size();
+  m_nodes.clear();
+  m_index.clear();
+  m_retired.clear();
+  m_freeSets.clear();
+  m_orphanedSets = 0;
+  ++m_generation;
+  ++m_statistics.recycles;
+}
+
+void DescriptorSetCache::m_processDestroyed() noexcept(ExceptionsDisabled) {
+  std::vector<uint64_t> destroyed;
+  {
+    std::lock_guard lock{m_destroyedMutex};
+    std::swap(destroyed, m_destroyed);
+    m_hasDestroyed.store(false, std::memory_order_release);
+  }
+  std::sort(destroyed.begin(), destroyed.end());
+
+  auto isDestroyed = [&destroyed](uint64_t handle) {
+    return std::binary_search(destroyed.begin(), destroyed.end(), handle);
+  };
+
+  for (auto node = m_nodes.begin(); node != m_nodes.end();) {
+    auto current = node++;
+    if (!isDestroyed(DeletionQueue::toRaw(current->layout)) &&
+        !current->contents.m_referencesAny(destroyed))
+      continue;
+
+    // Set may still be in use by frames in flight
+    m_retired.push_back({current->layout, current->set,
+                         current->lastUsedFrame});
+    m_erase(current);
+    ++m_statistics.invalidations;
+  }
+
+  // Sets of a destroyed layout can't be recycled, only reclaimed by
+  // resetting their allocator
+  for (auto handle : destroyed) {
+    auto found =
+        m_freeSets.find(DeletionQueue::fromRaw<VkDescriptorSetLayout>(handle));
+    if (found == m_freeSets.end())
+      continue;
+    m_orphanedSets += found->second.size();
+    m_freeSets.erase(found);
+  }
+  m_orphanedSets +=
+      std::erase_if(m_retired, [&isDestroyed](Retired const &retired) {
+        return isDestroyed(DeletionQueue::toRaw(retired.layout));
+      });
+}
+
+void DescriptorSetCache::m_erase(NodeList::iterator node) noexcept(
+    ExceptionsDisabled) {
+  auto [first, last] = m_index.equal_range(node->hash);
+  for (auto found = first; found != last; ++found)
+    if (found->second == node) {
+      m_index.erase(found);
+      break;
+    }
+  m_nodes.erase(node);
+}
+
+VkDescriptorSet DescriptorSetCache::m_acquireSet(
+    DescriptorSetLayout const &layout) noexcept(ExceptionsDisabled) {
+  auto found = m_freeSets.find(layout);
+  if (found == m_freeSets.end() || found->second.empty())
+    return m_allocator().allocate(layout);
+
+  auto set = found->second.back();
+  found->second.pop_back();
+  return set;
+}
+
+} // namespace vkw
@@ -0,0 +1,165 @@
+#include "vkw/DescriptorUpdateTemplate.hpp"
+#include "Utils.hpp"
+#include "vkw/Device.hpp"
+#include "vkw/Pipeline.hpp"
+
+#include <algorithm>
+
+namespace vkw {
+
+namespace {
+
+// Zero for descriptor types without info structure, e.g. inline uniform blocks
+size_t descriptorInfoSize(VkDescriptorType type) noexcept {
+  switch (type) {
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+    return sizeof(VkDescriptorBufferInfo);
+  case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+  case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+    return sizeof(VkBufferView);
+  case VK_DESCRIPTOR_TYPE_SAMPLER:
+  case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+  case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+  case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+  case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+    return sizeof(VkDescriptorImageInfo);
+  default:
+    return 0;
+  }
+}
+
+// Packed structure entries in ascending binding order
+boost::container::small_vector<VkDescriptorUpdateTemplateEntry, 4>
+layoutEntries(DescriptorSetLayout const &layout) noexcept(ExceptionsDisabled) {
+  boost::container::small_vector<VkDescriptorUpdateTemplateEntry, 4> entries;
+  for (auto const &binding : layout)
+    entries.push_back({.dstBinding = binding.binding(),
+                       .dstArrayElement = 0,
+                       .descriptorCount = binding.descriptorCount(),
+                       .descriptorType = binding.type()});
+  std::sort(entries.begin(), entries.end(),
+            [](auto const &lhs, auto const &rhs) {
+              return lhs.dstBinding < rhs.dstBinding;
+            });
+
+  size_t offset = 0;
+  for (auto &entry : entries) {
+    entry.stride = descriptorInfoSize(entry.descriptorType);
+    if (entry.stride == 0)
+      postError(Error("DescriptorUpdateTemplate: entry for descriptor type " +
+                      std::to_string(entry.descriptorType) +
+                      " can't be derived from layout and must be given"));
+    entry.offset = offset;
+    offset += entry.stride * entry.descriptorCount;
+  }
+  return entries;
+}
+
+} // namespace
+
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(
+    Device const &device, DescriptorSetLayout const &layout,
+    std::span<const VkDescriptorUpdateTemplateEntry> entries) noexcept(
+    ExceptionsDisabled)
+    : m_device(device), m_layout(layout) {
+  m_create(entries, VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET);
+}
+
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(
+    Device const &device, DescriptorSetLayout const &setLayout,
+    PipelineLayout const &pipelineLayout, VkPipelineBindPoint bindPoint,
+    uint32_t set,
+    std::span<const VkDescriptorUpdateTemplateEntry> entries) noexcept(
+    ExceptionsDisabled)
+    : m_device(device), m_layout(setLayout), m_bindPoint(bindPoint),
+      m_pipelineLayout(pipelineLayout), m_set(set) {
+  m_create(entries, VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR);
+}
+
+void DescriptorUpdateTemplate::m_create(
+    std::span<const VkDescriptorUpdateTemplateEntry> entries,
+    VkDescriptorUpdateTemplateType type) noexcept(ExceptionsDisabled) {
+  auto derived = entries.empty()
+                     ? layoutEntries(m_layout)
+                     : boost::container::small_vector<
+                           VkDescriptorUpdateTemplateEntry, 4>(entries.begin(),
+                                                               entries.end());
+
+  for (auto const &entry : derived) {
+    if (entry.descriptorCount == 0)
+      continue;
+    auto infoSize = descriptorInfoSize(entry.descriptorType);
+    // Inline uniform block count is its size in bytes
+    auto end = infoSize == 0 ? entry.offset + entry.descriptorCount
+                             : entry.offset +
+                                   entry.stride * (entry.descriptorCount - 1) +
+                                   infoSize;
+    m_dataSize = std::max(m_dataSize, end);
+  }
+
+  VkDescriptorUpdateTemplateCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+  createInfo.pNext = nullptr;
+  createInfo.flags = 0;
+  createInfo.descriptorUpdateEntryCount = derived.size();
+  createInfo.pDescriptorUpdateEntries = derived.data();
+  createInfo.templateType = type;
+  createInfo.descriptorSetLayout = m_layout.get();
+  createInfo.pipelineBindPoint = m_bindPoint;
+  createInfo.pipelineLayout = m_pipelineLayout;
+  createInfo.set = m_set;
+
+  auto &device = m_device.get();
+  VK_CHECK_RESULT(
+      device.descriptorUpdateTemplate().vkCreateDescriptorUpdateTemplate(
+          device, &createInfo, device.hostAllocator().allocator(),
+          &m_template))
+}
+
+DescriptorUpdateTemplate::~DescriptorUpdateTemplate() {
+  if (m_template == VK_NULL_HANDLE)
+    return;
+
+  // Pending command buffers may still push descriptors with the template
+  auto &device = m_device.get();
+  if (device.deletionQueue().retire(
+          [](Device const &device, uint64_t updateTemplate,
+             VmaAllocation) noexcept {
+            device.descriptorUpdateTemplate()
+                .vkDestroyDescriptorUpdateTemplate(
+                    device,
+                    DeletionQueue::fromRaw<VkDescriptorUpdateTemplate>(
+                        updateTemplate),
+                    device.hostAllocator().allocator());
+          },
+          DeletionQueue::toRaw(m_template)))
+    return;
+
+  device.descriptorUpdateTemplate().vkDestroyDescriptorUpdateTemplate(
+      device, m_template, device.hostAllocator().allocator());
+}
+
+void DescriptorUpdateTemplate::update(DescriptorSet const &set,
+                                      void const *data) const
+    noexcept(ExceptionsDisabled) {
+  if (pushDescriptors())
+    postError(Error("DescriptorUpdateTemplate: push descriptor template can't "
+                    "update descriptor sets"));
+
+  auto &device = m_device.get();
+  device.descriptorUpdateTemplate().vkUpdateDescriptorSetWithTemplate(
+      device, set, m_template, data);
+}
+
+void DescriptorUpdateTemplate::m_checkDataSize(size_t size) const
+    noexcept(ExceptionsDisabled) {
+  if (size < m_dataSize)
+    postError(Error("DescriptorUpdateTemplate: data structure of " +
+                    std::to_string(size) + " bytes is smaller than " +
+                    std::to_string(m_dataSize) + " bytes read by template"));
+}
+
+} // namespace vkw
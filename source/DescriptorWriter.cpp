@@ -0,0 +1,144 @@
+#include "vkw/DescriptorWriter.hpp"
+#include "vkw/Device.hpp"
+
+namespace vkw {
+
+namespace {
+
+bool isImageDescriptor(VkDescriptorType type) noexcept {
+  switch (type) {
+  case VK_DESCRIPTOR_TYPE_SAMPLER:
+  case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+  case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+  case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+  case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool isBufferDescriptor(VkDescriptorType type) noexcept {
+  switch (type) {
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+DescriptorWriter::DescriptorWriter(Device const &device) noexcept
+    : m_device(device) {}
+
+VkWriteDescriptorSet &
+DescriptorWriter::m_addWrite(VkDescriptorSet set, uint32_t binding,
+                             VkDescriptorType type) noexcept(
+    ExceptionsDisabled) {
+  auto &writeSet = m_writes.emplace_back();
+  writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  writeSet.pNext = nullptr;
+  writeSet.dstSet = set;
+  writeSet.dstBinding = binding;
+  writeSet.dstArrayElement = 0;
+  writeSet.descriptorCount = 1;
+  writeSet.descriptorType = type;
+  return writeSet;
+}
+
+void DescriptorWriter::write(VkDescriptorSet set, uint32_t binding,
+                             BufferBase const &buffer, VkDescriptorType type,
+                             VkDeviceSize offset,
+                             VkDeviceSize range) noexcept(ExceptionsDisabled) {
+  write(set, binding, type, VkDescriptorBufferInfo{buffer, offset, range});
+}
+
+void DescriptorWriter::write(VkDescriptorSet set, uint32_t binding,
+                             ImageViewBase const &image, VkImageLayout layout,
+                             Sampler const &sampler) noexcept(
+    ExceptionsDisabled) {
+  write(set, binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VkDescriptorImageInfo{sampler, image, layout});
+}
+
+void DescriptorWriter::writeStorageImage(
+    VkDescriptorSet set, uint32_t binding, ImageViewBase const &image,
+    VkImageLayout layout) noexcept(ExceptionsDisabled) {
+  write(set, binding, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        VkDescriptorImageInfo{VK_NULL_HANDLE, image, layout});
+}
+
+void DescriptorWriter::write(
+    VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+    VkDescriptorBufferInfo const &bufferInfo) noexcept(ExceptionsDisabled) {
+  if (!isBufferDescriptor(type))
+    postError(Error("DescriptorWriter: descriptor type " +
+                    std::to_string(type) + " is not a buffer descriptor"));
+
+  m_addWrite(set, binding, type);
+  m_bufferInfos.push_back(bufferInfo);
+}
+
+void DescriptorWriter::write(
+    VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+    VkDescriptorImageInfo const &imageInfo) noexcept(ExceptionsDisabled) {
+  if (!isImageDescriptor(type))
+    postError(Error("DescriptorWriter: descriptor type " +
+                    std::to_string(type) + " is not an image descriptor"));
+
+  m_addWrite(set, binding, type);
+  m_imageInfos.push_back(imageInfo);
+}
+
+void DescriptorWriter::copy(VkDescriptorSet src, uint32_t srcBinding,
+                            VkDescriptorSet dst, uint32_t dstBinding,
+                            uint32_t descriptorCount) noexcept(
+    ExceptionsDisabled) {
+  auto &copySet = m_copies.emplace_back();
+  copySet.sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+  copySet.pNext = nullptr;
+  copySet.srcSet = src;
+  copySet.srcBinding = srcBinding;
+  copySet.srcArrayElement = 0;
+  copySet.dstSet = dst;
+  copySet.dstBinding = dstBinding;
+  copySet.dstArrayElement = 0;
+  copySet.descriptorCount = descriptorCount;
+}
+
+void DescriptorWriter::commit() noexcept {
+  if (empty())
+    return;
+
+  // Every write consumes descriptorCount infos of its kind in recording order
+  auto *bufferInfo = m_bufferInfos.data();
+  auto *imageInfo = m_imageInfos.data();
+  for (auto &writeSet : m_writes) {
+    if (isImageDescriptor(writeSet.descriptorType)) {
+      writeSet.pImageInfo = imageInfo;
+      imageInfo += writeSet.descriptorCount;
+    } else {
+      writeSet.pBufferInfo = bufferInfo;
+      bufferInfo += writeSet.descriptorCount;
+    }
+  }
+
+  auto &device = m_device.get();
+  device.core<1, 0>().vkUpdateDescriptorSets(device, m_writes.size(),
+                                             m_writes.data(), m_copies.size(),
+                                             m_copies.data());
+  clear();
+}
+
+void DescriptorWriter::clear() noexcept {
+  m_writes.clear();
+  m_copies.clear();
+  m_bufferInfos.clear();
+  m_imageInfos.clear();
+}
+
+} // namespace vkw
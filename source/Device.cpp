@@ -1,8 +1,11 @@
 #include "vkw/Device.hpp"
 #include "Utils.hpp"
 #include "vkw/Buffer.hpp"
+#include "vkw/CompletionWatcher.hpp"
+#include "vkw/Extensions.hpp"
 #include "vkw/Instance.hpp"
 #include "vkw/Queue.hpp"
+#include "vkw/StateCache.hpp"
 #include "vkw/SymbolTable.hpp"
 #include <cassert>
 #include <iostream>
@@ -36,6 +39,33 @@ loadDeviceSymbols(vkw::Instance const &instance, VkDevice device,
   }
 }
 
+void foldDescriptorIndexingFeatures(
+    VkPhysicalDeviceVulkan12Features &features,
+    VkPhysicalDeviceDescriptorIndexingFeatures const &indexing) noexcept {
+#define VKW_FOLD_FEATURE(X) features.X = indexing.X;
+  VKW_FOLD_FEATURE(shaderInputAttachmentArrayDynamicIndexing)
+  VKW_FOLD_FEATURE(shaderUniformTexelBufferArrayDynamicIndexing)
+  VKW_FOLD_FEATURE(shaderStorageTexelBufferArrayDynamicIndexing)
+  VKW_FOLD_FEATURE(shaderUniformBufferArrayNonUniformIndexing)
+  VKW_FOLD_FEATURE(shaderSampledImageArrayNonUniformIndexing)
+  VKW_FOLD_FEATURE(shaderStorageBufferArrayNonUniformIndexing)
+  VKW_FOLD_FEATURE(shaderStorageImageArrayNonUniformIndexing)
+  VKW_FOLD_FEATURE(shaderInputAttachmentArrayNonUniformIndexing)
+  VKW_FOLD_FEATURE(shaderUniformTexelBufferArrayNonUniformIndexing)
+  VKW_FOLD_FEATURE(shaderStorageTexelBufferArrayNonUniformIndexing)
+  VKW_FOLD_FEATURE(descriptorBindingUniformBufferUpdateAfterBind)
+  VKW_FOLD_FEATURE(descriptorBindingSampledImageUpdateAfterBind)
+  VKW_FOLD_FEATURE(descriptorBindingStorageImageUpdateAfterBind)
+  VKW_FOLD_FEATURE(descriptorBindingStorageBufferUpdateAfterBind)
+  VKW_FOLD_FEATURE(descriptorBindingUniformTexelBufferUpdateAfterBind)
+  VKW_FOLD_FEATURE(descriptorBindingStorageTexelBufferUpdateAfterBind)
+  VKW_FOLD_FEATURE(descriptorBindingUpdateUnusedWhilePending)
+  VKW_FOLD_FEATURE(descriptorBindingPartiallyBound)
+  VKW_FOLD_FEATURE(descriptorBindingVariableDescriptorCount)
+  VKW_FOLD_FEATURE(runtimeDescriptorArray)
+#undef VKW_FOLD_FEATURE
+}
+
 } // namespace
 
 Device::Device(Instance const &instance,
@@ -48,6 +78,120 @@ Device::Device(Instance const &instance,
   m_coreDeviceSymbols = loadDeviceSymbols(
       parent(), handle(), physicalDevice().requestedApiVersion());
 
+  if (physicalDevice().isFeatureEnabled(
+          PhysicalDevice::extended_feature::synchronization2)) {
+    if (apiVersion() >= ApiVersion{1, 3, 0}) {
+      auto symbols = core<1, 3>();
+      m_synchronization2Symbols.vkCmdPipelineBarrier2 =
+          symbols.vkCmdPipelineBarrier2;
+      m_synchronization2Symbols.vkQueueSubmit2 = symbols.vkQueueSubmit2;
+    } else {
+      Extension<ext::KHR_synchronization2> symbols{*this};
+      m_synchronization2Symbols.vkCmdPipelineBarrier2 =
+          symbols.vkCmdPipelineBarrier2KHR;
+      m_synchronization2Symbols.vkQueueSubmit2 = symbols.vkQueueSubmit2KHR;
+    }
+  }
+
+  if (physicalDevice().isFeatureEnabled(
+          PhysicalDevice::extended_feature::timelineSemaphore)) {
+    if (apiVersion() >= ApiVersion{1, 2, 0}) {
+      auto symbols = core<1, 2>();
+      m_timelineSemaphoreSymbols.vkGetSemaphoreCounterValue =
+          symbols.vkGetSemaphoreCounterValue;
+      m_timelineSemaphoreSymbols.vkWaitSemaphores = symbols.vkWaitSemaphores;
+      m_timelineSemaphoreSymbols.vkSignalSemaphore = symbols.vkSignalSemaphore;
+    } else {
+      Extension<ext::KHR_timeline_semaphore> symbols{*this};
+      m_timelineSemaphoreSymbols.vkGetSemaphoreCounterValue =
+          symbols.vkGetSemaphoreCounterValueKHR;
+      m_timelineSemaphoreSymbols.vkWaitSemaphores =
+          symbols.vkWaitSemaphoresKHR;
+      m_timelineSemaphoreSymbols.vkSignalSemaphore =
+          symbols.vkSignalSemaphoreKHR;
+    }
+  }
+
+  // Core commands are only valid with the core feature enabled
+  if (physicalDevice().enabledVulkan12Features().drawIndirectCount) {
+    auto symbols = core<1, 2>();
+    m_drawIndirectCountSymbols.vkCmdDrawIndirectCount =
+        symbols.vkCmdDrawIndirectCount;
+    m_drawIndirectCountSymbols.vkCmdDrawIndexedIndirectCount =
+        symbols.vkCmdDrawIndexedIndirectCount;
+  } else if (isExtensionEnabled(ext::KHR_draw_indirect_count)) {
+    Extension<ext::KHR_draw_indirect_count> symbols{*this};
+    m_drawIndirectCountSymbols.vkCmdDrawIndirectCount =
+        symbols.vkCmdDrawIndirectCountKHR;
+    m_drawIndirectCountSymbols.vkCmdDrawIndexedIndirectCount =
+        symbols.vkCmdDrawIndexedIndirectCountKHR;
+  }
+
+  if (physicalDevice().isFeatureEnabled(
+          PhysicalDevice::extended_feature::multiDraw)) {
+    Extension<ext::EXT_multi_draw> symbols{*this};
+    m_multiDrawSymbols.vkCmdDrawMultiEXT = symbols.vkCmdDrawMultiEXT;
+    m_multiDrawSymbols.vkCmdDrawMultiIndexedEXT =
+        symbols.vkCmdDrawMultiIndexedEXT;
+  }
+
+  if (apiVersion() >= ApiVersion{1, 1, 0}) {
+    auto symbols = core<1, 1>();
+    m_descriptorUpdateTemplateSymbols.vkCreateDescriptorUpdateTemplate =
+        symbols.vkCreateDescriptorUpdateTemplate;
+    m_descriptorUpdateTemplateSymbols.vkDestroyDescriptorUpdateTemplate =
+        symbols.vkDestroyDescriptorUpdateTemplate;
+    m_descriptorUpdateTemplateSymbols.vkUpdateDescriptorSetWithTemplate =
+        symbols.vkUpdateDescriptorSetWithTemplate;
+  } else if (isExtensionEnabled(ext::KHR_descriptor_update_template)) {
+    Extension<ext::KHR_descriptor_update_template> symbols{*this};
+    m_descriptorUpdateTemplateSymbols.vkCreateDescriptorUpdateTemplate =
+        symbols.vkCreateDescriptorUpdateTemplateKHR;
+    m_descriptorUpdateTemplateSymbols.vkDestroyDescriptorUpdateTemplate =
+        symbols.vkDestroyDescriptorUpdateTemplateKHR;
+    m_descriptorUpdateTemplateSymbols.vkUpdateDescriptorSetWithTemplate =
+        symbols.vkUpdateDescriptorSetWithTemplateKHR;
+  }
+
+  if (isExtensionEnabled(ext::KHR_push_descriptor)) {
+    Extension<ext::KHR_push_descriptor> symbols{*this};
+    m_pushDescriptorSymbols.vkCmdPushDescriptorSet =
+        symbols.vkCmdPushDescriptorSetKHR;
+    // Declared in a separate require block of the extension that symbol table
+    // generator doesn't pick up.
+    if (m_descriptorUpdateTemplateSymbols.vkCreateDescriptorUpdateTemplate)
+      m_pushDescriptorSymbols.vkCmdPushDescriptorSetWithTemplate =
+          reinterpret_cast<PFN_vkCmdPushDescriptorSetWithTemplateKHR>(
+              internal::getProcAddrOf(*this)(
+                  handle(), "vkCmdPushDescriptorSetWithTemplateKHR"));
+  }
+
+  if (physicalDevice().isFeatureEnabled(
+          PhysicalDevice::extended_feature::bufferDeviceAddress)) {
+    if (apiVersion() >= ApiVersion{1, 2, 0}) {
+      m_bufferDeviceAddressSymbols.vkGetBufferDeviceAddress =
+          core<1, 2>().vkGetBufferDeviceAddress;
+    } else {
+      Extension<ext::KHR_buffer_device_address> symbols{*this};
+      m_bufferDeviceAddressSymbols.vkGetBufferDeviceAddress =
+          symbols.vkGetBufferDeviceAddressKHR;
+    }
+  }
+
+  if (physicalDevice().isFeatureEnabled(
+          PhysicalDevice::extended_feature::descriptorBuffer)) {
+    Extension<ext::EXT_descriptor_buffer> symbols{*this};
+    m_descriptorBufferSymbols.vkGetDescriptorSetLayoutSizeEXT =
+        symbols.vkGetDescriptorSetLayoutSizeEXT;
+    m_descriptorBufferSymbols.vkGetDescriptorSetLayoutBindingOffsetEXT =
+        symbols.vkGetDescriptorSetLayoutBindingOffsetEXT;
+    m_descriptorBufferSymbols.vkGetDescriptorEXT = symbols.vkGetDescriptorEXT;
+    m_descriptorBufferSymbols.vkCmdBindDescriptorBuffersEXT =
+        symbols.vkCmdBindDescriptorBuffersEXT;
+    m_descriptorBufferSymbols.vkCmdSetDescriptorBufferOffsetsEXT =
+        symbols.vkCmdSetDescriptorBufferOffsetsEXT;
+  }
+
   std::transform(queueFamilies.begin(), queueFamilies.end(),
                  std::back_inserter(m_queues),
                  [this](QueueFamily const &family) {
@@ -60,6 +204,9 @@ Device::Device(Instance const &instance,
 
                    return queues;
                  });
+
+  m_deletionQueue = std::make_unique<DeletionQueue>(*this);
+  m_stateCache = std::make_unique<StateCache>(*this);
 }
 
 DeviceInfo::DeviceInfo(PhysicalDevice phDevice) noexcept(ExceptionsDisabled)
@@ -102,6 +249,95 @@ DeviceInfo::DeviceInfo(PhysicalDevice phDevice) noexcept(ExceptionsDisabled)
   }
 
   m_apiVer = m_ph_device.requestedApiVersion();
+
+  m_chainExtendedFeatures();
+}
+
+void DeviceInfo::m_chainExtendedFeatures() noexcept(ExceptionsDisabled) {
+  void const **pNext = &m_createInfo.pNext;
+
+  // Features promoted to 1.2 go to VkPhysicalDeviceVulkan12Features instead
+  // of their own structures once it has to be chained.
+  bool vulkan12 = m_ph_device.enabledVulkan12Features().drawIndirectCount;
+  if (vulkan12) {
+    if (m_ph_device.requestedApiVersion() < ApiVersion{1, 2, 0})
+      postError(Error("Feature drawIndirectCount of Vulkan 1.2 is enabled, "
+                      "but device is not created with api version 1.2"));
+    m_vulkan12Features = m_ph_device.enabledVulkan12Features();
+    m_vulkan12Features.pNext = nullptr;
+    *pNext = &m_vulkan12Features;
+    pNext = const_cast<void const **>(&m_vulkan12Features.pNext);
+  }
+
+  if (m_ph_device.isFeatureEnabled(
+          PhysicalDevice::extended_feature::synchronization2)) {
+    m_synchronization2Features = m_ph_device.enabledSynchronization2Features();
+    m_synchronization2Features.pNext = nullptr;
+    *pNext = &m_synchronization2Features;
+    pNext = const_cast<void const **>(&m_synchronization2Features.pNext);
+  }
+
+  if (m_ph_device.isFeatureEnabled(
+          PhysicalDevice::extended_feature::timelineSemaphore)) {
+    if (vulkan12) {
+      m_vulkan12Features.timelineSemaphore = VK_TRUE;
+    } else {
+      m_timelineSemaphoreFeatures =
+          m_ph_device.enabledTimelineSemaphoreFeatures();
+      m_timelineSemaphoreFeatures.pNext = nullptr;
+      *pNext = &m_timelineSemaphoreFeatures;
+      pNext = const_cast<void const **>(&m_timelineSemaphoreFeatures.pNext);
+    }
+  }
+
+  if (m_ph_device.isFeatureEnabled(
+          PhysicalDevice::extended_feature::multiDraw)) {
+    m_multiDrawFeatures = m_ph_device.enabledMultiDrawFeatures();
+    m_multiDrawFeatures.pNext = nullptr;
+    *pNext = &m_multiDrawFeatures;
+    pNext = const_cast<void const **>(&m_multiDrawFeatures.pNext);
+  }
+
+  if (m_ph_device.descriptorIndexingEnabled()) {
+    if (vulkan12) {
+      foldDescriptorIndexingFeatures(
+          m_vulkan12Features, m_ph_device.enabledDescriptorIndexingFeatures());
+      // Required to be set along with the extension
+      if (m_enabledExtensions.contains(ext::EXT_descriptor_indexing))
+        m_vulkan12Features.descriptorIndexing = VK_TRUE;
+    } else {
+      m_descriptorIndexingFeatures =
+          m_ph_device.enabledDescriptorIndexingFeatures();
+      m_descriptorIndexingFeatures.pNext = nullptr;
+      *pNext = &m_descriptorIndexingFeatures;
+      pNext = const_cast<void const **>(&m_descriptorIndexingFeatures.pNext);
+    }
+  }
+
+  if (m_ph_device.isFeatureEnabled(
+          PhysicalDevice::extended_feature::bufferDeviceAddress)) {
+    auto const &enabled = m_ph_device.enabledBufferDeviceAddressFeatures();
+    if (vulkan12) {
+      m_vulkan12Features.bufferDeviceAddress = enabled.bufferDeviceAddress;
+      m_vulkan12Features.bufferDeviceAddressCaptureReplay =
+          enabled.bufferDeviceAddressCaptureReplay;
+      m_vulkan12Features.bufferDeviceAddressMultiDevice =
+          enabled.bufferDeviceAddressMultiDevice;
+    } else {
+      m_bufferDeviceAddressFeatures = enabled;
+      m_bufferDeviceAddressFeatures.pNext = nullptr;
+      *pNext = &m_bufferDeviceAddressFeatures;
+      pNext = const_cast<void const **>(&m_bufferDeviceAddressFeatures.pNext);
+    }
+  }
+
+  if (m_ph_device.isFeatureEnabled(
+          PhysicalDevice::extended_feature::descriptorBuffer)) {
+    m_descriptorBufferFeatures = m_ph_device.enabledDescriptorBufferFeatures();
+    m_descriptorBufferFeatures.pNext = nullptr;
+    *pNext = &m_descriptorBufferFeatures;
+    pNext = const_cast<void const **>(&m_descriptorBufferFeatures.pNext);
+  }
 }
 
 Queue const &Device::anyGraphicsQueue() const noexcept(ExceptionsDisabled) {
@@ -187,8 +423,20 @@ Queue const &Device::getSpecificQueue(QueueFamily::Type type) const
   postError(Error{ss.str()});
 }
 
-void Device::waitIdle() noexcept(ExceptionsDisabled){
-    VK_CHECK_RESULT(core<1, 0>().vkDeviceWaitIdle(handle()))}
+void Device::waitIdle() noexcept(ExceptionsDisabled) {
+  VK_CHECK_RESULT(core<1, 0>().vkDeviceWaitIdle(handle()))
+
+  // Nothing retired so far can be in use anymore
+  m_deletionQueue->flush();
+}
+
+CompletionWatcher &Device::completionWatcher() const
+    noexcept(ExceptionsDisabled) {
+  std::call_once(m_completionWatcherOnce, [this]() {
+    m_completionWatcher = std::make_unique<CompletionWatcher>(*this);
+  });
+  return *m_completionWatcher;
+}
 
 VmaAllocator Device::m_allocatorCreateImpl() noexcept(ExceptionsDisabled) {
   VmaAllocatorCreateInfo allocatorInfo = {};
@@ -197,6 +445,16 @@ VmaAllocator Device::m_allocatorCreateImpl() noexcept(ExceptionsDisabled) {
   allocatorInfo.device = handle();
   allocatorInfo.instance = parent();
 
+  // Lets buffers created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT get
+  // memory their address can be queried for.
+  if (physicalDevice().isFeatureEnabled(
+          PhysicalDevice::extended_feature::bufferDeviceAddress)) {
+    allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+    // Without the extension VMA only uses core 1.2 if told so
+    if (!isExtensionEnabled(ext::KHR_buffer_device_address))
+      allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_2;
+  }
+
   VmaVulkanFunctions vmaVulkanFunctions{};
   vmaVulkanFunctions.vkGetInstanceProcAddr =
       parent().parent().vkGetInstanceProcAddr;
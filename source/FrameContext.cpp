@@ -0,0 +1,153 @@
+#include "vkw/FrameContext.hpp"
+#include "vkw/Device.hpp"
+#include "vkw/Fence.hpp"
+
+namespace vkw {
+
+FrameContext::Frame::Frame(
+    Device &device, VkDeviceSize uploadSize,
+    VkBufferUsageFlags uploadUsage) noexcept(ExceptionsDisabled)
+    : imageAcquired(device), renderFinished(device),
+      waitSemaphore(imageAcquired), signalSemaphore(renderFinished) {
+  if (uploadSize != 0)
+    uploadBuffer.emplace(
+        device, uploadSize, uploadUsage,
+        VmaAllocationCreateInfo{.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+                                .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+                                .requiredFlags =
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT});
+
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.pNext = nullptr;
+  submitInfo.waitSemaphoreCount = 1;
+  submitInfo.pWaitSemaphores = &waitSemaphore;
+  submitInfo.pWaitDstStageMask = &waitStage;
+  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.pSignalSemaphores = &signalSemaphore;
+}
+
+FrameContext::FrameContext(Device &device, Queue const &queue,
+                           SwapChain &swapChain, uint32_t framesInFlight,
+                           VkDeviceSize uploadSize,
+                           VkBufferUsageFlags uploadUsage,
+                           uint32_t threadCount) noexcept(ExceptionsDisabled)
+    : m_queue(queue), m_swapChain(swapChain),
+      m_commandPools(device, queue.family().index(), framesInFlight,
+                     threadCount),
+      m_latency(framesInFlight) {
+  for (uint32_t i = 0; i < framesInFlight; ++i)
+    m_frames.emplace_back(device, uploadSize, uploadUsage);
+}
+
+SwapChain::AcquireStatus FrameContext::beginFrame(uint64_t timeout) noexcept(
+    ExceptionsDisabled) {
+  if (m_frameBegun)
+    postError(Error("FrameContext: previous frame has not been ended"));
+
+  // With lowered latency also wait for the frame `latency` frames back,
+  // CommandPoolRing itself only waits for the slot it is about to reuse.
+  auto frameCount = framesInFlight();
+  if (m_latency < frameCount) {
+    auto slot =
+        (m_commandPools.currentFrame() + 1 + frameCount - m_latency) %
+        frameCount;
+    m_commandPools.frameFence(slot).wait();
+  }
+
+  m_commandPools.beginFrame();
+  auto &frame = m_current();
+
+  auto status =
+      m_swapChain.get().acquireNextImage(frame.imageAcquired, timeout);
+  if (status != SwapChain::SUCCESSFUL && status != SwapChain::SUBOPTIMAL) {
+    // Slot fence has already been reset: signal it with an empty submission
+    // so that the slot can be waited for next time.
+    m_queue.get().submit(std::span<VkSubmitInfo const>{},
+                         m_commandPools.frameFence());
+    return status;
+  }
+
+  frame.uploadOffset = 0;
+  frame.commandBuffers.clear();
+  m_frameBegun = true;
+
+  return status;
+}
+
+bool FrameContext::endFrame(VkPipelineStageFlags waitStage) noexcept(
+    ExceptionsDisabled) {
+  if (!m_frameBegun)
+    postError(Error("FrameContext: frame has not been begun"));
+
+  auto &frame = m_current();
+
+  if (frame.uploadBuffer && frame.uploadOffset != 0 &&
+      !frame.uploadBuffer->coherent())
+    frame.uploadBuffer->flush(0, frame.uploadOffset);
+
+  frame.waitStage = waitStage;
+  frame.submitInfo.commandBufferCount = frame.commandBuffers.size();
+  frame.submitInfo.pCommandBuffers = frame.commandBuffers.data();
+  m_queue.get().submit(std::span<VkSubmitInfo const>{&frame.submitInfo, 1},
+                       m_commandPools.frameFence());
+
+  if (frame.presentInfo)
+    frame.presentInfo->updateImages();
+  else
+    frame.presentInfo.emplace(m_swapChain.get(), frame.renderFinished);
+
+  m_frameBegun = false;
+  ++m_frameNumber;
+
+  return m_queue.get().present(*frame.presentInfo);
+}
+
+PrimaryCommandBuffer &
+FrameContext::commandBuffer() noexcept(ExceptionsDisabled) {
+  if (!m_frameBegun)
+    postError(Error("FrameContext: frame has not been begun"));
+
+  auto &commandBuffer = m_commandPools.primary();
+  m_current().commandBuffers.push_back(commandBuffer);
+  return commandBuffer;
+}
+
+FrameContext::UploadRegion
+FrameContext::upload(VkDeviceSize size, VkDeviceSize alignment) noexcept(
+    ExceptionsDisabled) {
+  // Memory of the slot is only free once beginFrame() waited for it
+  if (!m_frameBegun)
+    postError(Error("FrameContext: frame has not been begun"));
+
+  auto &frame = m_current();
+  if (!frame.uploadBuffer)
+    postError(Error("FrameContext: created without upload buffer"));
+
+  auto offset = (frame.uploadOffset + alignment - 1) / alignment * alignment;
+  if (offset + size > frame.uploadBuffer->bufferSize())
+    postError(Error("FrameContext: upload buffer of the frame is exhausted"));
+
+  frame.uploadOffset = offset + size;
+  return {frame.uploadBuffer->mapped().subspan(offset, size),
+          *frame.uploadBuffer, offset};
+}
+
+void FrameContext::setSwapChain(SwapChain &swapChain) noexcept(
+    ExceptionsDisabled) {
+  if (m_frameBegun)
+    postError(Error("FrameContext: cannot replace swap chain mid-frame"));
+
+  m_swapChain = swapChain;
+  for (auto &frame : m_frames)
+    frame.presentInfo.reset();
+}
+
+void FrameContext::setFrameLatency(uint32_t latency) noexcept(
+    ExceptionsDisabled) {
+  if (latency == 0 || latency > framesInFlight())
+    postError(Error("FrameContext: frame latency must be in range [1, "
+                    "framesInFlight]"));
+  m_latency = latency;
+}
+
+} // namespace vkw
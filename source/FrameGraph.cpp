@@ -0,0 +1,510 @@
+#include "vkw/FrameGraph.hpp"
+#include "vkw/Buffer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace vkw {
+
+namespace {
+
+// Generic memory accesses stand for the specific accesses of their stages.
+VkAccessFlags specificAccess(VkPipelineStageFlags stage,
+                             VkAccessFlags access) noexcept {
+  constexpr VkPipelineStageFlags shaderStages =
+      VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+      VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+      VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT |
+      VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT |
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  constexpr VkPipelineStageFlags depthStages =
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+  if (access & VK_ACCESS_MEMORY_READ_BIT) {
+    if (stage & VK_PIPELINE_STAGE_TRANSFER_BIT)
+      access |= VK_ACCESS_TRANSFER_READ_BIT;
+    if (stage & VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
+      access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+    if (stage & depthStages)
+      access |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+    if (stage & shaderStages)
+      access |= VK_ACCESS_SHADER_READ_BIT;
+  }
+  if (access & VK_ACCESS_MEMORY_WRITE_BIT) {
+    if (stage & VK_PIPELINE_STAGE_TRANSFER_BIT)
+      access |= VK_ACCESS_TRANSFER_WRITE_BIT;
+    if (stage & VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
+      access |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    if (stage & depthStages)
+      access |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    if (stage & shaderStages)
+      access |= VK_ACCESS_SHADER_WRITE_BIT;
+  }
+  return access;
+}
+
+VkImageUsageFlags usageFromAccess(VkPipelineStageFlags stage,
+                                  VkAccessFlags access) noexcept {
+  access = specificAccess(stage, access);
+
+  VkImageUsageFlags usage = 0;
+  if (access & (VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT))
+    usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  if (access & (VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT))
+    usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  if (access & VK_ACCESS_INPUT_ATTACHMENT_READ_BIT)
+    usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+  if (access & VK_ACCESS_TRANSFER_READ_BIT)
+    usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  if (access & VK_ACCESS_TRANSFER_WRITE_BIT)
+    usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  // Shaders only write storage images. Plain shader reads are taken for
+  // sampling, reads of read-write accesses belong to the storage image.
+  if (access & VK_ACCESS_SHADER_WRITE_BIT)
+    usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+  else if (access & VK_ACCESS_SHADER_READ_BIT)
+    usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+  return usage;
+}
+
+template <ImagePixelType ptype>
+auto makeTransientImage(VmaAllocator allocator,
+                        FrameGraph::TransientImageInfo const &info) noexcept(
+    ExceptionsDisabled) {
+  return std::make_unique<Image<ptype, I2D>>(
+      allocator, VmaAllocationCreateInfo{.usage = VMA_MEMORY_USAGE_GPU_ONLY},
+      info.format, info.width, info.height, 1, 1, 1, info.usage);
+}
+
+} // namespace
+
+FrameGraph::FrameGraph(Device const &device) noexcept : m_device(device) {}
+
+ImageInterface const &FrameGraph::Resources::image(ImageHandle handle) const
+    noexcept(ExceptionsDisabled) {
+  return m_graph.m_image(handle.index);
+}
+
+BufferBase const &FrameGraph::Resources::buffer(BufferHandle handle) const
+    noexcept(ExceptionsDisabled) {
+  auto const &buffers = m_graph.m_compiledStructure.buffers;
+  if (handle.index >= buffers.size())
+    postError(Error("FrameGraph: invalid buffer handle"));
+
+  return *buffers[handle.index].buffer;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::read(
+    ImageHandle image, VkImageLayout layout, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  m_graph.m_addAccess(m_index, Access{ResourceKind::Image, image.index, layout,
+                                      stage, access, true, false});
+  return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::write(
+    ImageHandle image, VkImageLayout layout, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  m_graph.m_addAccess(m_index, Access{ResourceKind::Image, image.index, layout,
+                                      stage, access, false, true});
+  return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::read(
+    BufferHandle buffer, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  m_graph.m_addAccess(m_index,
+                      Access{ResourceKind::Buffer, buffer.index,
+                             VK_IMAGE_LAYOUT_UNDEFINED, stage, access, true,
+                             false});
+  return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::write(
+    BufferHandle buffer, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  m_graph.m_addAccess(m_index,
+                      Access{ResourceKind::Buffer, buffer.index,
+                             VK_IMAGE_LAYOUT_UNDEFINED, stage, access, false,
+                             true});
+  return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::sideEffect() noexcept {
+  m_graph.m_structure.passes[m_index].sideEffect = true;
+  m_graph.m_dirty = true;
+  return *this;
+}
+
+FrameGraph::ImageHandle FrameGraph::importImage(
+    ImageInterface const &image, VkImageLayout currentLayout,
+    VkImageLayout finalLayout) noexcept(ExceptionsDisabled) {
+  ImageDesc desc{};
+  desc.imported = &image;
+  desc.handle = image;
+  desc.initialLayout = currentLayout;
+  desc.finalLayout = finalLayout;
+  m_structure.images.push_back(desc);
+  m_dirty = true;
+
+  return ImageHandle{static_cast<uint32_t>(m_structure.images.size() - 1)};
+}
+
+FrameGraph::BufferHandle FrameGraph::importBuffer(
+    BufferBase const &buffer) noexcept(ExceptionsDisabled) {
+  m_structure.buffers.push_back(BufferDesc{&buffer, buffer});
+  m_dirty = true;
+
+  return BufferHandle{static_cast<uint32_t>(m_structure.buffers.size() - 1)};
+}
+
+FrameGraph::ImageHandle FrameGraph::createImage(
+    TransientImageInfo const &info) noexcept(ExceptionsDisabled) {
+  if (info.format == VK_FORMAT_UNDEFINED || info.width == 0 ||
+      info.height == 0)
+    postError(Error("FrameGraph: transient image must have format and "
+                    "non-zero extents"));
+
+  ImageDesc desc{};
+  desc.info = info;
+  m_structure.images.push_back(desc);
+  m_dirty = true;
+
+  return ImageHandle{static_cast<uint32_t>(m_structure.images.size() - 1)};
+}
+
+FrameGraph::PassBuilder
+FrameGraph::addPass(std::string_view name,
+                    RecordCallback callback) noexcept(ExceptionsDisabled) {
+  m_structure.passes.push_back(PassDesc{std::string(name), {}, false});
+  m_callbacks.push_back(std::move(callback));
+  m_dirty = true;
+
+  return PassBuilder{*this,
+                     static_cast<uint32_t>(m_structure.passes.size() - 1)};
+}
+
+void FrameGraph::reset() noexcept {
+  m_structure.passes.clear();
+  m_structure.images.clear();
+  m_structure.buffers.clear();
+  m_callbacks.clear();
+  m_dirty = true;
+}
+
+void FrameGraph::compile() noexcept(ExceptionsDisabled) {
+  if (m_compiled && !m_dirty)
+    return;
+
+  if (m_compiled && m_structure == m_compiledStructure) {
+    m_dirty = false;
+    return;
+  }
+
+  m_compiled = false;
+  m_compiledStructure = m_structure;
+
+  m_cull();
+  m_assignTransientImages();
+  m_computeBarriers();
+
+  m_compiled = true;
+  m_dirty = false;
+  m_generation++;
+}
+
+void FrameGraph::execute(PrimaryCommandBuffer &commandBuffer) const
+    noexcept(ExceptionsDisabled) {
+  m_checkCompiled();
+
+  m_record(commandBuffer, 0, m_schedule.size());
+  m_recordFinal(commandBuffer);
+}
+
+std::vector<std::string_view> FrameGraph::scheduledPasses() const
+    noexcept(ExceptionsDisabled) {
+  m_checkCompiled();
+
+  std::vector<std::string_view> names;
+  names.reserve(m_schedule.size());
+  for (auto pass : m_schedule)
+    names.emplace_back(m_compiledStructure.passes[pass].name);
+  return names;
+}
+
+void FrameGraph::trimTransientPool() noexcept {
+  std::vector<int32_t> remap(m_pool.size(), -1);
+  std::vector<PooledImage> kept;
+
+  for (auto &assigned : m_transientAssignment) {
+    if (assigned < 0)
+      continue;
+    if (remap[assigned] < 0) {
+      remap[assigned] = kept.size();
+      kept.push_back(std::move(m_pool[assigned]));
+    }
+    assigned = remap[assigned];
+  }
+
+  m_pool = std::move(kept);
+}
+
+void FrameGraph::m_addAccess(uint32_t pass,
+                             Access access) noexcept(ExceptionsDisabled) {
+  auto resourceCount = access.kind == ResourceKind::Image
+                           ? m_structure.images.size()
+                           : m_structure.buffers.size();
+  if (access.index >= resourceCount)
+    postError(Error("FrameGraph: invalid resource handle"));
+
+  auto &passDesc = m_structure.passes[pass];
+  m_dirty = true;
+
+  // Several accesses to one resource within a pass are merged, so that the
+  // pass doesn't depend on itself.
+  auto found = std::find_if(passDesc.accesses.begin(), passDesc.accesses.end(),
+                            [&access](Access const &another) {
+                              return another.kind == access.kind &&
+                                     another.index == access.index;
+                            });
+  if (found == passDesc.accesses.end()) {
+    passDesc.accesses.push_back(access);
+    return;
+  }
+
+  if (found->layout != access.layout)
+    postError(Error("FrameGraph: pass '" + passDesc.name +
+                    "' accesses the same image in different layouts"));
+
+  found->stage |= access.stage;
+  found->access |= access.access;
+  found->read |= access.read;
+  found->write |= access.write;
+}
+
+void FrameGraph::m_cull() noexcept(ExceptionsDisabled) {
+  auto const &passes = m_compiledStructure.passes;
+  auto const &images = m_compiledStructure.images;
+
+  // Contents of imported resources are visible outside of the graph
+  std::vector<bool> imageNeeded(images.size());
+  std::vector<bool> bufferNeeded(m_compiledStructure.buffers.size(), true);
+  for (size_t i = 0; i < images.size(); ++i)
+    imageNeeded[i] = images[i].imported != nullptr;
+
+  auto needed = [&](Access const &access) -> bool {
+    return access.kind == ResourceKind::Image ? imageNeeded[access.index]
+                                              : bufferNeeded[access.index];
+  };
+
+  m_schedule.clear();
+
+  for (auto pass = passes.size(); pass-- > 0;) {
+    auto const &accesses = passes[pass].accesses;
+    bool alive = passes[pass].sideEffect ||
+                 std::any_of(accesses.begin(), accesses.end(),
+                             [&](Access const &access) {
+                               return access.write && needed(access);
+                             });
+    if (!alive)
+      continue;
+
+    for (auto const &access : accesses) {
+      if (!access.read)
+        continue;
+      if (access.kind == ResourceKind::Image)
+        imageNeeded[access.index] = true;
+      else
+        bufferNeeded[access.index] = true;
+    }
+
+    m_schedule.push_back(pass);
+  }
+
+  std::reverse(m_schedule.begin(), m_schedule.end());
+}
+
+void FrameGraph::m_assignTransientImages() noexcept(ExceptionsDisabled) {
+  auto const &passes = m_compiledStructure.passes;
+  auto const &images = m_compiledStructure.images;
+
+  struct Lifetime {
+    size_t first = std::numeric_limits<size_t>::max();
+    size_t last = 0;
+    VkImageUsageFlags usage = 0;
+  };
+
+  std::vector<Lifetime> lifetimes(images.size());
+  for (size_t position = 0; position < m_schedule.size(); ++position) {
+    for (auto const &access : passes[m_schedule[position]].accesses) {
+      if (access.kind != ResourceKind::Image || images[access.index].imported)
+        continue;
+      auto &lifetime = lifetimes[access.index];
+      lifetime.first = std::min(lifetime.first, position);
+      lifetime.last = position;
+      lifetime.usage |= usageFromAccess(access.stage, access.access);
+    }
+  }
+
+  std::vector<uint32_t> order;
+  for (uint32_t i = 0; i < images.size(); ++i)
+    if (lifetimes[i].first != std::numeric_limits<size_t>::max())
+      order.push_back(i);
+  std::sort(order.begin(), order.end(), [&lifetimes](auto lhs, auto rhs) {
+    return lifetimes[lhs].first < lifetimes[rhs].first;
+  });
+
+  // Last schedule position at which pooled image is used, -1 if free
+  std::vector<int64_t> busyUntil(m_pool.size(), -1);
+  m_transientAssignment.assign(images.size(), -1);
+
+  auto allocator = m_device.get().getAllocator();
+
+  for (auto index : order) {
+    auto const &lifetime = lifetimes[index];
+    auto info = images[index].info;
+    info.usage |= lifetime.usage;
+
+    size_t pooled = 0;
+    for (; pooled < m_pool.size(); ++pooled)
+      if (m_pool[pooled].info == info &&
+          busyUntil[pooled] < static_cast<int64_t>(lifetime.first))
+        break;
+
+    if (pooled == m_pool.size()) {
+      TransientImage image;
+      switch (info.pixelType) {
+      case COLOR:
+        image = makeTransientImage<COLOR>(allocator, info);
+        break;
+      case DEPTH:
+        image = makeTransientImage<DEPTH>(allocator, info);
+        break;
+      case DEPTH_STENCIL:
+        image = makeTransientImage<DEPTH_STENCIL>(allocator, info);
+        break;
+      }
+      m_pool.push_back(PooledImage{info, std::move(image)});
+      busyUntil.push_back(-1);
+    }
+
+    busyUntil[pooled] = lifetime.last;
+    m_transientAssignment[index] = pooled;
+  }
+}
+
+void FrameGraph::m_computeBarriers() noexcept(ExceptionsDisabled) {
+  auto const &passes = m_compiledStructure.passes;
+  auto const &images = m_compiledStructure.images;
+
+  ResourceTracker tracker;
+
+  for (auto const &desc : images)
+    if (desc.imported)
+      tracker.assumeImageLayout(*desc.imported, desc.initialLayout);
+
+  auto completeRange = [&images](uint32_t index, ImageInterface const &image) {
+    auto range = image.completeSubresourceRange();
+    if (!images[index].imported &&
+        images[index].info.pixelType == DEPTH_STENCIL)
+      range.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    return range;
+  };
+
+  std::vector<bool> used(images.size());
+
+  m_barriers.clear();
+  m_barriers.reserve(m_schedule.size());
+
+  for (auto pass : m_schedule) {
+    for (auto const &access : passes[pass].accesses) {
+      if (access.kind == ResourceKind::Buffer) {
+        tracker.useBuffer(*m_compiledStructure.buffers[access.index].buffer,
+                          access.stage, access.access);
+        continue;
+      }
+
+      auto const &image = m_image(access.index);
+      // Pooled image may be left in any layout by its previous user, but
+      // contents of transient image are undefined at first use anyway.
+      if (!images[access.index].imported && !used[access.index])
+        tracker.assumeImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED);
+      used[access.index] = true;
+
+      tracker.useImage(image, completeRange(access.index, image),
+                       access.layout, access.stage, access.access);
+    }
+
+    m_barriers.push_back(tracker.pending());
+    tracker.clearPending();
+  }
+
+  for (uint32_t i = 0; i < images.size(); ++i) {
+    auto const &desc = images[i];
+    if (!desc.imported || desc.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+      continue;
+    tracker.useImage(*desc.imported, completeRange(i, *desc.imported),
+                     desc.finalLayout, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                     0);
+  }
+
+  m_finalBarriers = tracker.pending();
+}
+
+ImageInterface const &
+FrameGraph::m_image(uint32_t index) const noexcept(ExceptionsDisabled) {
+  auto const &images = m_compiledStructure.images;
+  if (index >= images.size())
+    postError(Error("FrameGraph: invalid image handle"));
+
+  if (images[index].imported)
+    return *images[index].imported;
+
+  if (m_transientAssignment[index] < 0)
+    postError(Error("FrameGraph: transient image is not used by any "
+                    "scheduled pass"));
+
+  return std::visit(
+      [](auto const &image) -> ImageInterface const & { return *image; },
+      m_pool[m_transientAssignment[index]].image);
+}
+
+void FrameGraph::m_checkCompiled() const noexcept(ExceptionsDisabled) {
+  if (!m_compiled || m_dirty)
+    postError(Error("FrameGraph: graph must be compiled before execution"));
+}
+
+void FrameGraph::m_record(PrimaryCommandBuffer &commandBuffer, size_t begin,
+                          size_t end) const noexcept(ExceptionsDisabled) {
+  Resources resources{*this};
+
+  for (auto position = begin; position < end; ++position) {
+    m_recordBarriers(commandBuffer, m_barriers[position]);
+    auto const &callback = m_callbacks[m_schedule[position]];
+    if (callback)
+      callback(commandBuffer, resources);
+  }
+}
+
+void FrameGraph::m_recordFinal(PrimaryCommandBuffer &commandBuffer) const
+    noexcept(ExceptionsDisabled) {
+  m_recordBarriers(commandBuffer, m_finalBarriers);
+}
+
+void FrameGraph::m_recordBarriers(
+    PrimaryCommandBuffer &commandBuffer,
+    ResourceTracker::PendingBarriers const &barriers) noexcept {
+  if (barriers.empty())
+    return;
+
+  commandBuffer.pipelineBarrier(
+      barriers.srcStage, barriers.dstStage, {},
+      {barriers.imageBarriers.data(), barriers.imageBarriers.size()},
+      {barriers.bufferBarriers.data(), barriers.bufferBarriers.size()});
+}
+
+} // namespace vkw
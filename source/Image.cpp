@@ -65,6 +65,19 @@ AllocatedImage::~AllocatedImage() {
   if (m_image == VK_NULL_HANDLE)
     return;
   unmap();
+
+  auto *deletionQueue = DeletionQueue::find(m_allocator);
+  if (deletionQueue &&
+      deletionQueue->retire(
+          [](Device const &device, uint64_t image,
+             VmaAllocation allocation) noexcept {
+            vmaDestroyImage(device.getAllocator(),
+                            DeletionQueue::fromRaw<VkImage>(image),
+                            allocation);
+          },
+          DeletionQueue::toRaw(m_image), m_allocation))
+    return;
+
   vmaDestroyImage(m_allocator, m_image, m_allocation);
 }
 
@@ -0,0 +1,104 @@
+#include "vkw/ParallelRecorder.hpp"
+#include "vkw/FrameBuffer.hpp"
+#include "vkw/RenderPass.hpp"
+
+#include <boost/container/small_vector.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <latch>
+#include <mutex>
+
+namespace vkw {
+
+ParallelRecorder::ParallelRecorder(
+    CommandPoolRing &ring, ThreadPool &threadPool,
+    uint32_t firstThread) noexcept(ExceptionsDisabled)
+    : m_ring(ring), m_threadPool(threadPool), m_firstThread(firstThread) {
+  if (firstThread + threadPool.workerCount() > ring.threadCount())
+    postError(Error("ParallelRecorder: CommandPoolRing has fewer thread "
+                    "slots than ThreadPool workers"));
+}
+
+void ParallelRecorder::record(
+    PrimaryCommandBuffer &primary, RenderPass const &renderPass,
+    uint32_t subpass, FrameBuffer const &frameBuffer, size_t itemCount,
+    size_t chunkSize,
+    RecordCallback const &callback) noexcept(ExceptionsDisabled) {
+  VkCommandBufferInheritanceInfo inheritance{};
+  inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance.pNext = nullptr;
+  inheritance.renderPass = renderPass;
+  inheritance.subpass = subpass;
+  inheritance.framebuffer = frameBuffer;
+
+  m_record(primary, inheritance, itemCount, chunkSize, callback);
+}
+
+void ParallelRecorder::record(
+    PrimaryCommandBuffer &primary, size_t itemCount, size_t chunkSize,
+    RecordCallback const &callback) noexcept(ExceptionsDisabled) {
+  VkCommandBufferInheritanceInfo inheritance{};
+  inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance.pNext = nullptr;
+
+  m_record(primary, inheritance, itemCount, chunkSize, callback);
+}
+
+void ParallelRecorder::m_record(
+    PrimaryCommandBuffer &primary,
+    VkCommandBufferInheritanceInfo const &inheritance, size_t itemCount,
+    size_t chunkSize,
+    RecordCallback const &callback) noexcept(ExceptionsDisabled) {
+  if (chunkSize == 0)
+    postError(Error("ParallelRecorder: chunk size must be non-zero"));
+
+  auto chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+  if (chunkCount == 0)
+    return;
+
+  VkCommandBufferUsageFlags usage = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (inheritance.renderPass != VK_NULL_HANDLE)
+    usage |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+
+  boost::container::small_vector<SecondaryCommandBuffer *, 16> secondaries(
+      chunkCount);
+  std::latch done{static_cast<std::ptrdiff_t>(chunkCount)};
+  std::mutex errorMutex;
+  std::exception_ptr error;
+
+  for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+    m_threadPool.submit([&, chunk](uint32_t worker) {
+      try {
+        auto &commands = m_ring.secondary(m_firstThread + worker);
+        commands.begin(usage, &inheritance);
+
+        auto begin = chunk * chunkSize;
+        callback(commands, begin, std::min(begin + chunkSize, itemCount));
+
+        commands.end();
+        secondaries[chunk] = &commands;
+      } catch (...) {
+        std::lock_guard lock{errorMutex};
+        if (!error)
+          error = std::current_exception();
+      }
+      done.count_down();
+    });
+  }
+
+  done.wait();
+
+  if (error)
+    std::rethrow_exception(error);
+
+  // Stitch in chunk order regardless of which worker finished first
+  boost::container::small_vector<std::reference_wrapper<SecondaryCommandBuffer>,
+                                 16>
+      ordered;
+  for (auto *secondary : secondaries)
+    ordered.emplace_back(*secondary);
+  primary.executeCommands(ordered);
+}
+
+} // namespace vkw
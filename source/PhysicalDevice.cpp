@@ -1,7 +1,9 @@
 #include "vkw/PhysicalDevice.hpp"
 #include "Utils.hpp"
+#include "vkw/Extensions.hpp"
 #include "vkw/Instance.hpp"
 #include <algorithm>
+#include <array>
 #include <sstream>
 
 namespace vkw {
@@ -82,15 +84,178 @@ PhysicalDevice::PhysicalDevice(
       }
     }
   }
+
+  m_synchronization2Features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+  m_enabledSynchronization2Features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+  m_timelineSemaphoreFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  m_enabledTimelineSemaphoreFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  m_multiDrawFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTI_DRAW_FEATURES_EXT;
+  m_enabledMultiDrawFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTI_DRAW_FEATURES_EXT;
+  m_multiDrawProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTI_DRAW_PROPERTIES_EXT;
+  m_bufferDeviceAddressFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+  m_enabledBufferDeviceAddressFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+  m_descriptorBufferFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+  m_enabledDescriptorBufferFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+  m_descriptorBufferProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+  m_descriptorIndexingFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  m_enabledDescriptorIndexingFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  m_descriptorIndexingProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+  m_vulkan12Features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  m_enabledVulkan12Features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+  // Extended features can only be queried via vkGetPhysicalDeviceFeatures2
+  // which is core since 1.1
+  if (instance.apiVersion() < ApiVersion{1, 1, 0} ||
+      supportedApiVersion() < ApiVersion{1, 1, 0})
+    return;
+
+  VkPhysicalDeviceFeatures2 features2{};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  void **pNext = &features2.pNext;
+
+  if (supportedApiVersion() >= ApiVersion{1, 3, 0} ||
+      extensionSupported(ext::KHR_synchronization2)) {
+    *pNext = &m_synchronization2Features;
+    pNext = &m_synchronization2Features.pNext;
+  }
+
+  if (supportedApiVersion() >= ApiVersion{1, 2, 0} ||
+      extensionSupported(ext::KHR_timeline_semaphore)) {
+    *pNext = &m_timelineSemaphoreFeatures;
+    pNext = &m_timelineSemaphoreFeatures.pNext;
+  }
+
+  if (extensionSupported(ext::EXT_multi_draw)) {
+    *pNext = &m_multiDrawFeatures;
+    pNext = &m_multiDrawFeatures.pNext;
+  }
+
+  if (supportedApiVersion() >= ApiVersion{1, 2, 0} ||
+      extensionSupported(ext::KHR_buffer_device_address)) {
+    *pNext = &m_bufferDeviceAddressFeatures;
+    pNext = &m_bufferDeviceAddressFeatures.pNext;
+  }
+
+  if (extensionSupported(ext::EXT_descriptor_buffer)) {
+    *pNext = &m_descriptorBufferFeatures;
+    pNext = &m_descriptorBufferFeatures.pNext;
+  }
+
+  bool descriptorIndexing = supportedApiVersion() >= ApiVersion{1, 2, 0} ||
+                            extensionSupported(ext::EXT_descriptor_indexing);
+  if (descriptorIndexing) {
+    *pNext = &m_descriptorIndexingFeatures;
+    pNext = &m_descriptorIndexingFeatures.pNext;
+  }
+
+  instance.core<1, 1>().vkGetPhysicalDeviceFeatures2(m_physicalDevice,
+                                                     &features2);
+
+  // VkPhysicalDeviceVulkan12Features must not share a chain with structures
+  // of features it contains, so it is queried on its own.
+  if (instance.apiVersion() >= ApiVersion{1, 2, 0} &&
+      supportedApiVersion() >= ApiVersion{1, 2, 0}) {
+    VkPhysicalDeviceFeatures2 vulkan12Features2{};
+    vulkan12Features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    vulkan12Features2.pNext = &m_vulkan12Features;
+    instance.core<1, 1>().vkGetPhysicalDeviceFeatures2(m_physicalDevice,
+                                                       &vulkan12Features2);
+  }
+
+  VkPhysicalDeviceProperties2 properties2{};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  pNext = &properties2.pNext;
+
+  if (extensionSupported(ext::EXT_multi_draw)) {
+    *pNext = &m_multiDrawProperties;
+    pNext = &m_multiDrawProperties.pNext;
+  }
+
+  if (extensionSupported(ext::EXT_descriptor_buffer)) {
+    *pNext = &m_descriptorBufferProperties;
+    pNext = &m_descriptorBufferProperties.pNext;
+  }
+
+  if (descriptorIndexing) {
+    *pNext = &m_descriptorIndexingProperties;
+    pNext = &m_descriptorIndexingProperties.pNext;
+  }
+
+  if (properties2.pNext)
+    instance.core<1, 1>().vkGetPhysicalDeviceProperties2(m_physicalDevice,
+                                                         &properties2);
+
+  // Feature structures are copied along with physical device, so they must not
+  // keep pointers to each other.
+  m_synchronization2Features.pNext = nullptr;
+  m_timelineSemaphoreFeatures.pNext = nullptr;
+  m_multiDrawFeatures.pNext = nullptr;
+  m_multiDrawProperties.pNext = nullptr;
+  m_bufferDeviceAddressFeatures.pNext = nullptr;
+  m_descriptorBufferFeatures.pNext = nullptr;
+  m_descriptorBufferProperties.pNext = nullptr;
+  m_descriptorIndexingFeatures.pNext = nullptr;
+  m_descriptorIndexingProperties.pNext = nullptr;
+  m_vulkan12Features.pNext = nullptr;
 }
 
 namespace {
 
-void unhandledFeatureEntry(PhysicalDevice::feature feature) {
+template <typename T> void unhandledFeatureEntry(T feature) {
   std::stringstream ss;
   ss << "Unhandled feature entry: " << static_cast<unsigned>(feature);
   postError(Error(ss.view()));
 }
+struct DescriptorIndexingFeature {
+  PhysicalDevice::extended_feature feature;
+  VkBool32 VkPhysicalDeviceDescriptorIndexingFeatures::*member;
+  const char *name;
+};
+
+#define VKW_DESCRIPTOR_INDEXING_ENTRY(X)                                       \
+  DescriptorIndexingFeature{PhysicalDevice::extended_feature::X,               \
+                            &VkPhysicalDeviceDescriptorIndexingFeatures::X, #X}
+
+constexpr std::array descriptorIndexingFeatures{
+    VKW_DESCRIPTOR_INDEXING_ENTRY(shaderSampledImageArrayNonUniformIndexing),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(shaderStorageBufferArrayNonUniformIndexing),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(shaderStorageImageArrayNonUniformIndexing),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(descriptorBindingSampledImageUpdateAfterBind),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(descriptorBindingStorageImageUpdateAfterBind),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(
+        descriptorBindingStorageBufferUpdateAfterBind),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(descriptorBindingUpdateUnusedWhilePending),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(descriptorBindingPartiallyBound),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(descriptorBindingVariableDescriptorCount),
+    VKW_DESCRIPTOR_INDEXING_ENTRY(runtimeDescriptorArray)};
+
+#undef VKW_DESCRIPTOR_INDEXING_ENTRY
+
+DescriptorIndexingFeature const *
+descriptorIndexingFeature(PhysicalDevice::extended_feature feature) {
+  auto found = std::find_if(
+      descriptorIndexingFeatures.begin(), descriptorIndexingFeatures.end(),
+      [feature](auto const &entry) { return entry.feature == feature; });
+  return found != descriptorIndexingFeatures.end() ? found : nullptr;
+}
+
 const char *featureNameMap(PhysicalDevice::feature feature) {
   switch (feature) {
 #define VKW_FEATURE_ENTRY(X)                                                   \
@@ -136,6 +301,139 @@ void PhysicalDevice::enableFeature(feature feature) noexcept(
   };
 }
 
+bool PhysicalDevice::isFeatureSupported(extended_feature feature) const
+    noexcept(ExceptionsDisabled) {
+  if (auto *entry = descriptorIndexingFeature(feature))
+    return m_descriptorIndexingFeatures.*entry->member;
+
+  switch (feature) {
+  case extended_feature::synchronization2:
+    return m_synchronization2Features.synchronization2;
+  case extended_feature::timelineSemaphore:
+    return m_timelineSemaphoreFeatures.timelineSemaphore;
+  case extended_feature::multiDraw:
+    return m_multiDrawFeatures.multiDraw;
+  case extended_feature::bufferDeviceAddress:
+    return m_bufferDeviceAddressFeatures.bufferDeviceAddress;
+  case extended_feature::descriptorBuffer:
+    return m_descriptorBufferFeatures.descriptorBuffer;
+  case extended_feature::drawIndirectCount:
+    return m_vulkan12Features.drawIndirectCount ||
+           extensionSupported(ext::KHR_draw_indirect_count);
+  default:
+    unhandledFeatureEntry(feature);
+    return false;
+  }
+}
+
+bool PhysicalDevice::isFeatureEnabled(extended_feature feature) const
+    noexcept(ExceptionsDisabled) {
+  if (auto *entry = descriptorIndexingFeature(feature))
+    return m_enabledDescriptorIndexingFeatures.*entry->member;
+
+  switch (feature) {
+  case extended_feature::synchronization2:
+    return m_enabledSynchronization2Features.synchronization2;
+  case extended_feature::timelineSemaphore:
+    return m_enabledTimelineSemaphoreFeatures.timelineSemaphore;
+  case extended_feature::multiDraw:
+    return m_enabledMultiDrawFeatures.multiDraw;
+  case extended_feature::bufferDeviceAddress:
+    return m_enabledBufferDeviceAddressFeatures.bufferDeviceAddress;
+  case extended_feature::descriptorBuffer:
+    return m_enabledDescriptorBufferFeatures.descriptorBuffer;
+  case extended_feature::drawIndirectCount:
+    return m_enabledVulkan12Features.drawIndirectCount ||
+           std::find(m_enabledExtensions.begin(), m_enabledExtensions.end(),
+                     ext::KHR_draw_indirect_count) !=
+               m_enabledExtensions.end();
+  default:
+    unhandledFeatureEntry(feature);
+    return false;
+  }
+}
+
+void PhysicalDevice::enableFeature(extended_feature feature) noexcept(
+    ExceptionsDisabled) {
+  if (auto *entry = descriptorIndexingFeature(feature)) {
+    if (!isFeatureSupported(feature))
+      postError(Error("Feature " + std::string(entry->name) +
+                          " is unsupported",
+                      ErrorCode::FEATURE_UNSUPPORTED));
+    m_enabledDescriptorIndexingFeatures.*entry->member = VK_TRUE;
+    if (extensionSupported(ext::EXT_descriptor_indexing))
+      enableExtension(ext::EXT_descriptor_indexing);
+    return;
+  }
+
+  switch (feature) {
+  case extended_feature::synchronization2:
+    if (!isFeatureSupported(feature))
+      postError(Error("Feature synchronization2 is unsupported",
+                      ErrorCode::FEATURE_UNSUPPORTED));
+    m_enabledSynchronization2Features.synchronization2 = VK_TRUE;
+    // Device may be created with api version lower than 1.3 so extension is
+    // still needed to have the symbols loaded.
+    if (extensionSupported(ext::KHR_synchronization2))
+      enableExtension(ext::KHR_synchronization2);
+    break;
+  case extended_feature::timelineSemaphore:
+    if (!isFeatureSupported(feature))
+      postError(Error("Feature timelineSemaphore is unsupported",
+                      ErrorCode::FEATURE_UNSUPPORTED));
+    m_enabledTimelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+    if (extensionSupported(ext::KHR_timeline_semaphore))
+      enableExtension(ext::KHR_timeline_semaphore);
+    break;
+  case extended_feature::multiDraw:
+    if (!isFeatureSupported(feature))
+      postError(Error("Feature multiDraw is unsupported",
+                      ErrorCode::FEATURE_UNSUPPORTED));
+    m_enabledMultiDrawFeatures.multiDraw = VK_TRUE;
+    enableExtension(ext::EXT_multi_draw);
+    break;
+  case extended_feature::bufferDeviceAddress:
+    if (!isFeatureSupported(feature))
+      postError(Error("Feature bufferDeviceAddress is unsupported",
+                      ErrorCode::FEATURE_UNSUPPORTED));
+    m_enabledBufferDeviceAddressFeatures.bufferDeviceAddress = VK_TRUE;
+    if (extensionSupported(ext::KHR_buffer_device_address))
+      enableExtension(ext::KHR_buffer_device_address);
+    break;
+  case extended_feature::descriptorBuffer:
+    if (!isFeatureSupported(feature))
+      postError(Error("Feature descriptorBuffer is unsupported",
+                      ErrorCode::FEATURE_UNSUPPORTED));
+    m_enabledDescriptorBufferFeatures.descriptorBuffer = VK_TRUE;
+    enableExtension(ext::EXT_descriptor_buffer);
+    // Descriptor buffers are bound by their device addresses
+    enableFeature(extended_feature::bufferDeviceAddress);
+    break;
+  case extended_feature::drawIndirectCount:
+    // Core feature is only usable by devices created with 1.2
+    if (m_vulkan12Features.drawIndirectCount &&
+        requestedApiVersion() >= ApiVersion{1, 2, 0})
+      m_enabledVulkan12Features.drawIndirectCount = VK_TRUE;
+    else if (extensionSupported(ext::KHR_draw_indirect_count))
+      enableExtension(ext::KHR_draw_indirect_count);
+    else
+      postError(Error("Feature drawIndirectCount is unsupported",
+                      ErrorCode::FEATURE_UNSUPPORTED));
+    break;
+  default:
+    unhandledFeatureEntry(feature);
+  }
+}
+
+bool PhysicalDevice::descriptorIndexingEnabled() const noexcept {
+  return std::any_of(descriptorIndexingFeatures.begin(),
+                     descriptorIndexingFeatures.end(),
+                     [this](auto const &entry) {
+                       return m_enabledDescriptorIndexingFeatures.*
+                              entry.member;
+                     });
+}
+
 bool PhysicalDevice::extensionSupported(ext extension) const
     noexcept(ExceptionsDisabled) {
   return std::find(m_supportedExtensions.begin(), m_supportedExtensions.end(),
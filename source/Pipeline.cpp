@@ -91,6 +91,15 @@ Pipeline::~Pipeline() {
   if (m_pipeline == VK_NULL_HANDLE)
     return;
 
+  if (m_device.get().deletionQueue().retire(
+          [](Device const &device, uint64_t pipeline, VmaAllocation) noexcept {
+            device.core<1, 0>().vkDestroyPipeline(
+                device, DeletionQueue::fromRaw<VkPipeline>(pipeline),
+                device.hostAllocator().allocator());
+          },
+          DeletionQueue::toRaw(m_pipeline)))
+    return;
+
   m_device.get().core<1, 0>().vkDestroyPipeline(
       m_device.get(), m_pipeline, m_device.get().hostAllocator().allocator());
 }
@@ -36,6 +36,28 @@ void SubmitInfo::m_fill_info() noexcept {
   m_info.pWaitSemaphores = m_wait_semaphores.data();
   m_info.pWaitDstStageMask = m_wait_stage.data();
 }
+VkCommandBufferSubmitInfo SubmitInfo2::m_cmd_buffer_info(
+    PrimaryCommandBuffer const &commandBuffer) noexcept {
+  VkCommandBufferSubmitInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+  info.pNext = nullptr;
+  info.commandBuffer = commandBuffer;
+  info.deviceMask = 0;
+  return info;
+}
+
+void SubmitInfo2::m_fill_info() noexcept {
+  m_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+  m_info.pNext = nullptr;
+  m_info.flags = 0;
+  m_info.commandBufferInfoCount = m_cmd_buffers.size();
+  m_info.pCommandBufferInfos = m_cmd_buffers.data();
+  m_info.waitSemaphoreInfoCount = m_wait_semaphores.size();
+  m_info.pWaitSemaphoreInfos = m_wait_semaphores.data();
+  m_info.signalSemaphoreInfoCount = m_signal_semaphores.size();
+  m_info.pSignalSemaphoreInfos = m_signal_semaphores.data();
+}
+
 Queue::Queue(Device &parent, uint32_t queueFamilyIndex,
              uint32_t queueIndex) noexcept(ExceptionsDisabled)
     : m_parent(parent), m_familyIndex(queueFamilyIndex),
@@ -53,6 +75,7 @@ bool Queue::supportsPresenting(Surface const &surface) const
 }
 
 void Queue::waitIdle() const noexcept(ExceptionsDisabled) {
+  std::lock_guard lock{m_mutex};
   VK_CHECK_RESULT(m_parent.get().core<1, 0>().vkQueueWaitIdle(m_queue))
 }
 
@@ -76,15 +99,35 @@ static bool queuePresent(
 bool Queue::present(PresentInfo const &presentInfo) const
     noexcept(ExceptionsDisabled) {
   VkPresentInfoKHR info = presentInfo;
+  std::lock_guard lock{m_mutex};
   return queuePresent(presentInfo.swapChainExtension().vkQueuePresentKHR,
                       m_queue, &info);
 }
+
+void Queue::m_checkOwner() const noexcept(ExceptionsDisabled) {
+  auto owner = m_owner.load(std::memory_order_acquire);
+  if (owner != std::thread::id{} && owner != std::this_thread::get_id())
+    postError(Error("Queue is owned by a SubmissionQueue: submit through "
+                    "SubmissionQueue::enqueue()"));
+}
+
 void Queue::m_submit(const VkSubmitInfo *info, size_t infoCount,
-                     Fence const *fence) const noexcept(ExceptionsDisabled){
+                     Fence const *fence) const noexcept(ExceptionsDisabled) {
+  m_checkOwner();
+  std::lock_guard lock{m_mutex};
+  VK_CHECK_RESULT(m_parent.get().core<1, 0>().vkQueueSubmit(
+      m_queue, infoCount, info,
+      fence ? fence->operator VkFence_T *() : VK_NULL_HANDLE))
+}
 
-    VK_CHECK_RESULT(m_parent.get().core<1, 0>().vkQueueSubmit(
-        m_queue, infoCount, info,
-        fence ? fence->operator VkFence_T *() : VK_NULL_HANDLE))}
+void Queue::m_submit2(const VkSubmitInfo2 *info, size_t infoCount,
+                      Fence const *fence) const noexcept(ExceptionsDisabled) {
+  m_checkOwner();
+  std::lock_guard lock{m_mutex};
+  VK_CHECK_RESULT(m_parent.get().synchronization2().vkQueueSubmit2(
+      m_queue, infoCount, info,
+      fence ? fence->operator VkFence_T *() : VK_NULL_HANDLE))
+}
 
 QueueFamily const &Queue::family() const noexcept(ExceptionsDisabled) {
   return m_parent.get().physicalDevice().queueFamilies().at(m_familyIndex);
@@ -93,10 +93,14 @@ RenderPassCreateInfo::RenderPassCreateInfo(
   for (auto &subpass : m_subpasses) {
     subpass.pInputAttachments = descIter->inputAttachments.data();
     subpass.pColorAttachments = descIter->colorAttachments.data();
+    subpass.pResolveAttachments = descIter->resolveAttachments.empty()
+                                      ? nullptr
+                                      : descIter->resolveAttachments.data();
     subpass.pDepthStencilAttachment = descIter->depthAttachment.has_value()
                                           ? &descIter->depthAttachment.value()
                                           : nullptr;
     subpass.pPreserveAttachments = descIter->preserveAttachments.data();
+    ++descIter;
   }
 }
 void RenderPassCreateInfo::m_init(
@@ -0,0 +1,234 @@
+#include "vkw/ResourceTracker.hpp"
+#include "vkw/Buffer.hpp"
+#include "vkw/Image.hpp"
+
+namespace vkw {
+
+namespace {
+
+constexpr VkAccessFlags WriteAccessMask =
+    VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT |
+    VK_ACCESS_MEMORY_WRITE_BIT;
+
+} // namespace
+
+ResourceTracker::Dependency
+ResourceTracker::m_access(AccessState &state, VkImageLayout layout,
+                          VkPipelineStageFlags stage,
+                          VkAccessFlags access) noexcept {
+  // Layout is taken from the caller, not assumed undefined
+  if (state.layout == UnknownLayout)
+    state.layout = layout;
+
+  Dependency dependency{};
+  dependency.oldLayout = state.layout;
+
+  bool write = access & WriteAccessMask;
+  bool transition = layout != state.layout;
+
+  if (write || transition) {
+    // WAW, WAR or layout transition: wait for every access since last write.
+    dependency.srcStage = state.writeStage | state.readStages;
+    dependency.srcAccess = state.writeAccess;
+    dependency.needed = transition || dependency.srcStage != 0;
+
+    state.layout = layout;
+    state.writeStage = stage;
+    if (write) {
+      state.writeAccess = access & WriteAccessMask;
+      state.readStages = 0;
+      state.visibleStages = 0;
+      state.visibleAccess = 0;
+    } else {
+      // Layout transition is a write which is made visible to this access
+      state.writeAccess = 0;
+      state.readStages = stage;
+      state.visibleStages = stage;
+      state.visibleAccess = access;
+    }
+    return dependency;
+  }
+
+  state.readStages |= stage;
+
+  // RAW: only needed if the last write is not yet visible to this access
+  if (state.writeStage == 0 || ((state.visibleStages & stage) == stage &&
+                                (state.visibleAccess & access) == access))
+    return dependency;
+
+  dependency.needed = true;
+  dependency.srcStage = state.writeStage;
+  dependency.srcAccess = state.writeAccess;
+  state.visibleStages |= stage;
+  state.visibleAccess |= access;
+
+  return dependency;
+}
+
+void ResourceTracker::useBuffer(
+    BufferBase const &buffer, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  auto &state = m_buffers[buffer];
+  auto dependency = m_access(state, VK_IMAGE_LAYOUT_UNDEFINED, stage, access);
+
+  if (!dependency.needed)
+    return;
+
+  m_pending.srcStage |= dependency.srcStage;
+  m_pending.dstStage |= stage;
+
+  // Execution dependency is enough for WAR hazards
+  if (!dependency.srcAccess)
+    return;
+
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.pNext = nullptr;
+  barrier.srcAccessMask = dependency.srcAccess;
+  barrier.dstAccessMask = access;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = buffer;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+  m_pending.bufferBarriers.push_back(barrier);
+}
+
+void ResourceTracker::useImage(
+    ImageInterface const &image, VkImageSubresourceRange range,
+    VkImageLayout layout, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  auto &state = m_image_state(image);
+
+  if (range.levelCount == VK_REMAINING_MIP_LEVELS)
+    range.levelCount = state.mipLevels - range.baseMipLevel;
+  if (range.layerCount == VK_REMAINING_ARRAY_LAYERS)
+    range.layerCount = state.arrayLayers - range.baseArrayLayer;
+
+  if (range.baseMipLevel + range.levelCount > state.mipLevels ||
+      range.baseArrayLayer + range.layerCount > state.arrayLayers)
+    postError(Error("ResourceTracker: image subresource range is out of "
+                    "image bounds"));
+
+  auto subresource = [&state](uint32_t mip, uint32_t layer) -> AccessState & {
+    return state.subresources.at(mip * state.arrayLayers + layer);
+  };
+
+  auto const &first = subresource(range.baseMipLevel, range.baseArrayLayer);
+  bool uniform = true;
+  for (uint32_t mip = 0; mip < range.levelCount && uniform; ++mip)
+    for (uint32_t layer = 0; layer < range.layerCount && uniform; ++layer)
+      uniform = subresource(range.baseMipLevel + mip,
+                            range.baseArrayLayer + layer) == first;
+
+  VkImage handle = image;
+
+  // Common case: whole range shares the same history and needs at most one
+  // barrier.
+  if (uniform) {
+    Dependency dependency{};
+    for (uint32_t mip = 0; mip < range.levelCount; ++mip)
+      for (uint32_t layer = 0; layer < range.layerCount; ++layer)
+        dependency = m_access(subresource(range.baseMipLevel + mip,
+                                          range.baseArrayLayer + layer),
+                              layout, stage, access);
+    m_add_image_barrier(handle, range, dependency, layout, stage, access);
+    return;
+  }
+
+  // Otherwise merge runs of consecutive layers with equal dependency
+  for (uint32_t mip = range.baseMipLevel;
+       mip < range.baseMipLevel + range.levelCount; ++mip) {
+    VkImageSubresourceRange run = range;
+    run.baseMipLevel = mip;
+    run.levelCount = 1;
+    run.layerCount = 0;
+    Dependency runDependency{};
+
+    for (uint32_t layer = range.baseArrayLayer;
+         layer < range.baseArrayLayer + range.layerCount; ++layer) {
+      auto dependency =
+          m_access(subresource(mip, layer), layout, stage, access);
+      if (run.layerCount != 0 && dependency == runDependency) {
+        run.layerCount++;
+        continue;
+      }
+      if (run.layerCount != 0)
+        m_add_image_barrier(handle, run, runDependency, layout, stage, access);
+      run.baseArrayLayer = layer;
+      run.layerCount = 1;
+      runDependency = dependency;
+    }
+
+    if (run.layerCount != 0)
+      m_add_image_barrier(handle, run, runDependency, layout, stage, access);
+  }
+}
+
+void ResourceTracker::assumeImageLayout(
+    ImageInterface const &image,
+    VkImageLayout layout) noexcept(ExceptionsDisabled) {
+  for (auto &subresource : m_image_state(image).subresources)
+    subresource.layout = layout;
+}
+
+void ResourceTracker::clearPending() noexcept {
+  m_pending.srcStage = 0;
+  m_pending.dstStage = 0;
+  m_pending.imageBarriers.clear();
+  m_pending.bufferBarriers.clear();
+}
+
+void ResourceTracker::reset() noexcept {
+  clearPending();
+  m_buffers.clear();
+  m_images.clear();
+}
+
+ResourceTracker::ImageState &ResourceTracker::m_image_state(
+    ImageInterface const &image) noexcept(ExceptionsDisabled) {
+  auto found = m_images.find(image);
+  if (found != m_images.end())
+    return found->second;
+
+  auto completeRange = image.completeSubresourceRange();
+  ImageState state{};
+  state.mipLevels = completeRange.levelCount;
+  state.arrayLayers = completeRange.layerCount;
+  state.subresources.resize(state.mipLevels * state.arrayLayers);
+
+  return m_images.emplace(image, std::move(state)).first->second;
+}
+
+void ResourceTracker::m_add_image_barrier(
+    VkImage image, VkImageSubresourceRange range, Dependency const &dependency,
+    VkImageLayout layout, VkPipelineStageFlags stage,
+    VkAccessFlags access) noexcept(ExceptionsDisabled) {
+  if (!dependency.needed)
+    return;
+
+  m_pending.srcStage |= dependency.srcStage ? dependency.srcStage
+                                            : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  m_pending.dstStage |= stage;
+
+  // Execution dependency is enough for WAR hazards without layout change
+  if (!dependency.srcAccess && dependency.oldLayout == layout)
+    return;
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.pNext = nullptr;
+  barrier.srcAccessMask = dependency.srcAccess;
+  barrier.dstAccessMask = access;
+  barrier.oldLayout = dependency.oldLayout;
+  barrier.newLayout = layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = range;
+  m_pending.imageBarriers.push_back(barrier);
+}
+
+} // namespace vkw
@@ -13,8 +13,82 @@ VkSemaphoreCreateInfo fillCreateInfo() noexcept {
 
   return createInfo;
 }
+
+VkSemaphoreTypeCreateInfo fillTypeCreateInfo(uint64_t initialValue) noexcept {
+  VkSemaphoreTypeCreateInfo typeInfo{};
+  typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  typeInfo.pNext = nullptr;
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo.initialValue = initialValue;
+
+  return typeInfo;
+}
+
+VkSemaphoreCreateInfo
+fillCreateInfo(VkSemaphoreTypeCreateInfo const &typeInfo) noexcept {
+  VkSemaphoreCreateInfo createInfo = fillCreateInfo();
+  createInfo.pNext = &typeInfo;
+
+  return createInfo;
+}
+
+// Timeline semaphore creation itself is invalid without the feature, so it
+// is checked before the semaphore is created.
+Device const &checkTimelineSemaphore(Device const &device) noexcept(
+    ExceptionsDisabled) {
+  device.timelineSemaphore();
+  return device;
+}
+
 } // namespace
 Semaphore::Semaphore(Device const &device) noexcept(ExceptionsDisabled)
     : UniqueVulkanObject<VkSemaphore>(device, fillCreateInfo()) {}
 
-} // namespace vkw
\ No newline at end of file
+Semaphore::Semaphore(Device const &device,
+                     VkSemaphoreCreateInfo const &createInfo) noexcept(
+    ExceptionsDisabled)
+    : UniqueVulkanObject<VkSemaphore>(device, createInfo) {}
+
+TimelineSemaphore::TimelineSemaphore(
+    Device const &device, uint64_t initialValue) noexcept(ExceptionsDisabled)
+    : Semaphore(checkTimelineSemaphore(device),
+                fillCreateInfo(fillTypeCreateInfo(initialValue))) {}
+
+uint64_t TimelineSemaphore::value() const noexcept(ExceptionsDisabled) {
+  uint64_t ret;
+  VK_CHECK_RESULT(parent().timelineSemaphore().vkGetSemaphoreCounterValue(
+      parent(), handle(), &ret))
+  return ret;
+}
+
+void TimelineSemaphore::signal(uint64_t value) noexcept(ExceptionsDisabled) {
+  VkSemaphoreSignalInfo signalInfo{};
+  signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+  signalInfo.pNext = nullptr;
+  signalInfo.semaphore = handle();
+  signalInfo.value = value;
+  VK_CHECK_RESULT(
+      parent().timelineSemaphore().vkSignalSemaphore(parent(), &signalInfo))
+}
+
+bool TimelineSemaphore::wait(uint64_t value, uint64_t timeout) const
+    noexcept(ExceptionsDisabled) {
+  auto h = handle();
+  VkSemaphoreWaitInfo waitInfo{};
+  waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  waitInfo.pNext = nullptr;
+  waitInfo.flags = 0;
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &h;
+  waitInfo.pValues = &value;
+
+  auto result = parent().timelineSemaphore().vkWaitSemaphores(
+      parent(), &waitInfo, timeout);
+  if (result == VK_TIMEOUT)
+    return false;
+  VK_CHECK_RESULT(result)
+
+  return true;
+}
+
+} // namespace vkw
@@ -0,0 +1,424 @@
+#include "vkw/StateCache.hpp"
+#include "vkw/Device.hpp"
+
+#include <boost/container_hash/hash.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+
+namespace vkw {
+
+namespace {
+
+template <typename... Args>
+void hashTuple(size_t &seed, std::tuple<Args...> const &tuple) noexcept {
+  std::apply(
+      [&seed](auto const &...args) { (boost::hash_combine(seed, args), ...); },
+      tuple);
+}
+
+template <typename T, typename KeyT>
+bool equalArrays(T const *lhs, T const *rhs, uint32_t count,
+                 KeyT key) noexcept {
+  if (count == 0)
+    return true;
+  if (!lhs || !rhs)
+    return lhs == rhs;
+  return std::equal(lhs, lhs + count, rhs, [&key](T const &l, T const &r) {
+    return key(l) == key(r);
+  });
+}
+
+template <typename T, typename KeyT>
+void hashArray(size_t &seed, T const *values, uint32_t count,
+               KeyT key) noexcept {
+  boost::hash_combine(seed, count);
+  if (values)
+    std::for_each(values, values + count,
+                  [&](T const &value) { hashTuple(seed, key(value)); });
+}
+
+auto bindingKey(DescriptorSetLayoutBinding const &binding) noexcept {
+  return std::make_tuple(binding.binding(), binding.type(),
+                         binding.descriptorCount(),
+                         static_cast<VkDescriptorSetLayoutBinding const &>(
+                             binding)
+                             .stageFlags,
+                         binding.flags());
+}
+
+auto pushConstantKey(VkPushConstantRange const &range) noexcept {
+  return std::make_tuple(range.stageFlags, range.offset, range.size);
+}
+
+auto samplerKey(VkSamplerCreateInfo const &info) noexcept {
+  return std::make_tuple(
+      info.flags, info.magFilter, info.minFilter, info.mipmapMode,
+      info.addressModeU, info.addressModeV, info.addressModeW, info.mipLodBias,
+      info.anisotropyEnable, info.maxAnisotropy, info.compareEnable,
+      info.compareOp, info.minLod, info.maxLod, info.borderColor,
+      info.unnormalizedCoordinates);
+}
+
+auto attachmentKey(VkAttachmentDescription const &attachment) noexcept {
+  return std::make_tuple(attachment.flags, attachment.format,
+                         attachment.samples, attachment.loadOp,
+                         attachment.storeOp, attachment.stencilLoadOp,
+                         attachment.stencilStoreOp, attachment.initialLayout,
+                         attachment.finalLayout);
+}
+
+auto referenceKey(VkAttachmentReference const &reference) noexcept {
+  return std::make_tuple(reference.attachment, reference.layout);
+}
+
+auto preserveKey(uint32_t attachment) noexcept {
+  return std::make_tuple(attachment);
+}
+
+auto dependencyKey(VkSubpassDependency const &dependency) noexcept {
+  return std::make_tuple(dependency.srcSubpass, dependency.dstSubpass,
+                         dependency.srcStageMask, dependency.dstStageMask,
+                         dependency.srcAccessMask, dependency.dstAccessMask,
+                         dependency.dependencyFlags);
+}
+
+std::vector<VkSampler>
+immutableSamplers(DescriptorSetLayoutInfo const &info) noexcept(
+    ExceptionsDisabled) {
+  std::vector<VkSampler> samplers;
+  for (VkDescriptorSetLayoutBinding const &binding : info) {
+    if (!binding.pImmutableSamplers) {
+      // Tells bindings with and without immutable samplers apart
+      samplers.push_back(VK_NULL_HANDLE);
+      continue;
+    }
+    std::copy(binding.pImmutableSamplers,
+              binding.pImmutableSamplers + binding.descriptorCount,
+              std::back_inserter(samplers));
+  }
+  return samplers;
+}
+
+size_t hashSetLayout(DescriptorSetLayoutInfo const &info,
+                     std::span<const VkSampler> samplers) noexcept {
+  size_t seed = info.flags();
+  for (auto const &binding : info)
+    hashTuple(seed, bindingKey(binding));
+  for (auto sampler : samplers)
+    boost::hash_combine(seed, DeletionQueue::toRaw(sampler));
+  return seed;
+}
+
+size_t hashRenderPass(VkRenderPassCreateInfo const &info) noexcept {
+  size_t seed = info.flags;
+  hashArray(seed, info.pAttachments, info.attachmentCount, attachmentKey);
+  std::for_each(
+      info.pSubpasses, info.pSubpasses + info.subpassCount,
+      [&seed](VkSubpassDescription const &subpass) {
+        boost::hash_combine(seed, subpass.flags);
+        boost::hash_combine(seed, subpass.pipelineBindPoint);
+        hashArray(seed, subpass.pInputAttachments,
+                  subpass.inputAttachmentCount, referenceKey);
+        hashArray(seed, subpass.pColorAttachments,
+                  subpass.colorAttachmentCount, referenceKey);
+        hashArray(seed, subpass.pResolveAttachments,
+                  subpass.colorAttachmentCount, referenceKey);
+        hashArray(seed, subpass.pDepthStencilAttachment,
+                  subpass.pDepthStencilAttachment ? 1 : 0, referenceKey);
+        hashArray(seed, subpass.pPreserveAttachments,
+                  subpass.preserveAttachmentCount, preserveKey);
+      });
+  hashArray(seed, info.pDependencies, info.dependencyCount, dependencyKey);
+  return seed;
+}
+
+bool equalRenderPasses(VkRenderPassCreateInfo const &lhs,
+                       VkRenderPassCreateInfo const &rhs) noexcept {
+  if (lhs.flags != rhs.flags || lhs.attachmentCount != rhs.attachmentCount ||
+      lhs.subpassCount != rhs.subpassCount ||
+      lhs.dependencyCount != rhs.dependencyCount)
+    return false;
+
+  auto equalSubpasses = [](VkSubpassDescription const &l,
+                           VkSubpassDescription const &r) {
+    return l.flags == r.flags && l.pipelineBindPoint == r.pipelineBindPoint &&
+           l.inputAttachmentCount == r.inputAttachmentCount &&
+           l.colorAttachmentCount == r.colorAttachmentCount &&
+           l.preserveAttachmentCount == r.preserveAttachmentCount &&
+           equalArrays(l.pInputAttachments, r.pInputAttachments,
+                       l.inputAttachmentCount, referenceKey) &&
+           equalArrays(l.pColorAttachments, r.pColorAttachments,
+                       l.colorAttachmentCount, referenceKey) &&
+           equalArrays(l.pResolveAttachments, r.pResolveAttachments,
+                       l.colorAttachmentCount, referenceKey) &&
+           equalArrays(l.pDepthStencilAttachment, r.pDepthStencilAttachment,
+                       1, referenceKey) &&
+           equalArrays(l.pPreserveAttachments, r.pPreserveAttachments,
+                       l.preserveAttachmentCount, preserveKey);
+  };
+
+  return equalArrays(lhs.pAttachments, rhs.pAttachments, lhs.attachmentCount,
+                     attachmentKey) &&
+         std::equal(lhs.pSubpasses, lhs.pSubpasses + lhs.subpassCount,
+                    rhs.pSubpasses, equalSubpasses) &&
+         equalArrays(lhs.pDependencies, rhs.pDependencies,
+                     lhs.dependencyCount, dependencyKey);
+}
+
+using OwnedAttachments = std::vector<std::unique_ptr<AttachmentDescription>>;
+
+OwnedAttachments
+copyAttachments(VkRenderPassCreateInfo const &info) noexcept(
+    ExceptionsDisabled) {
+  OwnedAttachments attachments;
+  std::for_each(info.pAttachments, info.pAttachments + info.attachmentCount,
+                [&attachments](VkAttachmentDescription const &a) {
+                  attachments.emplace_back(
+                      std::make_unique<AttachmentDescription>(
+                          a.format, a.samples, a.loadOp, a.storeOp,
+                          a.stencilLoadOp, a.stencilStoreOp, a.initialLayout,
+                          a.finalLayout, a.flags));
+                });
+  return attachments;
+}
+
+// Same create info, but built from the owned attachment copies. Subpasses
+// and dependencies are only needed to build it.
+RenderPassCreateInfo
+ownedCreateInfo(VkRenderPassCreateInfo const &info,
+                OwnedAttachments const &attachments) noexcept(
+    ExceptionsDisabled) {
+  std::vector<SubpassDescription> subpasses(info.subpassCount);
+  for (uint32_t i = 0; i < info.subpassCount; ++i) {
+    auto const &raw = info.pSubpasses[i];
+    auto &subpass = subpasses[i];
+    subpass.flags = raw.flags;
+    std::for_each(raw.pInputAttachments,
+                  raw.pInputAttachments + raw.inputAttachmentCount,
+                  [&](VkAttachmentReference const &ref) {
+                    subpass.addInputAttachment(*attachments[ref.attachment],
+                                               ref.layout);
+                  });
+    std::for_each(raw.pColorAttachments,
+                  raw.pColorAttachments + raw.colorAttachmentCount,
+                  [&](VkAttachmentReference const &ref) {
+                    subpass.addColorAttachment(*attachments[ref.attachment],
+                                               ref.layout);
+                  });
+    if (raw.pResolveAttachments)
+      std::for_each(raw.pResolveAttachments,
+                    raw.pResolveAttachments + raw.colorAttachmentCount,
+                    [&](VkAttachmentReference const &ref) {
+                      subpass.addResolveAttachment(
+                          *attachments[ref.attachment], ref.layout);
+                    });
+    if (auto *ref = raw.pDepthStencilAttachment)
+      subpass.addDepthAttachment(*attachments[ref->attachment], ref->layout);
+    std::for_each(raw.pPreserveAttachments,
+                  raw.pPreserveAttachments + raw.preserveAttachmentCount,
+                  [&](uint32_t index) {
+                    subpass.addPreserveAttachment(*attachments[index]);
+                  });
+  }
+
+  std::vector<StrongReference<SubpassDescription const>> subpassRefs(
+      subpasses.begin(), subpasses.end());
+
+  std::vector<SubpassDependency> dependencies(info.dependencyCount);
+  for (uint32_t i = 0; i < info.dependencyCount; ++i) {
+    auto const &raw = info.pDependencies[i];
+    auto &dependency = dependencies[i];
+    if (raw.srcSubpass != VK_SUBPASS_EXTERNAL)
+      dependency.setSrcSubpass(subpasses[raw.srcSubpass]);
+    if (raw.dstSubpass != VK_SUBPASS_EXTERNAL)
+      dependency.setDstSubpass(subpasses[raw.dstSubpass]);
+    dependency.srcStageMask = raw.srcStageMask;
+    dependency.dstStageMask = raw.dstStageMask;
+    dependency.srcAccessMask = raw.srcAccessMask;
+    dependency.dstAccessMask = raw.dstAccessMask;
+    dependency.dependencyFlags = raw.dependencyFlags;
+  }
+
+  std::vector<std::reference_wrapper<AttachmentDescription const>>
+      attachmentRefs;
+  std::transform(attachments.begin(), attachments.end(),
+                 std::back_inserter(attachmentRefs),
+                 [](auto const &attachment) { return std::cref(*attachment); });
+
+  return RenderPassCreateInfo{attachmentRefs, subpassRefs, dependencies,
+                              info.flags};
+}
+
+// Owns copies of attachment descriptions of its create info, so cached
+// render pass doesn't keep referencing objects of whoever requested it.
+// Copies are a base: they must outlive the render pass.
+struct AttachmentsHolder {
+  OwnedAttachments attachments;
+};
+
+class CachedRenderPass : private AttachmentsHolder, public RenderPass {
+public:
+  CachedRenderPass(Device const &device,
+                   VkRenderPassCreateInfo const &info) noexcept(
+      ExceptionsDisabled)
+      : AttachmentsHolder{copyAttachments(info)},
+        RenderPass(device, ownedCreateInfo(info, attachments)) {}
+};
+
+} // namespace
+
+StateCache::StateCache(Device const &device) noexcept : m_device(device) {}
+
+std::shared_ptr<DescriptorSetLayout const>
+StateCache::m_descriptorSetLayout(
+    DescriptorSetLayoutInfo const &info,
+    std::function<std::shared_ptr<DescriptorSetLayout>()> const
+        &create) noexcept(ExceptionsDisabled) {
+  auto samplers = immutableSamplers(info);
+  auto hash = hashSetLayout(info, samplers);
+
+  std::lock_guard lock{m_mutex};
+  auto [first, last] = m_setLayouts.equal_range(hash);
+  for (auto found = first; found != last; ++found) {
+    auto &node = found->second;
+    if (static_cast<DescriptorSetLayoutInfo const &>(*node.layout) == info &&
+        node.immutableSamplers == samplers) {
+      ++m_statistics.hits;
+      return node.layout;
+    }
+  }
+
+  ++m_statistics.misses;
+  std::shared_ptr<DescriptorSetLayout const> layout = create();
+  m_setLayouts.emplace(hash, SetLayoutNode{layout, std::move(samplers)});
+  return layout;
+}
+
+std::shared_ptr<PipelineLayout const> StateCache::pipelineLayout(
+    std::span<const std::shared_ptr<DescriptorSetLayout const>> setLayouts,
+    std::span<const VkPushConstantRange> pushConstants,
+    VkPipelineLayoutCreateFlags flags) noexcept(ExceptionsDisabled) {
+  size_t hash = flags;
+  for (auto const &setLayout : setLayouts) {
+    VkDescriptorSetLayout rawLayout = *setLayout;
+    boost::hash_combine(hash, DeletionQueue::toRaw(rawLayout));
+  }
+  hashArray(hash, pushConstants.data(), pushConstants.size(),
+            pushConstantKey);
+
+  auto sameLayouts = [setLayouts](PipelineLayoutNode const &node) {
+    return std::equal(setLayouts.begin(), setLayouts.end(),
+                      node.setLayouts.begin(), node.setLayouts.end(),
+                      [](auto const &lhs, auto const &rhs) {
+                        return lhs.get() == rhs.get();
+                      });
+  };
+
+  std::lock_guard lock{m_mutex};
+  auto [first, last] = m_pipelineLayouts.equal_range(hash);
+  for (auto found = first; found != last; ++found) {
+    auto &node = found->second;
+    if (node.layout->info().flags == flags && sameLayouts(node) &&
+        node.pushConstants.size() == pushConstants.size() &&
+        equalArrays(node.pushConstants.data(), pushConstants.data(),
+                    pushConstants.size(), pushConstantKey)) {
+      ++m_statistics.hits;
+      return node.layout;
+    }
+  }
+
+  ++m_statistics.misses;
+  boost::container::small_vector<
+      std::reference_wrapper<DescriptorSetLayout const>, 4>
+      layoutRefs;
+  std::transform(setLayouts.begin(), setLayouts.end(),
+                 std::back_inserter(layoutRefs),
+                 [](auto const &setLayout) { return std::cref(*setLayout); });
+  auto layout = std::make_shared<PipelineLayout>(m_device.get(), layoutRefs,
+                                                 pushConstants, flags);
+  m_pipelineLayouts.emplace(
+      hash,
+      PipelineLayoutNode{{setLayouts.begin(), setLayouts.end()},
+                         {pushConstants.begin(), pushConstants.end()},
+                         layout});
+  return layout;
+}
+
+std::shared_ptr<Sampler const> StateCache::sampler(
+    VkSamplerCreateInfo const &createInfo) noexcept(ExceptionsDisabled) {
+  if (createInfo.pNext)
+    postError(Error("StateCache: samplers with pNext chains can't be "
+                    "interned"));
+
+  size_t hash = 0;
+  hashTuple(hash, samplerKey(createInfo));
+
+  std::lock_guard lock{m_mutex};
+  auto [first, last] = m_samplers.equal_range(hash);
+  for (auto found = first; found != last; ++found)
+    if (samplerKey(found->second->info()) == samplerKey(createInfo)) {
+      ++m_statistics.hits;
+      return found->second;
+    }
+
+  ++m_statistics.misses;
+  auto sampler = std::make_shared<Sampler>(m_device.get(), createInfo);
+  m_samplers.emplace(hash, sampler);
+  return sampler;
+}
+
+std::shared_ptr<RenderPass const> StateCache::renderPass(
+    RenderPassCreateInfo const &createInfo) noexcept(ExceptionsDisabled) {
+  auto hash = hashRenderPass(createInfo.info());
+
+  std::lock_guard lock{m_mutex};
+  auto [first, last] = m_renderPasses.equal_range(hash);
+  for (auto found = first; found != last; ++found)
+    if (equalRenderPasses(found->second->info(), createInfo.info())) {
+      ++m_statistics.hits;
+      return found->second;
+    }
+
+  ++m_statistics.misses;
+  std::shared_ptr<RenderPass const> renderPass =
+      std::make_shared<CachedRenderPass>(m_device.get(), createInfo.info());
+  m_renderPasses.emplace(hash, renderPass);
+  return renderPass;
+}
+
+size_t StateCache::trim() noexcept {
+  auto unused = [](auto const &entry) {
+    if constexpr (requires { entry.second.layout; })
+      return entry.second.layout.use_count() == 1;
+    else
+      return entry.second.use_count() == 1;
+  };
+
+  std::lock_guard lock{m_mutex};
+  // Pipeline layouts go first: they hold their set layouts
+  size_t dropped = std::erase_if(m_pipelineLayouts, unused);
+  dropped += std::erase_if(m_setLayouts, unused);
+  dropped += std::erase_if(m_samplers, unused);
+  dropped += std::erase_if(m_renderPasses, unused);
+  return dropped;
+}
+
+size_t StateCache::size() const noexcept {
+  std::lock_guard lock{m_mutex};
+  return m_setLayouts.size() + m_pipelineLayouts.size() + m_samplers.size() +
+         m_renderPasses.size();
+}
+
+StateCache::Statistics StateCache::statistics() const noexcept {
+  std::lock_guard lock{m_mutex};
+  return m_statistics;
+}
+
+void StateCache::resetStatistics() noexcept {
+  std::lock_guard lock{m_mutex};
+  m_statistics = {};
+}
+
+} // namespace vkw
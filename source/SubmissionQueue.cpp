@@ -0,0 +1,151 @@
+#include "vkw/SubmissionQueue.hpp"
+#include "vkw/Fence.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace vkw {
+
+SubmissionQueue::SubmissionQueue(Queue const &queue,
+                                 size_t capacity) noexcept(ExceptionsDisabled)
+    : m_queue(queue) {
+  capacity = std::bit_ceil(std::max<size_t>(capacity, 2));
+  m_cells = std::make_unique<Cell[]>(capacity);
+  m_mask = capacity - 1;
+  for (size_t i = 0; i < capacity; ++i)
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+
+  // Claimed for the constructing thread until the submission thread exists
+  auto unowned = std::thread::id{};
+  if (!queue.m_owner.compare_exchange_strong(unowned,
+                                             std::this_thread::get_id(),
+                                             std::memory_order_acq_rel))
+    postError(Error("SubmissionQueue: queue is already owned by another "
+                    "SubmissionQueue"));
+
+  m_thread = std::thread([this]() { m_run(); });
+  queue.m_owner.store(m_thread.get_id(), std::memory_order_release);
+}
+
+SubmissionQueue::~SubmissionQueue() {
+  m_stop.store(true, std::memory_order_release);
+  m_wakeUp.fetch_add(1, std::memory_order_release);
+  m_wakeUp.notify_one();
+  m_thread.join();
+  m_queue.get().m_owner.store(std::thread::id{}, std::memory_order_release);
+}
+
+void SubmissionQueue::enqueue(SubmitInfo info, Fence const *fence) noexcept(
+    ExceptionsDisabled) {
+  auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &m_cells[pos & m_mask];
+    auto sequence = cell->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+    if (diff == 0) {
+      if (m_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed))
+        break;
+    } else {
+      // Ring is full: let the submission thread run
+      if (diff < 0)
+        std::this_thread::yield();
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->entry.emplace(Entry{std::move(info), fence});
+  cell->sequence.store(pos + 1, std::memory_order_release);
+
+  m_wakeUp.fetch_add(1, std::memory_order_release);
+  m_wakeUp.notify_one();
+}
+
+void SubmissionQueue::flush() noexcept(ExceptionsDisabled) {
+  auto target = m_enqueuePos.load(std::memory_order_acquire);
+  for (;;) {
+    auto submitted = m_submitted.load(std::memory_order_acquire);
+    if (submitted >= target)
+      break;
+    m_submitted.wait(submitted, std::memory_order_acquire);
+  }
+
+  std::exception_ptr error;
+  {
+    std::lock_guard lock{m_errorMutex};
+    std::swap(error, m_error);
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void SubmissionQueue::m_run() noexcept {
+  boost::container::small_vector<Entry, 8> batch;
+
+  for (;;) {
+    // Read before draining so that a publish racing with an empty ring
+    // changes the value and the wait below returns immediately.
+    auto wakeUp = m_wakeUp.load(std::memory_order_acquire);
+
+    while (auto entry = m_dequeue()) {
+      bool fenced = entry->fence != nullptr;
+      batch.emplace_back(std::move(*entry));
+      if (fenced)
+        m_submit(batch);
+    }
+
+    if (!batch.empty()) {
+      m_submit(batch);
+      continue;
+    }
+
+    if (m_stop.load(std::memory_order_acquire))
+      return;
+
+    m_wakeUp.wait(wakeUp, std::memory_order_acquire);
+  }
+}
+
+std::optional<SubmissionQueue::Entry> SubmissionQueue::m_dequeue() noexcept {
+  auto &cell = m_cells[m_dequeuePos & m_mask];
+  if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+    return std::nullopt;
+
+  std::optional<Entry> entry = std::move(cell.entry);
+  cell.entry.reset();
+  cell.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+  ++m_dequeuePos;
+
+  return entry;
+}
+
+void SubmissionQueue::m_submit(
+    boost::container::small_vector<Entry, 8> &batch) noexcept {
+  boost::container::small_vector<std::reference_wrapper<SubmitInfo const>, 8>
+      infos;
+  for (auto const &entry : batch)
+    infos.emplace_back(entry.info);
+
+  // Only the last entry of a batch may carry a fence
+  auto const *fence = batch.back().fence;
+
+  try {
+    if (fence)
+      m_queue.get().submit(infos, *fence);
+    else
+      m_queue.get().submit(infos);
+  } catch (...) {
+    std::lock_guard lock{m_errorMutex};
+    if (!m_error)
+      m_error = std::current_exception();
+  }
+
+  m_submitCalls.fetch_add(1, std::memory_order_relaxed);
+  m_submitted.fetch_add(batch.size(), std::memory_order_release);
+  m_submitted.notify_all();
+
+  batch.clear();
+}
+
+} // namespace vkw
@@ -0,0 +1,103 @@
+#include "vkw/ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace vkw {
+
+namespace {
+
+thread_local ThreadPool const *currentPool = nullptr;
+thread_local uint32_t currentWorker = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(uint32_t workerCount) {
+  workerCount = std::max(workerCount, 1u);
+
+  m_workers.reserve(workerCount);
+  for (uint32_t i = 0; i < workerCount; ++i)
+    m_workers.emplace_back(std::make_unique<Worker>());
+
+  // Start threads only after all queues exist, they may steal right away
+  for (uint32_t i = 0; i < workerCount; ++i)
+    m_workers[i]->thread = std::thread([this, i]() { m_run(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{m_sleepMutex};
+    m_stop = true;
+  }
+  m_wakeUp.notify_all();
+
+  for (auto &worker : m_workers)
+    worker->thread.join();
+}
+
+void ThreadPool::submit(Task task) {
+  auto index = currentPool == this
+                   ? currentWorker
+                   : m_nextWorker.fetch_add(1, std::memory_order_relaxed) %
+                         m_workers.size();
+
+  // Count the task before it becomes visible so that m_pending never
+  // underflows when a worker picks it up immediately.
+  {
+    std::lock_guard lock{m_sleepMutex};
+    m_pending++;
+  }
+
+  {
+    auto &worker = *m_workers[index];
+    std::lock_guard lock{worker.mutex};
+    worker.tasks.push_back(std::move(task));
+  }
+
+  m_wakeUp.notify_one();
+}
+
+void ThreadPool::m_run(uint32_t index) {
+  currentPool = this;
+  currentWorker = index;
+
+  for (;;) {
+    Task task;
+    if (m_pop(index, task) || m_steal(index, task)) {
+      m_pending--;
+      task(index);
+      continue;
+    }
+
+    std::unique_lock lock{m_sleepMutex};
+    m_wakeUp.wait(lock, [this]() { return m_stop || m_pending != 0; });
+    if (m_stop && m_pending == 0)
+      return;
+  }
+}
+
+bool ThreadPool::m_pop(uint32_t index, Task &task) {
+  auto &worker = *m_workers[index];
+  std::lock_guard lock{worker.mutex};
+  if (worker.tasks.empty())
+    return false;
+
+  task = std::move(worker.tasks.back());
+  worker.tasks.pop_back();
+  return true;
+}
+
+bool ThreadPool::m_steal(uint32_t index, Task &task) {
+  for (size_t offset = 1; offset < m_workers.size(); ++offset) {
+    auto &victim = *m_workers[(index + offset) % m_workers.size()];
+    std::unique_lock lock{victim.mutex, std::try_to_lock};
+    if (!lock.owns_lock() || victim.tasks.empty())
+      continue;
+
+    task = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+} // namespace vkw